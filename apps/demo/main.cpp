@@ -78,7 +78,6 @@ public:
     struct RainDropData {
         glm::vec3 velocity = { 0.f, 0.f, 0.f };
         float mass = 1.0f;
-        bool initialized = false;
     };
 
     // City bounds
@@ -99,7 +98,7 @@ public:
         const Engine::Component::Drawable3D& drawable,
         uint32_t maxDrops = 20000)
         : m_Renderer(renderer)
-        , m_Rng(std::random_device{}())
+        , m_Rng(RandomSeed())
     {
         // Define city bounds for rain spawn area
         m_Bounds = BBox{ vec3{0}, vec3{0} };
@@ -115,6 +114,19 @@ public:
             Engine::Particle::LifetimeMethod::RESPAWN
         );
 
+        // Per-drop randomization happens on the serial spawn path, the update runs in parallel
+        m_ParticleSystem->OnSpawn([this](RainDropData& particle,
+            Engine::ParticleSystem<RainDropData>::InstanceData& instance) {
+                std::uniform_real_distribution<float> vyDist(-45.f, -30.f);
+                std::uniform_real_distribution<float> massDist(0.1f, 1.1f);
+
+                particle.velocity = { 0.f, vyDist(m_Rng), 0.f };
+                particle.mass = massDist(m_Rng);
+
+                instance.transform.scale = glm::vec3(0.3f);
+                instance.transform.rotation = glm::quat(1, 0, 0, 0);
+            });
+
         Log::info("RainParticles: Initialized with {} max particles", maxDrops);
     }
 
@@ -129,19 +141,6 @@ public:
         m_ParticleSystem->Update(dt, [this](float deltaTime, RainDropData& particle,
             Engine::ParticleSystem<RainDropData>::InstanceData& instance) {
 
-                // Initialize particle data on first update after spawn
-                if (!particle.initialized) {
-                    std::uniform_real_distribution<float> vyDist(-45.f, -30.f);
-                    std::uniform_real_distribution<float> massDist(0.1f, 1.1f);
-
-                    particle.velocity = { 0.f, vyDist(m_Rng), 0.f };
-                    particle.mass = massDist(m_Rng);
-                    particle.initialized = true;
-
-                    instance.transform.scale = glm::vec3(0.3f);
-                    instance.transform.rotation = glm::quat(1, 0, 0, 0);
-                }
-
                 auto& pos = instance.transform.position;
 
                 // ===== Physics Simulation =====
@@ -195,12 +194,7 @@ public:
                     instance.transform.rotation = pitchRotation * yawRotation;
                 }
 
-                // ===== Calculate Model Matrix =====
-                glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), instance.transform.position);
-                glm::mat4 rotationMatrix = glm::mat4_cast(instance.transform.rotation);
-                glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), instance.transform.scale);
-
-                instance.transform.modelMatrix = translationMatrix * rotationMatrix * scaleMatrix;
+                // Model matrix gets composed by the particle system for all particles at once
 
                 // Particle respawning handled by checking ground level
                 if (instance.transform.position.y < this->GROUND_LEVEL) {
@@ -273,8 +267,7 @@ public:
 
         hasExploded = true;
 
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
+        static std::mt19937 gen(RandomSeed());
         std::uniform_real_distribution<float> velDist(-8.0f, 8.0f); // Random XZ velocity
         std::uniform_real_distribution<float> upDist(5.0f, 15.0f); // Strong upward velocity
         std::uniform_real_distribution<float> lifeDist(1.5f, 4.0f); // Particle lifetime
@@ -356,8 +349,7 @@ public:
 private:
     // Helper: spawn a batch of fountain particles
     void spawnFountainBatch() {
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
+        static std::mt19937 gen(RandomSeed());
         std::uniform_real_distribution<float> velDist(-3.0f, 3.0f); // Small random XZ spread
         std::uniform_real_distribution<float> upDist(8.0f, 12.0f); // Upward velocity for fountain
         std::uniform_real_distribution<float> lifeDist(2.0f, 3.5f); // Particle lifetime
@@ -434,8 +426,7 @@ public:
         if (models.empty()) {
             return nullptr;
         }
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
+        static std::mt19937 gen(RandomSeed());
         std::uniform_int_distribution<> dis(0, models.size() - 1);
         int randomIndex = dis(gen);
         return models[randomIndex];
@@ -499,8 +490,7 @@ public:
                     entity_id e = ecs->Instantiate(city_parent, Component::Transform(), bigModel1);
                     auto ref = ecs->GetTransformRef(e);
                     ref.SetPosition({ worldX, 0.0f, worldZ });
-                    static std::random_device rd;
-                    static std::mt19937 gen(rd());
+                    static std::mt19937 gen(RandomSeed());
                     std::uniform_int_distribution<> dis(2, 3);
                     // Optionally scale the model to roughly cover 3x3 tiles
                     ref.SetScale({ tileSize / 1.0,dis(gen),tileSize / 1.0 });
@@ -534,8 +524,7 @@ public:
                     auto ref1 = ecs->GetTransformRef(i);
 
                     // Generate random rotation around Y axis (0-360 degrees)
-                    static std::random_device rd;
-                    static std::mt19937 gen(rd());
+                    static std::mt19937 gen(RandomSeed());
                     std::uniform_real_distribution<float> rotDist(0.0f, 2.0f * 3.14159f); // 0 to 2π radians
                     float randomRotation = rotDist(gen);
 
@@ -1588,7 +1577,7 @@ extern "C" {
         for (entity_id child : ChildrenRange(ecs, entity)) {
 
             if (ecs->HasComponent<Name>(child)) {
-                const auto& name = ecs->GetComponent<Name>(child).name;
+                const auto& name = ecs->GetComponent<Name>(child).str();
 
                 if (name.starts_with("Wheel_FR")) {
                     wheel_FR = child;
@@ -1621,8 +1610,11 @@ extern "C" {
         Ref<ResourceSystem> rs = app.GetResourceSystem();
         auto renderer = app.GetRenderer();
 
-        renderer->LoadSkybox(vfs->Resolve(module_name, "assets/skybox_clouds_adjusted"));
-        renderer->SetClearColor(Color{ 0.0, 0.0, 0.0, 1.0 });
+        // No renderer when running headless
+        if (renderer) {
+            renderer->LoadSkybox(vfs->Resolve(module_name, "assets/skybox_clouds_adjusted"));
+            renderer->SetClearColor(Color{ 0.0, 0.0, 0.0, 1.0 });
+        }
 
         entity_id sun = ecs->CreateEntity3D(null, Transform(), "Sun");
         Light sun_light = Light::Directional(Color(81, 81, 176).to_vec4(), 0.2f, { -0.4, -1.0, -0.4 });
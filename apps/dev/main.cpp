@@ -17,6 +17,22 @@ entity_id entity_model = null, camera = null, ring = null, sun = null;
 Camera* camComp = nullptr;
 Ref<ECS> ecs;
 Ref<VFS> vfs;
+u32 cameraLatch = 0;
+
+// Orbit around the origin, the cursor swings it further. Runs on the frame's input in scene_update and again on
+// the freshest input from the frame pacer's late latch, posing the camera through its Transform only
+float orbitAngle = 0.0f;
+void place_camera(const InputState& input) {
+    constexpr float radius = 25.0f;
+    constexpr float CURSOR_SWING = 0.002f; // radians per pixel
+    const float angle = orbitAngle + (float)input.cursorX * CURSOR_SWING;
+
+    auto trans = ecs->GetTransformRef(camera);
+    const vec3 position = vec3(radius * cos(angle), 1, radius * sin(angle));
+    trans.SetPosition(position);
+    trans.SetRotation(glm::quatLookAt(glm::normalize(-position), vec3(0, 1, 0)));
+    camComp->LookAt(position);
+}
 
 void scene_init(scene_data_t scene_data) {
     // Scene preamble
@@ -27,13 +43,19 @@ void scene_init(scene_data_t scene_data) {
     auto renderer = app.GetRenderer();
     auto module_name = string(scene_data.module_name);
 
-    renderer->LoadSkybox(vfs->Resolve(module_name, "assets/skybox_clouds_adjusted"));
+    // No renderer when running headless
+    if (renderer) renderer->LoadSkybox(vfs->Resolve(module_name, "assets/skybox_clouds_adjusted"));
 
     // Setup camera
     camera = ecs->CreateEntity3D(null, Component::Transform(), "Main Camera");
     auto& cam = ecs->AddComponent<Camera>(camera, Camera::Perspective());
     cam.isMain = true;
     camComp = &cam;
+    if (!app.IsHeadless()) {
+        FramePacer& pacer = app.GetFramePacer();
+        pacer.SetLatchedCamera(camera);
+        cameraLatch = pacer.AddLateLatch([]() { place_camera(Application::Get().GetInput().GetLiveState()); });
+    }
     // Light camera_light = Light::Spot(12.5, 17.5, 50, vec3{ 1 }, 1);
     // ecs->AddComponent<Light>(camera, camera_light);
 
@@ -93,16 +115,9 @@ void scene_update_fixed(float deltaTime) {
 
 void scene_update(float deltaTime) {
     // Rotate camera around origin
-    static float angle = 0.0f;
     constexpr float ROTATION_SPEED = 0.25f;
-    angle += ROTATION_SPEED * deltaTime;
-
-    constexpr float radius = 25.0f;
-    auto trans = ecs->GetTransformRef(camera);
-    float camX = radius * cos(angle);
-    float camZ = radius * sin(angle);
-    trans.SetPosition(vec3(camX, 1, camZ));
-    camComp->LookAt(trans.GetPosition());
+    orbitAngle += ROTATION_SPEED * deltaTime;
+    place_camera(Application::Get().GetInput().GetState());
 }
 
 void scene_render() {
@@ -110,6 +125,11 @@ void scene_render() {
 }
 
 void scene_shutdown() {
+    Application& app = Application::Get();
+    if (!app.IsHeadless()) {
+        app.GetFramePacer().RemoveLateLatch(cameraLatch);
+        app.GetFramePacer().SetLatchedCamera(null);
+    }
     ecs->DestroyEntity(camera);
     ecs->DestroyEntity(sun);
     ecs->DestroyEntity(entity_model, true);
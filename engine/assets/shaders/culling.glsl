@@ -7,29 +7,43 @@ struct BSphere {
 };
 
 struct InstanceData {
-    mat4 model;
+    vec4 model[3];      // row-major 3x4 affine, bottom row is always (0, 0, 0, 1)
     BSphere sphere;     // xyz = center, w = radius
 };
 
 layout(std430, binding = 0) readonly buffer Instances { InstanceData instances[]; };
-layout(std430, binding = 1) writeonly buffer Visible { uint visibleIndices[]; };
-layout(std140, binding = 3) uniform FrustumPlanes { vec4 planes[6]; };
+#define MAX_VIEWS 8 // Renderer::MAX_VIEWS
+
+layout(std430, binding = 1) writeonly buffer Visible { uint visibleMasks[]; }; // bit v set when inside view v
+layout(std140, binding = 3) uniform FrustumPlanes { vec4 planes[6 * MAX_VIEWS]; };
+
+uniform uint uViewCount;
+uniform uint uInstanceCount; // the table has room to grow past it
 
 void main() {
     uint id = gl_GlobalInvocationID.x;
-    if (id >= instances.length()) return;
+    if (id >= uInstanceCount) return;
 
-    mat4 model = instances[id].model;
+    vec4 r0 = instances[id].model[0];
+    vec4 r1 = instances[id].model[1];
+    vec4 r2 = instances[id].model[2];
     BSphere s = instances[id].sphere;
-    vec3 center = vec3(model * vec4(s.center, 1.0));
-    float scale = max(max(length(model[0].xyz), length(model[1].xyz)), length(model[2].xyz));
+    vec4 p = vec4(s.center, 1.0);
+    vec3 center = vec3(dot(r0, p), dot(r1, p), dot(r2, p));
+    // Basis vectors are the columns of the 3x3 part
+    float scale = max(max(length(vec3(r0.x, r1.x, r2.x)), length(vec3(r0.y, r1.y, r2.y))), length(vec3(r0.z, r1.z, r2.z)));
     float radius = s.radius * scale;
 
-    uint inside = 1;
-    for (int i = 0; i < 6; ++i) {
-        float d = dot(planes[i].xyz, center) + planes[i].w;
-        if (d < -radius) { inside = 0; break; }
+    uint mask = 0u;
+    for (uint v = 0u; v < uViewCount; ++v) {
+        bool inside = true;
+        for (uint i = 0u; i < 6u; ++i) {
+            vec4 plane = planes[v * 6u + i];
+            float d = dot(plane.xyz, center) + plane.w;
+            if (d < -radius) { inside = false; break; }
+        }
+        if (inside) mask |= 1u << v;
     }
 
-    visibleIndices[id] = inside;
+    visibleMasks[id] = mask;
 }
@@ -6,7 +6,27 @@ in VS_OUT {
     vec2 TexCoord;
 } fs_in;
 
-out vec4 FragColor;
+// ==== Manual #include because OpenGL is being a little bitch
+// Weighted blended OIT, main framebuffer attachments 1 (accumulation) and 2 (revealage)
+layout(location = 0) out vec4 FragColor;
+layout(location = 1) out vec4 OITAccum;
+layout(location = 2) out float OITRevealage;
+
+uniform bool uOITPass;
+
+void WriteColor(vec4 color) {
+    if (!uOITPass) {
+        FragColor = color;
+        return;
+    }
+
+    // McGuire & Bavoil weight, favors opaque-ish fragments close to the camera
+    float alpha = clamp(color.a, 0.0, 1.0);
+    float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+    OITAccum = vec4(color.rgb * alpha, alpha) * weight;
+    OITRevealage = alpha;
+}
+// ==== End of manual include
 
 // Material properties (colors only, no textures)
 struct MaterialProperties {
@@ -23,5 +43,5 @@ void main() {
     vec4 texDiffuse = texture(uMaterial.diffuseMap, fs_in.TexCoord);
     vec3 emmisiveColorTex = texture(uMaterial.emmisiveMap, fs_in.TexCoord).rgb;
     vec3 emmision = (emmisiveColorTex * uMaterial.emmisiveIntensity) + (texDiffuse.rgb * uMaterial.emmisiveColor * uMaterial.emmisiveIntensity);
-    FragColor = vec4(emmision, uMaterial.opacity);
+    WriteColor(vec4(emmision, uMaterial.opacity));
 }
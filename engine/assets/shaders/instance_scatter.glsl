@@ -0,0 +1,26 @@
+#version 460
+layout(local_size_x = 64) in;
+
+struct BSphere {
+    vec3 center;
+    float radius;
+};
+
+struct InstanceData {
+    vec4 model[3];      // row-major 3x4 affine, bottom row is always (0, 0, 0, 1)
+    BSphere sphere;     // xyz = center, w = radius
+};
+
+// Resident instance table, only the slots named in the delta get written
+layout(std430, binding = 0) writeonly buffer Instances { InstanceData instances[]; };
+layout(std430, binding = 5) readonly buffer DeltaSlots { uint deltaSlots[]; };
+layout(std430, binding = 6) readonly buffer DeltaData { InstanceData deltaData[]; };
+
+uniform uint uDeltaCount;
+
+void main() {
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= uDeltaCount) return;
+
+    instances[deltaSlots[id]] = deltaData[id];
+}
@@ -124,7 +124,27 @@ in VS_OUT {
     vec3 Tangent;
 } fs_in;
 
-out vec4 FragColor;
+// ==== Manual #include because OpenGL is being a little bitch
+// Weighted blended OIT, main framebuffer attachments 1 (accumulation) and 2 (revealage)
+layout(location = 0) out vec4 FragColor;
+layout(location = 1) out vec4 OITAccum;
+layout(location = 2) out float OITRevealage;
+
+uniform bool uOITPass;
+
+void WriteColor(vec4 color) {
+    if (!uOITPass) {
+        FragColor = color;
+        return;
+    }
+
+    // McGuire & Bavoil weight, favors opaque-ish fragments close to the camera
+    float alpha = clamp(color.a, 0.0, 1.0);
+    float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+    OITAccum = vec4(color.rgb * alpha, alpha) * weight;
+    OITRevealage = alpha;
+}
+// ==== End of manual include
 
 // Material properties with textures
 struct MaterialProperties {
@@ -185,5 +205,5 @@ void main() {
     }
     
     // Final color
-    FragColor = vec4(result, texDiffuse.a);
+    WriteColor(vec4(result, texDiffuse.a));
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 450 core
+in vec2 vUV;
+out vec4 FragColor;
+
+uniform sampler2D uAccumTexture;
+uniform sampler2D uRevealageTexture;
+
+// Blended with (1 - src alpha, src alpha) over the scene, so alpha carries the revealage
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float revealage = texelFetch(uRevealageTexture, texel, 0).r;
+    if (revealage >= 1.0)
+        discard; // nothing transparent here
+
+    vec4 accum = texelFetch(uAccumTexture, texel, 0);
+    // Many bright layers can overflow half floats
+    if (isinf(max(max(accum.r, accum.g), max(accum.b, accum.a))))
+        accum.rgb = vec3(accum.a);
+
+    vec3 average = accum.rgb / max(accum.a, 1e-5);
+    FragColor = vec4(average, revealage);
+}
@@ -4,22 +4,30 @@ out vec4 FragColor;
 
 uniform sampler2D uTexture;
 uniform int uHorizontal;
+uniform vec2 uUVScale; // part of the texture the dynamic resolution viewport covers
 
 uniform float weight[5] = float[] (0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
 
+// Stay inside the viewport, texels past it are left over from bigger frames
+vec4 Sample(vec2 uv) {
+    vec2 halfTexel = 0.5 / textureSize(uTexture, 0);
+    return texture(uTexture, clamp(uv, halfTexel, uUVScale - halfTexel));
+}
+
 void main() {
     vec2 texOffset = 1.0 / textureSize(uTexture, 0);
-    vec3 result = texture(uTexture, vUV).rgb * weight[0];
+    vec2 uv = vUV * uUVScale;
+    vec3 result = Sample(uv).rgb * weight[0];
     
     if (uHorizontal == 1) {
         for(int i = 1; i < 5; ++i) {
-            result += texture(uTexture, vUV + vec2(texOffset.x * i, 0.0)).rgb * weight[i];
-            result += texture(uTexture, vUV - vec2(texOffset.x * i, 0.0)).rgb * weight[i];
+            result += Sample(uv + vec2(texOffset.x * i, 0.0)).rgb * weight[i];
+            result += Sample(uv - vec2(texOffset.x * i, 0.0)).rgb * weight[i];
         }
     } else {
         for(int i = 1; i < 5; ++i) {
-            result += texture(uTexture, vUV + vec2(0.0, texOffset.y * i)).rgb * weight[i];
-            result += texture(uTexture, vUV - vec2(0.0, texOffset.y * i)).rgb * weight[i];
+            result += Sample(uv + vec2(0.0, texOffset.y * i)).rgb * weight[i];
+            result += Sample(uv - vec2(0.0, texOffset.y * i)).rgb * weight[i];
         }
     }
     
@@ -4,9 +4,10 @@ out vec4 FragColor;
 
 uniform sampler2D uSceneTexture;
 uniform float uThreshold;
+uniform vec2 uUVScale; // part of the scene texture the dynamic resolution viewport covers
 
 void main() {
-    vec3 color = texture(uSceneTexture, vUV).rgb;
+    vec3 color = texture(uSceneTexture, vUV * uUVScale).rgb;
     float brightness = dot(color, vec3(0.2126, 0.7152, 0.0722));
     
     if (brightness > uThreshold)
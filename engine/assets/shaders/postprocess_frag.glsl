@@ -6,6 +6,61 @@ out vec4 FragColor;
 uniform sampler2D uSceneTexture;
 uniform sampler2D uBloomTexture;
 uniform float uBloomStrength;
+uniform vec2 uUVScale;    // part of the scene the dynamic resolution viewport covers
+uniform float uSharpness; // 0 when rendering at full size
+
+vec2 ClampToViewport(sampler2D tex, vec2 uv) {
+    vec2 halfTexel = 0.5 / vec2(textureSize(tex, 0));
+    return clamp(uv, halfTexel, uUVScale - halfTexel);
+}
+
+// Catmull-Rom upscale in 9 bilinear taps (Jimenez), the negative lobes keep edges crisp
+vec3 SampleCatmullRom(sampler2D tex, vec2 uv) {
+    vec2 texSize = vec2(textureSize(tex, 0));
+    vec2 samplePos = uv * texSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+
+    vec2 p0 = ClampToViewport(tex, (texPos1 - 1.0) / texSize);
+    vec2 p12 = ClampToViewport(tex, (texPos1 + w2 / w12) / texSize);
+    vec2 p3 = ClampToViewport(tex, (texPos1 + 2.0) / texSize);
+
+    vec3 result = vec3(0.0);
+    result += textureLod(tex, vec2(p0.x,  p0.y),  0.0).rgb * w0.x  * w0.y;
+    result += textureLod(tex, vec2(p12.x, p0.y),  0.0).rgb * w12.x * w0.y;
+    result += textureLod(tex, vec2(p3.x,  p0.y),  0.0).rgb * w3.x  * w0.y;
+    result += textureLod(tex, vec2(p0.x,  p12.y), 0.0).rgb * w0.x  * w12.y;
+    result += textureLod(tex, vec2(p12.x, p12.y), 0.0).rgb * w12.x * w12.y;
+    result += textureLod(tex, vec2(p3.x,  p12.y), 0.0).rgb * w3.x  * w12.y;
+    result += textureLod(tex, vec2(p0.x,  p3.y),  0.0).rgb * w0.x  * w3.y;
+    result += textureLod(tex, vec2(p12.x, p3.y),  0.0).rgb * w12.x * w3.y;
+    result += textureLod(tex, vec2(p3.x,  p3.y),  0.0).rgb * w3.x  * w3.y;
+    return max(result, vec3(0.0));
+}
+
+vec3 SampleScene(vec2 uv) {
+    if (uUVScale.x >= 1.0 && uUVScale.y >= 1.0)
+        return texture(uSceneTexture, uv).rgb;
+
+    vec3 color = SampleCatmullRom(uSceneTexture, uv);
+    if (uSharpness <= 0.0)
+        return color;
+
+    // Unsharp mask against the source texel neighbourhood, brings back some of the detail lost to the lower resolution
+    vec2 texel = 1.0 / vec2(textureSize(uSceneTexture, 0));
+    vec3 blurred = 0.25 * (
+        texture(uSceneTexture, ClampToViewport(uSceneTexture, uv + vec2(texel.x, 0.0))).rgb +
+        texture(uSceneTexture, ClampToViewport(uSceneTexture, uv - vec2(texel.x, 0.0))).rgb +
+        texture(uSceneTexture, ClampToViewport(uSceneTexture, uv + vec2(0.0, texel.y))).rgb +
+        texture(uSceneTexture, ClampToViewport(uSceneTexture, uv - vec2(0.0, texel.y))).rgb);
+    return max(color + (color - blurred) * uSharpness, vec3(0.0));
+}
 
 vec3 ToneMap_Reinhard(vec3 color) {
     return color / (1.0 + color);
@@ -32,8 +87,9 @@ vec3 ToneMap_Aces_Fitted(vec3 color) {
 }
 
 void main() {
-    vec3 scene = texture(uSceneTexture, vUV).rgb;
-    vec3 bloom = texture(uBloomTexture, vUV).rgb;
+    vec2 uv = vUV * uUVScale;
+    vec3 scene = SampleScene(uv);
+    vec3 bloom = texture(uBloomTexture, ClampToViewport(uBloomTexture, uv)).rgb;
     vec3 composite = scene + bloom * uBloomStrength;
     vec3 tonemapped = ToneMap_Aces_Fitted(composite);
 
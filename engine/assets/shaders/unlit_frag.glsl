@@ -6,7 +6,27 @@ in VS_OUT {
     vec2 TexCoord;
 } fs_in;
 
-out vec4 FragColor;
+// ==== Manual #include because OpenGL is being a little bitch
+// Weighted blended OIT, main framebuffer attachments 1 (accumulation) and 2 (revealage)
+layout(location = 0) out vec4 FragColor;
+layout(location = 1) out vec4 OITAccum;
+layout(location = 2) out float OITRevealage;
+
+uniform bool uOITPass;
+
+void WriteColor(vec4 color) {
+    if (!uOITPass) {
+        FragColor = color;
+        return;
+    }
+
+    // McGuire & Bavoil weight, favors opaque-ish fragments close to the camera
+    float alpha = clamp(color.a, 0.0, 1.0);
+    float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+    OITAccum = vec4(color.rgb * alpha, alpha) * weight;
+    OITRevealage = alpha;
+}
+// ==== End of manual include
 
 struct Material {
     vec3 diffuseColor;
@@ -17,5 +37,5 @@ uniform Material uMaterial;
 
 void main() {
     // Just output the material color, no lighting
-    FragColor = vec4(uMaterial.diffuseColor, uMaterial.opacity);
+    WriteColor(vec4(uMaterial.diffuseColor, uMaterial.opacity));
 }
\ No newline at end of file
@@ -5,22 +5,64 @@ layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aUV;
 layout(location = 3) in vec3 aTangent;
 
+// ==== Manual #include because OpenGL is being a little bitch
+// instancing.glsl - per instance model matrix, layouts match Renderer::GPU_InstanceData and GPU_QuantizedInstance
+
+// The frame's instance table, row-major 3x4 affine and the bounding sphere, 4 vec4 per instance (64 bytes)
 layout(std430, binding = 0) readonly buffer InstanceBuffer {
-    mat4 iModel[];
+    vec4 iInstances[];
+};
+
+// Position, uniform scale, rotation quaternion as 4x snorm16, 6 words per instance (24 bytes)
+layout(std430, binding = 2) readonly buffer QuantizedInstanceBuffer {
+    uint iQuantized[];
 };
 
+// Draw lists of every view index the tables above, a draw reads [uInstanceOffset, uInstanceOffset + instance count)
+layout(std430, binding = 4) readonly buffer InstanceIndexBuffer {
+    uint iInstanceIndices[];
+};
+
+uniform bool uUseInstancing;
+uniform bool uQuantizedInstances;
+uniform int uInstanceOffset;
+uniform mat4 uModel;
+
+mat4 AffineInstance(uint id) {
+    uint base = id * 4u;
+    return transpose(mat4(iInstances[base], iInstances[base + 1u], iInstances[base + 2u], vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+mat4 QuantizedInstance(uint id) {
+    uint base = id * 6u;
+    vec3 position = uintBitsToFloat(uvec3(iQuantized[base], iQuantized[base + 1u], iQuantized[base + 2u]));
+    float scale = uintBitsToFloat(iQuantized[base + 3u]);
+    vec4 q = normalize(vec4(unpackSnorm2x16(iQuantized[base + 4u]), unpackSnorm2x16(iQuantized[base + 5u])));
+
+    // Quaternion (x, y, z, w) to rotation, columns
+    vec3 c0 = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y));
+    vec3 c1 = vec3(2.0 * (q.x * q.y - q.w * q.z), 1.0 - 2.0 * (q.x * q.x + q.z * q.z), 2.0 * (q.y * q.z + q.w * q.x));
+    vec3 c2 = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+    return mat4(vec4(c0 * scale, 0.0), vec4(c1 * scale, 0.0), vec4(c2 * scale, 0.0), vec4(position, 1.0));
+}
+
+mat4 InstanceModel() {
+    if (!uUseInstancing) return uModel;
+    uint id = iInstanceIndices[uint(uInstanceOffset + gl_InstanceID)];
+    return uQuantizedInstances ? QuantizedInstance(id) : AffineInstance(id);
+}
+// ==== End of manual include
+
 out VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoord;
 } vs_out;
 
-uniform bool uUseInstancing;
-uniform mat4 uModel;
 uniform mat4 uProjView;
 
 void main() {
-    mat4 model = uUseInstancing ? InstanceBufferiModel[gl_InstanceID] : uModel;
+    mat4 model = InstanceModel();
     vec4 worldPos = model * vec4(aPosition, 1.0);
     
     vs_out.FragPos = worldPos.xyz;
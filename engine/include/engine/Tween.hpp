@@ -1,11 +1,13 @@
 #pragma once
 #include "types.hpp"
 #include "Easing.hpp"
+#include "simd_math.hpp"
 
 namespace Engine::Tween {
 
     using namespace Engine;
     using Engine::Component::Transform;
+    using Engine::Component::WorldTransform;
 
     inline Transform Interpolate(
         const Transform& a,
@@ -24,12 +26,59 @@ namespace Engine::Tween {
         // Rotation → slerp
         out.rotation = glm::slerp(a.rotation, b.rotation, e);
 
-        // Update model matrix
-        out.modelMatrix = glm::translate(glm::mat4(1.f), out.position) *
-            glm::mat4_cast(out.rotation) *
-            glm::scale(glm::mat4(1.f), out.scale);
-
+        // The model matrix is the TransformSystem's job once this lands in the ECS
         return out;
     }
 
+    // Interpolate for many pairs at once, same results as Interpolate per element
+    // worlds, when given, also gets the model matrices, for tweened things that live outside the ECS
+    inline void InterpolateBatch(
+        const Transform* a,
+        const Transform* b,
+        const float* t,
+        Transform* out,
+        size_t count,
+        Easing::Func easing = Easing::Linear,
+        WorldTransform* worlds = nullptr
+    ) {
+        thread_local SIMD::QuatBuffer from, to;
+        thread_local SIMD::TRSBuffer trs;
+        thread_local SIMD::AffineBuffer models;
+        thread_local std::vector<float> eased;
+
+        from.Resize(count);
+        to.Resize(count);
+        trs.Resize(count);
+        models.Resize(count);
+        eased.resize(count);
+
+        for (size_t i = 0; i < count; i++) {
+            eased[i] = easing(t[i]);
+            from.Set(i, a[i].rotation);
+            to.Set(i, b[i].rotation);
+        }
+
+        // Rotation → slerp, straight into the rotation streams of the TRS batch
+        SIMD::TRSArrays streams = trs.Arrays();
+        SIMD::SlerpQuats(from.Arrays(), to.Arrays(), eased.data(), { streams.qx, streams.qy, streams.qz, streams.qw }, count);
+
+        // Position and scale → standard mix
+        for (size_t i = 0; i < count; i++) {
+            const vec3 position = glm::mix(a[i].position, b[i].position, eased[i]);
+            const vec3 scale = glm::mix(a[i].scale, b[i].scale, eased[i]);
+            streams.px[i] = position.x; streams.py[i] = position.y; streams.pz[i] = position.z;
+            streams.sx[i] = scale.x; streams.sy[i] = scale.y; streams.sz[i] = scale.z;
+        }
+
+        // Model matrices in one batch
+        if (worlds) SIMD::ComposeTRS(streams, models.Arrays(), count);
+
+        for (size_t i = 0; i < count; i++) {
+            out[i].position = vec3(streams.px[i], streams.py[i], streams.pz[i]);
+            out[i].rotation = quat(streams.qw[i], streams.qx[i], streams.qy[i], streams.qz[i]);
+            out[i].scale = vec3(streams.sx[i], streams.sy[i], streams.sz[i]);
+            if (worlds) worlds[i].modelMatrix = models.Get(i);
+        }
+    }
+
 } // namespace Engine::Tween
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+
+#include <typeindex>
+#include <source_location>
+
+namespace Engine::AccessCheck {
+	// Debug instrumentation for the ECS, off until enabled. Per scheduler phase it records which threads read and
+	// write which component pools, and when a phase ends it reports every pool one thread wrote while another
+	// touched it. Adding or removing components of a pool that some view or query is iterating is reported right away.
+	// Reports name the component type and the call sites, each distinct conflict once
+
+	enum class Access : u8 {
+		Read, Write
+	};
+
+	ENGINE_API void SetEnabled(bool enabled);
+	ENGINE_API bool IsEnabled();
+	// Throw on a conflict instead of only logging it
+	ENGINE_API void SetFatal(bool fatal);
+	ENGINE_API u64 GetConflictCount();
+
+	ENGINE_API void BeginPhase(const char* name);
+	// Compares what every thread recorded since BeginPhase
+	ENGINE_API void EndPhase();
+
+	ENGINE_API void Record(std::type_index pool, Access access, const std::source_location& where);
+	// A component added to or removed from the pool
+	ENGINE_API void RecordStructural(std::type_index pool, const std::source_location& where);
+
+	// Counted, a pool is being iterated for as long as any iterator over it lives
+	ENGINE_API void BeginIteration(std::type_index pool);
+	ENGINE_API void EndIteration(std::type_index pool);
+}
+
+#ifdef _DEBUG
+#define ECS_ACCESS(type, access, where) ::Engine::AccessCheck::Record(type, access, where)
+#define ECS_STRUCTURAL(type, where) ::Engine::AccessCheck::RecordStructural(type, where)
+#define ECS_PHASE_BEGIN(name) ::Engine::AccessCheck::BeginPhase(name)
+#define ECS_PHASE_END() ::Engine::AccessCheck::EndPhase()
+#else
+#define ECS_ACCESS(type, access, where) (void)(where)
+#define ECS_STRUCTURAL(type, where) (void)(where)
+#define ECS_PHASE_BEGIN(name)
+#define ECS_PHASE_END()
+#endif
@@ -7,16 +7,31 @@
 #include <engine/resource.hpp>
 #include <engine/ecs.hpp>
 #include <engine/renderer.hpp>
+#include <engine/frame_pacing.hpp>
+#include <engine/input.hpp>
+#include <engine/replay.hpp>
+#include <engine/metrics.hpp>
 
 namespace Engine {
+	// Simulation only: no window, GL, renderer or frame pacer. Layers get their fixed and variable updates but no
+	// OnRender, resources load without GPU upload and input only comes in through a replay
+	struct HeadlessConfig {
+		u32 frames = 0;         // 0 runs until the replay ends or the process gets killed
+		f32 fixedStepMs = 0.0f; // every frame simulates this much, 0 measures real time and runs as fast as it can
+	};
+
 	class Application {
 	public:
 		ENGINE_API Application(std::shared_ptr<Window> window, std::shared_ptr<VFS> vfs, std::shared_ptr<ResourceSystem> rs, std::shared_ptr<ECS> ecs);
+		ENGINE_API Application(std::shared_ptr<VFS> vfs, std::shared_ptr<ResourceSystem> rs, std::shared_ptr<ECS> ecs, const HeadlessConfig& headless);
 
 		ENGINE_API void Run();
 
 		ENGINE_API static Application& Get();
 
+		ENGINE_API bool IsHeadless() const { return m_Headless; }
+
+		// Window, renderer and frame pacer don't exist in headless runs, GetRenderer returns null
 		ENGINE_API Window& GetWindow() { return *m_Window; }
 
 		ENGINE_API void PushLayer(ILayer* layer);
@@ -33,14 +48,36 @@ namespace Engine {
 
 		ENGINE_API std::shared_ptr<Renderer> GetRenderer() const;
 
+		ENGINE_API FramePacer& GetFramePacer() { return *m_FramePacer; }
+
+		ENGINE_API InputSystem& GetInput() { return *m_Input; }
+
+		ENGINE_API Replay& GetReplay() { return *m_Replay; }
+
+		ENGINE_API MetricsRegistry& GetMetrics() { return *m_Metrics; }
+
+		ENGINE_API MetricsExporter& GetMetricsExporter() { return *m_MetricsExporter; }
+
 		ENGINE_API void OnResize(unsigned int width, unsigned int height);
 	private:
+		// Entity, pool and resource cache numbers, walks the caches so it only runs every so often
+		void UpdateSlowMetrics();
+		// After the late latch callbacks: world transforms of what they moved, the latched camera's view
+		void LatchCamera(vector<entity_id>& updatedEntities);
+
 		std::shared_ptr<Window> m_Window;
 		LayerStack m_LayerStack;
 		std::shared_ptr<VFS> m_Vfs;
 		std::shared_ptr<ResourceSystem> m_Rs;
 		std::shared_ptr<ECS> m_Ecs;
 		std::shared_ptr<Renderer> m_Renderer;
+		std::shared_ptr<FramePacer> m_FramePacer;
+		std::shared_ptr<InputSystem> m_Input;
+		std::shared_ptr<Replay> m_Replay;
+		std::shared_ptr<MetricsRegistry> m_Metrics;
+		std::shared_ptr<MetricsExporter> m_MetricsExporter; // after the registry, stops before it goes away
 		bool m_Running = true;
+		bool m_Headless = false;
+		HeadlessConfig m_HeadlessConfig;
 	};
 }
\ No newline at end of file
@@ -3,10 +3,13 @@
 #include <engine/api.hpp>
 #include <engine/types.hpp>
 #include <engine/exception.hpp>
+#include <engine/simd_math.hpp>
+#include <engine/access_check.hpp>
 
 #include <functional>   // For std::function
 #include <typeindex>    // For std::type_index
 #include <limits>
+#include <source_location>
 
 namespace Engine {
 
@@ -68,6 +71,11 @@ namespace Engine {
 				return &m_Dense[m_Sparse[entity]];
 			}
 
+			// No checks, for callers that already know the entity has it (queries)
+			T& GetUnchecked(entity_id entity) {
+				return m_Dense[m_Sparse[entity]];
+			}
+
 			// Removes a component from an entity using swap-and-pop.
 			void Remove(entity_id entity) override {
 				if (!Has(entity)) ENGINE_THROW("Entity does not have this component to remove.");
@@ -132,6 +140,65 @@ namespace Engine {
 			// Maps an entity ID to its index in the dense array.
 			std::vector<u32> m_Sparse;
 		};
+		// Type-erased part of a Query, the ECS keeps its entity list in sync as components come and go
+		class QueryBase {
+		public:
+			QueryBase(vector<std::type_index> types) : m_Types{ std::move(types) } {}
+			virtual ~QueryBase() = default;
+
+			const vector<std::type_index>& Types() const { return m_Types; }
+			bool Contains(entity_id entity) const {
+				return entity < m_Sparse.size() && m_Sparse[entity] != null;
+			}
+
+			void Insert(entity_id entity) {
+				if (Contains(entity)) return;
+				if (entity >= m_Sparse.size()) m_Sparse.resize((entity * 2) + 1, null);
+				m_Sparse[entity] = static_cast<u32>(m_Entities.size());
+				m_Entities.push_back(entity);
+			}
+
+			// Swap-and-pop like the pools
+			void Erase(entity_id entity) {
+				if (!Contains(entity)) return;
+				const u32 index = m_Sparse[entity];
+				const entity_id last = m_Entities.back();
+				m_Entities[index] = last;
+				m_Sparse[last] = index;
+				m_Entities.pop_back();
+				m_Sparse[entity] = null;
+			}
+
+		protected:
+			vector<std::type_index> m_Types;
+			// Matching entities, densely packed
+			vector<entity_id> m_Entities;
+			// Maps an entity ID to its index in m_Entities.
+			vector<u32> m_Sparse;
+		};
+
+#ifdef _DEBUG
+		// Marks the pools of Components as iterated for as long as the iterator lives, for the access checks
+		template<typename... Components>
+		class IterationGuard {
+		public:
+			IterationGuard() : m_Active{ AccessCheck::IsEnabled() } {
+				if (m_Active) (AccessCheck::BeginIteration(std::type_index(typeid(Components))), ...);
+			}
+			IterationGuard(const IterationGuard&) : IterationGuard() {}
+			// Each guard keeps its own registration
+			IterationGuard& operator=(const IterationGuard&) { return *this; }
+			~IterationGuard() {
+				if (m_Active) (AccessCheck::EndIteration(std::type_index(typeid(Components))), ...);
+			}
+
+		private:
+			bool m_Active;
+		};
+#else
+		template<typename... Components>
+		class IterationGuard {};
+#endif
 	} // namespace detail
 
 	template<typename... Components>
@@ -144,14 +211,14 @@ namespace Engine {
 		using reference = value_type;
 		using iterator_category = std::forward_iterator_tag;
 
-		ViewIterator(ECS* ecs, const detail::IComponentPool* pool, size_t index)
-			: m_Ecs{ ecs }, m_Pool{ pool }, m_Index{ index } {
+		ViewIterator(ECS* ecs, const detail::IComponentPool* pool, size_t index, u64 with = 0, u64 without = 0)
+			: m_Ecs{ ecs }, m_Pool{ pool }, m_Index{ index }, m_With{ with }, m_Without{ without } {
 			AdvanceToValid();
 		}
 
 		reference operator*() const {
 			entity_id entity = m_Pool->DenseToEntity(m_Index);
-			return reference(entity, m_Ecs->template GetComponent<Components>(entity)...);
+			return reference(entity, m_Ecs->template GetComponentUntracked<Components>(entity)...);
 		}
 
 		ViewIterator& operator++() {
@@ -177,13 +244,20 @@ namespace Engine {
 	private:
 		bool HasAllComponents(entity_id entity) const {
 			// Check all types with folded expression
-			return (m_Ecs->template HasComponent<Components>(entity) && ...);
+			return (m_Ecs->template HasComponentUntracked<Components>(entity) && ...);
+		}
+
+		bool MatchesTags(entity_id entity) const {
+			// One word per entity, so the tag filters cost a load and two compares
+			const u64 tags = m_Ecs->GetTagMask(entity);
+			return (tags & m_With) == m_With && (tags & m_Without) == 0;
 		}
 
 		void AdvanceToValid() {
 			while (m_Index < m_Pool->Size()) {
 				entity_id entity = m_Pool->DenseToEntity(m_Index);
-				if (HasAllComponents(entity)) break;
+				// Tags first, filtered out entities never get to the pool lookups
+				if (MatchesTags(entity) && HasAllComponents(entity)) break;
 				++m_Index;
 			}
 		}
@@ -191,6 +265,9 @@ namespace Engine {
 		ECS* m_Ecs;
 		const detail::IComponentPool* m_Pool;
 		size_t m_Index;
+		u64 m_With;
+		u64 m_Without;
+		[[no_unique_address]] detail::IterationGuard<Components...> m_Guard;
 	};
 
 	template <typename... Components>
@@ -204,7 +281,7 @@ namespace Engine {
 
 		iterator begin() const {
 			if (!m_SmallestPool) return iterator(m_Ecs, nullptr, 0);
-			return iterator(m_Ecs, m_SmallestPool, 0);
+			return iterator(m_Ecs, m_SmallestPool, 0, m_With, m_Without);
 		}
 
 		iterator end() const {
@@ -212,6 +289,22 @@ namespace Engine {
 			return iterator(m_Ecs, m_SmallestPool, m_SmallestPool->Size());
 		}
 
+		// Only entities tagged with all of Tags
+		template<typename... Tags>
+		View With() const {
+			View view = *this;
+			view.m_With |= m_Ecs->template TagMask<Tags...>();
+			return view;
+		}
+
+		// Only entities tagged with none of Tags
+		template<typename... Tags>
+		View Without() const {
+			View view = *this;
+			view.m_Without |= m_Ecs->template TagMask<Tags...>();
+			return view;
+		}
+
 	private:
 		size_t size_hint() const {
 			return m_SmallestPool ? m_SmallestPool->Size() : 0;
@@ -242,6 +335,94 @@ namespace Engine {
 	private:
 		ECS* m_Ecs;
 		detail::IComponentPool* m_SmallestPool;
+		u64 m_With = 0;
+		u64 m_Without = 0;
+	};
+
+	// A View that stays around: the ECS updates its entity list on every add/remove of one of the Components,
+	// so iterating costs only the matches, no pool probing. Obtained through ECS::Query, one instance per type list.
+	// Adding or removing the queried components while iterating invalidates the iteration, as with pools
+	template<typename... Components>
+	class Query : public detail::QueryBase {
+	public:
+		class Iterator {
+		public:
+			using value_type = std::tuple<entity_id, Components&...>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = value_type*;
+			using reference = value_type;
+			using iterator_category = std::forward_iterator_tag;
+
+			Iterator(const Query* query, size_t index, u64 with, u64 without)
+				: m_Query{ query }, m_Index{ index }, m_With{ with }, m_Without{ without } {
+				AdvanceToValid();
+			}
+
+			reference operator*() const {
+				entity_id entity = m_Query->m_Entities[m_Index];
+				return reference(entity, std::get<detail::ComponentPool<std::remove_const_t<Components>>*>(m_Query->m_Pools)->GetUnchecked(entity)...);
+			}
+
+			Iterator& operator++() {
+				++m_Index;
+				AdvanceToValid();
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const { return m_Index == other.m_Index; }
+			bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+		private:
+			void AdvanceToValid() {
+				if (!(m_With | m_Without)) return;
+				while (m_Index < m_Query->m_Entities.size()) {
+					const u64 tags = m_Query->m_Ecs->GetTagMask(m_Query->m_Entities[m_Index]);
+					if ((tags & m_With) == m_With && (tags & m_Without) == 0) break;
+					++m_Index;
+				}
+			}
+
+			const Query* m_Query;
+			size_t m_Index;
+			u64 m_With;
+			u64 m_Without;
+			[[no_unique_address]] detail::IterationGuard<Components...> m_Guard;
+		};
+
+		// The tag filtered range of a query, same semantics as View::With/Without
+		class Range {
+		public:
+			Range(const Query* query, u64 with, u64 without) : m_Query{ query }, m_With{ with }, m_Without{ without } {}
+
+			Iterator begin() const { return Iterator(m_Query, 0, m_With, m_Without); }
+			Iterator end() const { return Iterator(m_Query, m_Query->m_Entities.size(), 0, 0); }
+
+			template<typename... Tags>
+			Range With() const { return Range(m_Query, m_With | m_Query->m_Ecs->template TagMask<Tags...>(), m_Without); }
+			template<typename... Tags>
+			Range Without() const { return Range(m_Query, m_With, m_Without | m_Query->m_Ecs->template TagMask<Tags...>()); }
+
+		private:
+			const Query* m_Query;
+			u64 m_With;
+			u64 m_Without;
+		};
+
+		Query(ECS* ecs);
+
+		Iterator begin() const { return Iterator(this, 0, 0, 0); }
+		Iterator end() const { return Iterator(this, m_Entities.size(), 0, 0); }
+		size_t Size() const { return m_Entities.size(); }
+
+		template<typename... Tags>
+		Range With() const { return Range(this, 0, 0).template With<Tags...>(); }
+		template<typename... Tags>
+		Range Without() const { return Range(this, 0, 0).template Without<Tags...>(); }
+
+	private:
+		ECS* m_Ecs;
+		// Resolved once, pools live as long as the ECS
+		std::tuple<detail::ComponentPool<std::remove_const_t<Components>>*...> m_Pools;
 	};
 
 	class ECS {
@@ -255,18 +436,35 @@ namespace Engine {
 
 		// Entity management
 		ENGINE_API entity_id CreateEntity();
-		ENGINE_API entity_id CreateEntity3D(entity_id parent = null, Component::Transform transform = Component::Transform(), const std::string& name = "");
-		ENGINE_API entity_id Instantiate(entity_id parent, Component::Transform rootTransform, std::shared_ptr<Model> model);
-		ENGINE_API void DestroyEntity(entity_id entity, bool recurse = false);
+		ENGINE_API entity_id CreateEntity3D(entity_id parent = null, Component::Transform transform = Component::Transform(), const std::string& name = "",
+			const std::source_location& where = std::source_location::current());
+		ENGINE_API entity_id Instantiate(entity_id parent, Component::Transform rootTransform, std::shared_ptr<Model> model,
+			const std::source_location& where = std::source_location::current());
+		ENGINE_API void DestroyEntity(entity_id entity, bool recurse = false, const std::source_location& where = std::source_location::current());
 
 		// Special functions
 		ENGINE_API RefTransform GetTransformRef(entity_id entity);
 		ENGINE_API const unordered_set<entity_id>& GetDeletedEntities() const;
 		ENGINE_API void ReparentEntity(entity_id entity, entity_id new_parent);
 		ENGINE_API bool Exists(entity_id entity) const;
+
+		// Names, kept in a name -> entities index unless it's switched off
+		ENGINE_API void SetName(entity_id entity, std::string_view name);
+		// Every entity with exactly this name, O(1) with the index and a scan of the Name pool without it
+		ENGINE_API const vector<entity_id>& FindByName(std::string_view name);
+		// The first of them, null if there's none
+		ENGINE_API entity_id FindEntity(std::string_view name);
+		ENGINE_API void SetNameIndexEnabled(bool enabled);
+
+		// Telemetry
+		ENGINE_API size_t GetEntityCount() const;
+		// Component type name (namespaces stripped) and how many entities have it
+		ENGINE_API vector<std::pair<string, size_t>> GetPoolSizes() const;
 		
 
 		// Component management
+		// The where parameters are only for the debug access checks (access_check.hpp), leave them defaulted.
+		// Get a const T when only reading, the checks count anything else as a write
 		template<typename T>
 		void RegisterComponent() {
 			std::type_index type_idx = std::type_index(typeid(T));
@@ -278,32 +476,32 @@ namespace Engine {
 		}
 
 		template<typename T>
-		T& AddComponent(entity_id entity, T component) {
+		T& AddComponent(entity_id entity, T component, const std::source_location& where = std::source_location::current()) {
 			std::type_index type_idx = std::type_index(typeid(T));
+			ECS_STRUCTURAL(type_idx, where);
 			// We pass the component data via a void pointer (type erasure).
 			AddComponentImpl(entity, type_idx, &component);
 			// The implementation will place it in storage, and we can get it back.
-			return GetComponent<T>(entity);
+			return GetComponentUntracked<T>(entity);
 		}
 
 		template<typename T>
-		T& GetComponent(entity_id entity) {
-			std::type_index type_idx = std::type_index(typeid(T));
-			void* pData = GetComponentImpl(entity, type_idx);
-			if (!pData) ENGINE_THROW("Component not found or entity is invalid.");
-			return *static_cast<T*>(pData);
+		T& GetComponent(entity_id entity, const std::source_location& where = std::source_location::current()) {
+			ECS_ACCESS(std::type_index(typeid(T)), std::is_const_v<T> ? AccessCheck::Access::Read : AccessCheck::Access::Write, where);
+			return GetComponentUntracked<T>(entity);
 		}
 
 		template<typename T>
-		void RemoveComponent(entity_id entity) {
+		void RemoveComponent(entity_id entity, const std::source_location& where = std::source_location::current()) {
 			std::type_index type_idx = std::type_index(typeid(T));
+			ECS_STRUCTURAL(type_idx, where);
 			RemoveComponentImpl(entity, type_idx);
 		}
 
 		template<typename T>
-		bool HasComponent(entity_id entity) {
-			std::type_index type_idx = std::type_index(typeid(T));
-			return HasComponentImpl(entity, type_idx);
+		bool HasComponent(entity_id entity, const std::source_location& where = std::source_location::current()) {
+			ECS_ACCESS(std::type_index(typeid(T)), AccessCheck::Access::Read, where);
+			return HasComponentUntracked<T>(entity);
 		}
 
 		// System management
@@ -327,14 +525,87 @@ namespace Engine {
 			return std::static_pointer_cast<detail::ComponentPool<T>>(GetSystemImpl(type_idx));
 		}
 
+		// Counts as an access to every pool of Components on the calling thread
 		template<typename... Components>
-		View<Components...> View() {
+		View<Components...> View(const std::source_location& where = std::source_location::current()) {
+			RecordAccess<Components...>(where);
 			return ::Engine::View<Components...>(this);
 		}
 
+		// Cached query over Components, built on the first call and kept up to date from then on
+		template<typename... Components>
+		::Engine::Query<Components...>& Query(const std::source_location& where = std::source_location::current()) {
+			static_assert(sizeof...(Components) > 0, "Query must have at least one component type");
+			RecordAccess<Components...>(where);
+			using QueryType = ::Engine::Query<Components...>;
+			std::type_index type_idx = std::type_index(typeid(QueryType));
+			detail::QueryBase* query = GetQueryImpl(type_idx);
+			if (!query) query = AddQueryImpl(type_idx, std::make_unique<QueryType>(this));
+			return *static_cast<QueryType*>(query);
+		}
+
+		// Tag management, tags are empty types that only set a bit in the entity's mask (64 tag types at most)
+		template<typename T>
+		void RegisterTag() {
+			static_assert(std::is_empty_v<T>, "Tags carry no data, use a component instead");
+			RegisterTagImpl(std::type_index(typeid(T)));
+		}
+
+		template<typename T>
+		void AddTag(entity_id entity) {
+			SetTagsImpl(entity, TagMask<T>(), true);
+		}
+
+		template<typename T>
+		void RemoveTag(entity_id entity) {
+			SetTagsImpl(entity, TagMask<T>(), false);
+		}
+
+		template<typename T>
+		bool HasTag(entity_id entity) const {
+			return (GetTagMask(entity) & TagMask<T>()) != 0;
+		}
+
+		// Bits of the given tag types
+		template<typename... Tags>
+		u64 TagMask() const {
+			return (TagBitImpl(std::type_index(typeid(Tags))) | ... | 0ull);
+		}
+
+		// Every tag of the entity, one bit per registered tag type
+		u64 GetTagMask(entity_id entity) const {
+			return entity < m_TagMasks.size() ? m_TagMasks[entity] : 0;
+		}
+
 	private:
 		template <typename ... Components>
 		friend class View;
+		template <typename ... Components>
+		friend class ViewIterator;
+		template <typename ... Components>
+		friend class ::Engine::Query;
+
+		// Iterators go through these, the access was already recorded when the view or query was obtained
+		template<typename T>
+		T& GetComponentUntracked(entity_id entity) {
+			void* pData = GetComponentImpl(entity, std::type_index(typeid(T)));
+			if (!pData) ENGINE_THROW("Component not found or entity is invalid.");
+			return *static_cast<T*>(pData);
+		}
+
+		template<typename T>
+		bool HasComponentUntracked(entity_id entity) {
+			return HasComponentImpl(entity, std::type_index(typeid(T)));
+		}
+
+		template<typename... Components>
+		void RecordAccess(const std::source_location& where) {
+#ifdef _DEBUG
+			(ECS_ACCESS(std::type_index(typeid(Components)), std::is_const_v<Components> ? AccessCheck::Access::Read : AccessCheck::Access::Write, where), ...);
+#else
+			(void)where;
+#endif
+		}
 
 		// Non-templated functions
 		ENGINE_API void RegisterComponentImpl(std::type_index type, std::function<std::unique_ptr<detail::IComponentPool>()> factory);
@@ -344,12 +615,27 @@ namespace Engine {
 		ENGINE_API bool HasComponentImpl(entity_id entity, std::type_index type);
 		ENGINE_API detail::IComponentPool* GetPoolImpl(std::type_index type);
 
+		ENGINE_API detail::QueryBase* GetQueryImpl(std::type_index type);
+		ENGINE_API detail::QueryBase* AddQueryImpl(std::type_index type, std::unique_ptr<detail::QueryBase> query);
+
+		ENGINE_API void RegisterTagImpl(std::type_index type);
+		ENGINE_API u64 TagBitImpl(std::type_index type) const;
+		ENGINE_API void SetTagsImpl(entity_id entity, u64 bits, bool set);
+
 		ENGINE_API void RegisterSystemImpl(std::type_index type, std::shared_ptr<ISystem> system);
 		ENGINE_API std::shared_ptr<ISystem> GetSystemImpl(std::type_index type);
 
 		std::unique_ptr<ECSImpl> m_Impl;
+		// Indexed by entity, read inline by views so tag filters never leave the caller
+		vector<u64> m_TagMasks;
 	};
 
+	template<typename... Components>
+	Query<Components...>::Query(ECS* ecs)
+		: detail::QueryBase({ std::type_index(typeid(Components))... }), m_Ecs{ ecs },
+		m_Pools{ static_cast<detail::ComponentPool<std::remove_const_t<Components>>*>(ecs->GetPoolImpl(std::type_index(typeid(Components))))... } {
+	}
+
 	// Iterates over all children
 	class SiblingIterator {
 	public:
@@ -419,6 +705,12 @@ namespace Engine {
 	private:
 		vector<vector<entity_id>> m_DepthBuckets;
 		unordered_set<entity_id> m_Registered;
+
+		// Scratch of the level being updated, kept around so steady frames don't allocate
+		vector<entity_id> m_Batch;
+		SIMD::TRSBuffer m_Locals;
+		SIMD::AffineBuffer m_Parents;
+		SIMD::AffineBuffer m_Models;
 	};
 
 	// Should be used if we plan on modifying the transform
@@ -468,11 +760,12 @@ namespace Engine {
 		ENGINE_API void Apply();
 
 	private:
-		ENGINE_API RefTransform(ECS& ecs, entity_id entity, Component::Transform& transform, TransformSystem& system);
+		ENGINE_API RefTransform(ECS& ecs, entity_id entity, Component::Transform& transform, const Component::WorldTransform& worldTransform, TransformSystem& system);
 		ENGINE_API mat4 GetParentModelMatrix() const;
 		ENGINE_API quat GetParentWorldRotation() const;
 
-		Component::Transform& data;
+		Component::Transform& data; // local TRS, what the setters write
+		const Component::WorldTransform& world; // last result of the TransformSystem
 		entity_id id;
 		ECS& ecs;
 		TransformSystem& system;
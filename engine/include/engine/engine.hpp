@@ -2,5 +2,6 @@
 
 #include <engine/api.hpp>
 
-ENGINE_API void engine_initialize();
+// Headless runs skip GLFW, they don't need a display
+ENGINE_API void engine_initialize(bool headless = false);
 ENGINE_API void engine_destroy();
\ No newline at end of file
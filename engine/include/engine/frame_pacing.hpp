@@ -0,0 +1,81 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+#include <glad/glad.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace Engine {
+	// Low latency mode, the CPU never runs more than maxFramesInFlight frames ahead of the GPU
+	// so input sampled at the start of a frame reaches the screen as soon as it can
+	struct FramePacingConfig {
+		bool enabled = false;
+		u32 maxFramesInFlight = 2; // 1..3, 1 waits for the previous frame to finish before starting the next
+		f32 targetFps = 0.0f;      // frame limiter, 0 is unlimited
+		f32 spinMs = 1.5f;         // the limiter sleeps until this close to the deadline, then spins
+		bool lateLatch = true;     // poll input again and run the late latch callbacks right before rendering
+	};
+
+	class FramePacer {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		struct Stats {
+			f32 frameMs = 0.0f;        // start to start
+			f32 fenceWaitMs = 0.0f;    // blocked on the GPU this frame
+			f32 limiterMs = 0.0f;      // slept + spun this frame
+			f32 inputLatencyMs = 0.0f; // input sample to GPU done, of the last retired frame
+			u32 framesInFlight = 0;
+		};
+
+		ENGINE_API FramePacer() = default;
+		ENGINE_API ~FramePacer();
+
+		ENGINE_API void Configure(const FramePacingConfig& config);
+		ENGINE_API const FramePacingConfig& GetConfig() const { return m_Config; }
+		ENGINE_API const Stats& GetStats() const { return m_Stats; }
+
+		// Start of the frame, before input is polled: waits out the frames in flight cap and the limiter
+		ENGINE_API void BeginFrame();
+		// The input this frame is built from was just sampled
+		ENGINE_API void MarkInputSampled();
+		// Right before the render layers run input is polled again and the callbacks re-apply the freshest of it
+		// (InputSystem::GetLiveState) to the latched camera's Transform. Application then rebuilds the world
+		// transforms of whatever the callbacks moved and sets the latched camera's view matrix to the inverse of
+		// its world matrix, so a latched camera gets posed through its Transform alone, not Camera::LookAt
+		ENGINE_API u32 AddLateLatch(std::function<void()> callback);
+		ENGINE_API void RemoveLateLatch(u32 id);
+		ENGINE_API void SetLatchedCamera(entity_id camera) { m_LatchedCamera = camera; } // null for none
+		ENGINE_API entity_id GetLatchedCamera() const { return m_LatchedCamera; }
+		// True when the callbacks ran
+		ENGINE_API bool LateLatch();
+		// After the buffer swap, fences the frame
+		ENGINE_API void EndFrame();
+
+	private:
+		struct InFlight {
+			GLsync fence;
+			clock::time_point inputTime;
+		};
+
+		// Pops the oldest frame, waiting for it when block is set. False if it isn't done and block isn't set
+		bool Retire(bool block);
+		void Limit();
+
+		FramePacingConfig m_Config;
+		Stats m_Stats;
+
+		std::deque<InFlight> m_InFlight;
+		clock::time_point m_FrameStart{};
+		clock::time_point m_InputTime{};
+		bool m_Started = false;
+
+		std::vector<std::pair<u32, std::function<void()>>> m_LateLatches;
+		u32 m_NextLatchId = 1;
+		entity_id m_LatchedCamera = null;
+	};
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+
+#include <atomic>
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <span>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace Engine {
+	// Lock-free single producer single consumer ring, Capacity has to be a power of two
+	// Head and tail live on separate cache lines so the two sides don't fight over them
+	template<typename T, u32 Capacity>
+	class SpscQueue {
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+	public:
+		// Producer side, false when full
+		bool Push(const T& item) {
+			u32 head = m_Head.load(std::memory_order_relaxed);
+			if (head - m_Tail.load(std::memory_order_acquire) == Capacity) return false;
+			m_Items[head & (Capacity - 1)] = item;
+			m_Head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer side, false when empty
+		bool Pop(T& item) {
+			u32 tail = m_Tail.load(std::memory_order_relaxed);
+			if (tail == m_Head.load(std::memory_order_acquire)) return false;
+			item = m_Items[tail & (Capacity - 1)];
+			m_Tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		u32 Size() const { return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_acquire); }
+
+	private:
+		alignas(64) std::atomic<u32> m_Head{ 0 };
+		alignas(64) std::atomic<u32> m_Tail{ 0 };
+		std::array<T, Capacity> m_Items{};
+	};
+
+	struct InputEvent {
+		enum class Type : u8 {
+			Key, Char, MouseButton, CursorMove, Scroll, Focus
+		};
+
+		Type type = Type::Key;
+		i32 code = 0;   // GLFW key / mouse button / codepoint, focus state for Focus
+		i32 action = 0; // GLFW_PRESS, GLFW_RELEASE, GLFW_REPEAT
+		i32 mods = 0;
+		f64 x = 0.0, y = 0.0; // cursor position or scroll offset
+		f64 time = 0.0;       // seconds on InputSystem::Now(), stamped when the OS delivered it
+	};
+
+	// Input as of some point in time, rebuilt by replaying the events in order
+	struct InputState {
+		static constexpr u32 MAX_KEYS = 512;   // >= GLFW_KEY_LAST
+		static constexpr u32 MAX_BUTTONS = 8;  // GLFW_MOUSE_BUTTON_LAST + 1
+
+		std::bitset<MAX_KEYS> keys;
+		std::bitset<MAX_BUTTONS> buttons;
+		f64 cursorX = 0.0, cursorY = 0.0;
+		f64 scrollX = 0.0, scrollY = 0.0; // accumulated over the span the state covers
+		bool focused = true;
+
+		ENGINE_API void Apply(const InputEvent& event);
+		bool IsKeyDown(i32 key) const { return key >= 0 && (u32)key < MAX_KEYS && keys[key]; }
+		bool IsButtonDown(i32 button) const { return button >= 0 && (u32)button < MAX_BUTTONS && buttons[button]; }
+	};
+
+	// GLFW callbacks stamp every event and push it onto an SPSC queue, the frame drains it once
+	// and hands the events out with their timestamps. Fixed ticks only see the events that happened
+	// before the tick's simulated end time, so fixed rate consumers are independent of the frame rate.
+	// GLFW only pumps on the main thread, which also owns the GL context, so instead of rendering
+	// elsewhere the pump runs wherever the main thread would otherwise block (see FramePacer)
+	class InputSystem {
+	public:
+		using clock = std::chrono::steady_clock;
+		static constexpr u32 QUEUE_CAPACITY = 4096;
+
+		// window may be null for headless runs
+		ENGINE_API InputSystem(GLFWwindow* window);
+		ENGINE_API ~InputSystem();
+
+		ENGINE_API f64 Now() const;
+
+		// Services the OS event queue, Wait blocks up to timeout seconds for the next event
+		ENGINE_API void Pump();
+		ENGINE_API void Wait(f64 timeout);
+
+		// Start of the frame, moves the queued events over to the frame
+		ENGINE_API void BeginFrame();
+		// Before every fixed tick, tickEnd is the simulated time the tick advances to
+		ENGINE_API void BeginFixedTick(f64 tickEnd);
+
+		// Variable update: everything that came in since the previous frame
+		ENGINE_API std::span<const InputEvent> GetFrameEvents() const { return m_FrameEvents; }
+		ENGINE_API const InputState& GetState() const { return m_FrameState; }
+		// Fixed update: events up to the current tick's end, each seen by exactly one tick
+		ENGINE_API std::span<const InputEvent> GetFixedEvents() const { return { m_FixedPending.data(), m_FixedCount }; }
+		ENGINE_API const InputState& GetFixedState() const { return m_FixedState; }
+		// Straight from the callbacks, includes events the frame hasn't drained yet (late latching)
+		ENGINE_API const InputState& GetLiveState() const { return m_LiveState; }
+
+		ENGINE_API u64 GetDroppedEvents() const { return m_Dropped; }
+
+		// Replay feeds recorded events in instead, the real ones still reach the chained callbacks (ImGui)
+		ENGINE_API void SetRealInput(bool enabled) { m_RealInput = enabled; }
+		ENGINE_API void Inject(const InputEvent& event) { Push(event); }
+
+	private:
+		void Push(const InputEvent& event);
+		static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+		static void CharCallback(GLFWwindow* window, unsigned int codepoint);
+		static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+		static void CursorPosCallback(GLFWwindow* window, double x, double y);
+		static void ScrollCallback(GLFWwindow* window, double x, double y);
+		static void FocusCallback(GLFWwindow* window, int focused);
+
+		GLFWwindow* m_Window;
+		clock::time_point m_Epoch;
+
+		SpscQueue<InputEvent, QUEUE_CAPACITY> m_Queue;
+		u64 m_Dropped = 0;
+		bool m_RealInput = true;
+
+		vector<InputEvent> m_FrameEvents;
+		vector<InputEvent> m_FixedPending; // not yet handed to a fixed tick, front m_FixedCount are the current tick's
+		size_t m_FixedCount = 0;
+
+		InputState m_LiveState;
+		InputState m_FrameState;
+		InputState m_FixedState;
+	};
+}
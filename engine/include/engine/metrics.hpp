@@ -0,0 +1,110 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+namespace Engine {
+	// Metrics that stay around in release builds, unlike PERF_* which only exist in debug
+	// Updates are lock-free atomics so the exporter thread can read while the main thread writes,
+	// only registering a new series takes the registry lock (so cache the returned references)
+
+	// Only ever goes up
+	class Counter {
+	public:
+		void Add(u64 n = 1) { m_Value.fetch_add(n, std::memory_order_relaxed); }
+		u64 Get() const { return m_Value.load(std::memory_order_relaxed); }
+	private:
+		std::atomic<u64> m_Value{ 0 };
+	};
+
+	// Current value of something
+	class Gauge {
+	public:
+		void Set(f64 value) { m_Value.store(value, std::memory_order_relaxed); }
+		f64 Get() const { return m_Value.load(std::memory_order_relaxed); }
+	private:
+		std::atomic<f64> m_Value{ 0.0 };
+	};
+
+	// Cumulative buckets by upper bound, +Inf is implicit
+	class Histogram {
+	public:
+		ENGINE_API Histogram(vector<f64> bounds);
+
+		ENGINE_API void Observe(f64 value);
+
+		const vector<f64>& GetBounds() const { return m_Bounds; }
+		u64 GetBucket(size_t i) const { return m_Buckets[i].load(std::memory_order_relaxed); } // not cumulative, last one is +Inf
+		u64 GetCount() const { return m_Count.load(std::memory_order_relaxed); }
+		f64 GetSum() const { return m_Sum.load(std::memory_order_relaxed); }
+	private:
+		vector<f64> m_Bounds;
+		std::unique_ptr<std::atomic<u64>[]> m_Buckets;
+		std::atomic<u64> m_Count{ 0 };
+		std::atomic<f64> m_Sum{ 0.0 };
+	};
+
+	class MetricsRegistry {
+	public:
+		enum class Type : u8 {
+			Counter, Gauge, Histogram
+		};
+
+		// Same name + labels returns the same series, labels are in exposition syntax: pool="Transform"
+		ENGINE_API Counter& GetCounter(const string& name, const string& help = "", const string& labels = "");
+		ENGINE_API Gauge& GetGauge(const string& name, const string& help = "", const string& labels = "");
+		ENGINE_API Histogram& GetHistogram(const string& name, const string& help, vector<f64> bounds, const string& labels = "");
+
+		// Prometheus text exposition format, one consistent snapshot of every series
+		ENGINE_API string Serialize() const;
+
+	private:
+		struct Family {
+			Type type;
+			string help;
+			std::map<string, std::unique_ptr<Counter>> counters;
+			std::map<string, std::unique_ptr<Gauge>> gauges;
+			std::map<string, std::unique_ptr<Histogram>> histograms;
+		};
+
+		Family& GetFamily(const string& name, const string& help, Type type);
+
+		std::map<string, Family> m_Families;
+		mutable std::mutex m_Mutex;
+	};
+
+	struct MetricsExportConfig {
+		path file;              // snapshot written here every interval, empty disables
+		u16 port = 0;           // serves the snapshot on 127.0.0.1:port to any request, 0 disables
+		f32 intervalSeconds = 5.0f;
+	};
+
+	// Background thread that publishes the registry, the file is replaced atomically so scrapers never see half of it
+	class MetricsExporter {
+	public:
+		ENGINE_API MetricsExporter(const MetricsRegistry& registry);
+		ENGINE_API ~MetricsExporter();
+
+		ENGINE_API void Start(const MetricsExportConfig& config);
+		ENGINE_API void Stop();
+		ENGINE_API bool IsRunning() const { return m_Thread.joinable(); }
+
+	private:
+		void Run();
+		void WriteFile() const;
+
+		const MetricsRegistry& m_Registry;
+		MetricsExportConfig m_Config;
+
+		std::thread m_Thread;
+		std::mutex m_Mutex;
+		std::condition_variable m_Wake;
+		bool m_Stop = false;
+	};
+}
@@ -4,6 +4,10 @@
 #include <engine/types.hpp>
 #include <engine/resource.hpp>
 #include <engine/renderer.hpp>
+#include <engine/replay.hpp>
+#include <engine/simd_math.hpp>
+
+#include <functional>
 
 namespace Engine {
 
@@ -26,6 +30,7 @@ namespace Engine {
 
         struct InstanceData {
             Component::Transform transform;
+            Component::WorldTransform world; // composed by the system after every update
             bool alive = true;
         };
 
@@ -64,7 +69,13 @@ namespace Engine {
             }
         }
 
-        // User-defined update function per particle.
+        // User-defined initialization of a freshly (re)spawned particle. Spawning is serial, so unlike
+        // the update function this is the place to draw per-particle random values.
+        void OnSpawn(std::function<void(T&, InstanceData&)> fn) {
+            m_OnSpawn = std::move(fn);
+        }
+
+        // User-defined update function per particle, runs in parallel and must only touch its own particle.
         template <typename Func>
         void Update(float dt, Func&& fn) {
             const size_t n = m_Particles.size();
@@ -95,20 +106,41 @@ namespace Engine {
                     SpawnParticle(idx);
                 }
             }
+
+            ComposeMatrices();
         }
 
         void Draw(std::shared_ptr<Renderer> renderer) {
             for (size_t i = 0; i < m_Particles.size(); i++) {
                 if (!m_Instances[i].alive) continue;
 
-                renderer->QueueDrawable3D(
+                // Particles are unparented with uniform scale, the compact instance format is enough
+                renderer->QueueDrawable3DQuantized(
                     &m_Instances[i].transform,
+                    &m_Instances[i].world,
                     &m_Drawable
                 );
             }
         }
 
     private:
+        // Model matrices of every particle from its TRS in one batch, the update function only moves them
+        void ComposeMatrices() {
+            const size_t n = m_Instances.size();
+            m_TRS.Resize(n);
+            m_Models.Resize(n);
+            for (size_t i = 0; i < n; i++) {
+                const Component::Transform& t = m_Instances[i].transform;
+                m_TRS.Set(i, t.position, t.rotation, t.scale);
+            }
+
+            SIMD::ComposeTRS(m_TRS.Arrays(), m_Models.Arrays(), n);
+
+            for (size_t i = 0; i < n; i++) {
+                if (m_Instances[i].alive) m_Instances[i].world.modelMatrix = m_Models.Get(i);
+            }
+        }
+
         // Actual spawn implementation based on mode.
         void SpawnParticle(size_t idx) {
             InstanceData& inst = m_Instances[idx];
@@ -144,6 +176,8 @@ namespace Engine {
 
             // Reset user payload T
             m_Particles[idx] = T{};
+
+            if (m_OnSpawn) m_OnSpawn(m_Particles[idx], inst);
         }
 
         glm::vec3 RandomPointInBounds(const BBox& b) {
@@ -168,7 +202,11 @@ namespace Engine {
         Particle::SpawnMethod m_Spawn;
         Particle::LifetimeMethod m_Lifetime;
 
-        std::mt19937 m_Rng{ std::random_device{}() };
+        std::mt19937 m_Rng{ RandomSeed() };
+        std::function<void(T&, InstanceData&)> m_OnSpawn;
+
+        SIMD::TRSBuffer m_TRS;
+        SIMD::AffineBuffer m_Models;
     };
 
 }
@@ -24,7 +24,10 @@ public:
         void begin() { start = clock::now(); }
 
         void end() {
-            auto t = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            add(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+        }
+
+        void add(double t) {
             last = t;
             samples.push_back(t);
             if (samples.size() > maxSamples) samples.erase(samples.begin());
@@ -63,6 +66,12 @@ public:
         sections[name].end();
     }
 
+    // Durations measured some other way (waits, latencies), listed with the timed sections
+    void record(const std::string& name, double ms) {
+        std::lock_guard lock(mutex);
+        sections[name].add(ms);
+    }
+
     const std::unordered_map<std::string, Section>& getSections() const { return sections; }
 
 private:
@@ -76,8 +85,10 @@ extern PerfProfiler gProfiler;
 // Macros for convenience
 #define PERF_BEGIN(name) gProfiler.begin(name)
 #define PERF_END(name)   gProfiler.end(name)
+#define PERF_VALUE(name, ms) gProfiler.record(name, ms)
 
 #else
 #define PERF_BEGIN(name)
 #define PERF_END(name)
+#define PERF_VALUE(name, ms)
 #endif // _DEBUG
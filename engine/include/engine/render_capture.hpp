@@ -0,0 +1,98 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+#include <engine/resource.hpp>
+
+namespace Engine {
+    // Renderer input of one or more frames: views, lights and queued instances, enough to push the same frames
+    // through a Renderer again without the scene that made them (grinder_replay does that in a loop).
+    // Models are referenced by their resource path and load config, meshes and materials by their index inside the model
+    struct RenderCapture {
+        enum class InstanceKind : u8 {
+            Mesh,      // Queue, mesh and material index into the model
+            Drawable,  // QueueDrawable3D, mesh is the collection index
+            Quantized  // QueueDrawable3DQuantized, same plus the local transform
+        };
+
+        // static_mesh and friends change how meshes and collections come out, replay has to load it the same way
+        struct ModelSource {
+            path file; // resource path, what ResourceSystem::load<Model> takes
+            LoadCfg::Model cfg;
+        };
+
+        struct View {
+            mat4 world;
+            Component::Camera camera;
+            vec4 viewport;
+        };
+
+        struct Light {
+            entity_id entity; // null for lights queued without one
+            u32 source;       // stands in for the Light's address those are keyed by, stable over the capture
+            mat4 world;
+            Component::Light light;
+        };
+
+        struct Instance {
+            InstanceKind kind;
+            u32 model;
+            u32 mesh;
+            u32 material = 0;
+            entity_id entity = null;
+            mat4 world;
+            Component::Transform local; // quantized only
+        };
+
+        struct Frame {
+            vector<View> views;
+            vector<Light> lights;
+            vector<Instance> instances;
+            vector<entity_id> updated; // what MarkTransformsUpdated got
+        };
+
+        Material::TransparencyMode transparencyMode = Material::TransparencyMode::Sorted;
+        vector<ModelSource> models;
+        vector<Frame> frames;
+
+        ENGINE_API bool Save(const path& file) const;
+        ENGINE_API bool Load(const path& file);
+    };
+
+    // Fills a RenderCapture from the renderer's queue calls, the renderer owns one while a capture runs
+    class RenderCaptureRecorder {
+        using WorldTransform = Component::WorldTransform;
+        using Drawable3D = Component::Drawable3D;
+
+    public:
+        // Skips delay frames, then records frames of them and writes file
+        RenderCaptureRecorder(const path& file, u32 frames, u32 delay, Material::TransparencyMode transparencyMode);
+
+        bool IsRecording() const { return m_delay == 0; }
+
+        void RecordView(const WorldTransform& transform, const Component::Camera& camera, const vec4& viewport);
+        void RecordMesh(const WorldTransform& transform, const Mesh* mesh, const Material* material);
+        void RecordDrawable(const WorldTransform& transform, const Drawable3D& drawable, entity_id entity);
+        void RecordQuantized(const Component::Transform& local, const WorldTransform& world, const Drawable3D& drawable);
+        void RecordLight(const WorldTransform& transform, const Component::Light& light, entity_id entity);
+        void RecordUpdated(const vector<entity_id>& entities);
+
+        // Once the renderer is done with the frame, true after the last one when the file was written
+        bool EndFrame();
+
+    private:
+        u32 AddModel(const Model& model);
+
+        path m_file;
+        u32 m_frameCount;
+        u32 m_delay;
+        RenderCapture m_capture;
+        RenderCapture::Frame m_frame;
+
+        std::unordered_map<const Model*, u32> m_modelIndex;
+        std::unordered_map<const Mesh*, std::pair<u32, u32>> m_meshIndex; // -> model, mesh
+        std::unordered_map<const Material*, u32> m_materialIndex;
+        std::unordered_map<const Component::Light*, u32> m_lightSources;
+        u64 m_skipped = 0; // Queue calls with meshes no drawable ever referenced, nothing to name them by
+    };
+}
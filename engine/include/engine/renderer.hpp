@@ -3,8 +3,14 @@
 #include <engine/api.hpp>
 #include <engine/types.hpp>
 #include <engine/resource.hpp>
+#include <engine/texture_streaming.hpp>
+#include <engine/simd_math.hpp>
+#include <engine/rhi.hpp>
+#include <engine/render_capture.hpp>
 #include <glad/glad.h>
 
+#include <chrono>
+
 namespace Engine {
     class Framebuffer {
     public:
@@ -13,6 +19,7 @@ namespace Engine {
             RGB = GL_RGB,
             RGBA = GL_RGBA8,
             RGBA16F = GL_RGBA16F,
+            R16F = GL_R16F,
             Color = RGBA16F,
             DEPTH24_STENCIL8 = GL_DEPTH24_STENCIL8,
             Depth = DEPTH24_STENCIL8
@@ -51,6 +58,9 @@ namespace Engine {
         inline void Bind() const;
         inline void Unbind() const;
 
+        // Framebuffer must be bound, attachment i stays on fragment output i, the ones not in the mask are disabled
+        void SetDrawBuffers(u32 attachmentMask) const;
+
         void Resize(uint32_t width, uint32_t height);
 
         std::shared_ptr<Texture> GetColorAttachment(uint32_t index = 0) const;
@@ -73,26 +83,114 @@ namespace Engine {
         std::shared_ptr<Texture> m_DepthAttachment;
     };
 
+    // The 3D passes render into a scaled viewport of the main framebuffer, the scale follows measured GPU time
+    // and the post-process composite upscales back to the window
+    struct DynamicResolutionConfig {
+        bool enabled = false;
+        f32 targetFrameMs = 16.0f; // GPU time of the whole renderer frame
+        f32 minScale = 0.5f;
+        f32 maxScale = 1.0f;
+        f32 sharpness = 0.25f;     // upscale sharpening, 0 is plain bicubic
+    };
+
     struct GlState {
         Color clearColor = Color(0.00455, 0.00455, 0.00455, 1.0);
     };
 
+    // What the per pass timings are split by, the view passes add up over all views
+    enum class RenderPass : u8 {
+        Culling, Lights, DepthPrepass, Opaque, Transparent, PostProcess, Count
+    };
+
+    // Bookkeeping of the renderer's resident instance table, one slot per (entity, collection entry), no GL in here.
+    // A slot is rewritten when it's new, shows another mesh, or its entity moved since the slot was last written.
+    // Moves are remembered until then, so a frame that marks them but never queues or draws loses nothing
+    class InstanceSlotTable {
+    public:
+        struct Acquired {
+            u32 slot;
+            bool rewrite; // the slot's instance data has to be written (and uploaded) again
+        };
+
+        // Entities whose world matrix changed, call before acquiring their slots
+        ENGINE_API void MarkUpdated(const std::vector<entity_id>& entities);
+        // At most one rewrite per slot and frame
+        ENGINE_API Acquired Acquire(entity_id entity, u32 entry, const Mesh* mesh);
+        // Slots not acquired since the last EndFrame go back to the free list, once per drawn frame
+        ENGINE_API void ReleaseUnseen();
+        ENGINE_API void EndFrame();
+
+        // Slots in use or free, the size the resident table has to have
+        u32 Size() const { return (u32)m_slots.size(); }
+
+    private:
+        struct Slot {
+            u64 key = 0; // entity << 32 | collection entry
+            const Mesh* mesh = nullptr;
+            u64 lastSeen = 0;
+            u64 written = 0; // frame the instance data was last rewritten in
+        };
+
+        std::vector<Slot> m_slots;
+        std::unordered_map<u64, u32> m_index;
+        std::vector<u32> m_free;
+        std::vector<u64> m_entityMoved; // by entity, frame MarkUpdated last saw it
+        u64 m_frame = 1;
+    };
+
     class Renderer {
         using Transform = Component::Transform;
+        using WorldTransform = Component::WorldTransform;
         using Camera = Component::Camera;
         using Light = Component::Light;
         using Drawable3D = Component::Drawable3D;
 
     public:
-        ENGINE_API void SetCamera(Transform* transform, Camera* camera);
-        ENGINE_API void Queue(Transform* transform, Mesh* mesh, Material* material);
-        ENGINE_API void QueueDrawable3D(Transform* transform, Drawable3D* drawable);
-        ENGINE_API void QueueLight(Transform* transform, Light* light);
+        static constexpr u32 MAX_VIEWS = 8; // bits of the per instance visibility mask the culling pass fills
+
+        // Replaces all views with a single full screen one
+        ENGINE_API void SetCamera(WorldTransform* transform, Camera* camera);
+        // Extra view drawn after the previous ones into viewport (normalized x, y, width, height of the output),
+        // all views share one queue, one culling dispatch and one instance upload. Returns the view index
+        ENGINE_API u32 AddView(WorldTransform* transform, Camera* camera, const vec4& viewport = vec4(0.0f, 0.0f, 1.0f, 1.0f));
+        ENGINE_API void ClearViews();
+        ENGINE_API void Queue(WorldTransform* transform, Mesh* mesh, Material* material);
+        // With an entity its instances keep a slot in the GPU resident instance table and are only uploaded again
+        // when the entity was passed to MarkTransformsUpdated since or its meshes changed, without one they're
+        // uploaded every frame like Queue
+        ENGINE_API void QueueDrawable3D(WorldTransform* transform, Drawable3D* drawable, entity_id entity = null);
+        // Entities whose world matrix changed this frame (what the TransformSystem returns), call before queueing.
+        // Also on frames that don't draw, the moves are kept until the entities are queued again
+        ENGINE_API void MarkTransformsUpdated(const std::vector<entity_id>& entities);
+        // Compact 24 byte instances built from the local position, rotation and scale.x,
+        // meant for particle-like content without parents or non-uniform scale, world is still what culling uses
+        ENGINE_API void QueueDrawable3DQuantized(const Transform* transform, WorldTransform* world, Drawable3D* drawable);
+        // Lights keep their GPU slot across frames and are only repacked when their world matrix or Light changes,
+        // entity is the slot key (the Light's address without one)
+        ENGINE_API void QueueLight(WorldTransform* transform, Light* light, entity_id entity = null);
         ENGINE_API void Draw();
         ENGINE_API void Clear();
         ENGINE_API void OnResize(unsigned int width, unsigned int height);
 
         ENGINE_API void SetClearColor(const Color clearColor);
+        // Sorted draws transparent objects back to front one by one, OIT batches and instances them
+        // like opaque ones and resolves with weighted blended order independent transparency
+        ENGINE_API void SetTransparencyMode(Material::TransparencyMode mode);
+        ENGINE_API Material::TransparencyMode GetTransparencyMode() const { return m_transparencyMode; }
+        ENGINE_API void SetDynamicResolution(const DynamicResolutionConfig& config);
+        ENGINE_API const DynamicResolutionConfig& GetDynamicResolution() const { return m_dynamicResolution; }
+        ENGINE_API f32 GetRenderScale() const { return m_renderScale; }
+        // Where the recorded geometry passes go, Null skips their GL submission (post-processing still runs)
+        ENGINE_API void SetBackend(RHI::BackendType type);
+        ENGINE_API RHI::BackendType GetBackendType() const { return m_backend->GetType(); }
+        // Writes the input of the frames after the next delay ones to file (views, lights, queued instances and the
+        // models they come from), grinder_replay plays it back. Queue calls with meshes of no drawable are left out
+        ENGINE_API void CaptureFrames(const path& file, u32 frames = 1, u32 delay = 0);
+        ENGINE_API bool IsCapturing() const { return m_capture != nullptr; }
+        // CPU and GPU time of each pass, GPU ones come from timestamp queries read a few frames later
+        ENGINE_API void SetPassTimingEnabled(bool enabled);
+        ENGINE_API bool IsPassTimingEnabled() const { return m_passTiming; }
+        ENGINE_API static const char* GetPassName(RenderPass pass);
         ENGINE_API void LoadSkybox(const path filepath, const std::string ext = ".png");
         ENGINE_API void LoadSkybox(const array<std::filesystem::path, 6>& faces);
 
@@ -106,8 +204,20 @@ namespace Engine {
             size_t batchCount = 0;
             size_t culledObjects = 0;
             size_t drawnObjects = 0;
+            size_t instanceBytes = 0; // per instance data uploaded for instanced draws
+            size_t instanceUpdates = 0; // resident instance slots rewritten this frame
+            size_t oitObjects = 0;
+            size_t views = 0;
+            size_t lightUpdates = 0; // lights repacked this frame
+            size_t rhiCommands = 0; // recorded by the geometry passes
+            float renderScale = 1.0f;
+            float gpuFrameMs = 0.0f;   // latest finished GPU timing, a few frames old
+            // Only filled with pass timing enabled, GPU ones are as old as gpuFrameMs
+            float passCpuMs[(size_t)RenderPass::Count] = {};
+            float passGpuMs[(size_t)RenderPass::Count] = {};
         };
         ENGINE_API const std::list<Stats>& GetStats() const { return m_Stats; }
+        ENGINE_API TextureStreamer& GetTextureStreamer() { return *m_textureStreamer; }
 
     private:
         struct ComputeShader {
@@ -117,19 +227,43 @@ namespace Engine {
         };
 
         struct DrawCommand {
-            Transform* transform;
+            WorldTransform* transform;
             Mesh* mesh;
             Material* material;
             float distanceToCamera;
         };
 
+        // Model matrix without its constant bottom row, row-major so every row is one std430 vec4
+        struct GPU_Affine {
+            vec4 rows[3];
+
+            GPU_Affine() = default;
+            explicit GPU_Affine(const mat4& m)
+                : rows{ vec4(m[0][0], m[1][0], m[2][0], m[3][0]),
+                        vec4(m[0][1], m[1][1], m[2][1], m[3][1]),
+                        vec4(m[0][2], m[1][2], m[2][2], m[3][2]) } {}
+
+            mat4 ToMat4() const { return glm::transpose(mat4(rows[0], rows[1], rows[2], vec4(0.0f, 0.0f, 0.0f, 1.0f))); }
+        };
+
+        // Position, uniform scale and the rotation quaternion as 4x snorm16
+        struct GPU_QuantizedInstance {
+            vec3 position;
+            float scale;
+            u32 rotation[2]; // (x, y), (z, w)
+
+            GPU_QuantizedInstance() = default;
+            explicit GPU_QuantizedInstance(const Transform& transform);
+        };
+
         struct BatchKey {
             Mesh* mesh;
             Material* material;
             Shader* shader;
+            bool quantized;
 
             bool operator==(const BatchKey& other) const {
-                return mesh == other.mesh && material == other.material && shader == other.shader;
+                return mesh == other.mesh && material == other.material && shader == other.shader && quantized == other.quantized;
             }
         };
 
@@ -138,20 +272,40 @@ namespace Engine {
                 size_t h1 = std::hash<void*>{}(key.mesh);
                 size_t h2 = std::hash<void*>{}(key.material);
                 size_t h3 = std::hash<void*>{}(key.shader);
-                return h1 ^ (h2 << 1) ^ (h3 << 2);
+                return h1 ^ (h2 << 1) ^ (h3 << 2) ^ (size_t)key.quantized;
             }
         };
 
+        // Indices into the frame's instance table (or the quantized table for quantized batches),
+        // packed with every other batch of every view into one index buffer starting at offset
         struct InstanceBatch {
             Mesh* mesh;
             Material* material;
-            std::vector<mat4> modelMatrices;
+            std::vector<u32> indices;
+            u32 offset = 0;
+
+            size_t size() const { return indices.size(); }
         };
+        using BatchMap = std::unordered_map<BatchKey, InstanceBatch, BatchKeyHash>;
 
         struct DrawInstance {
-            Transform* transform;
+            WorldTransform* transform;
             Mesh* mesh;
             Material* material;
+            bool quantized = false;
+            u32 quantizedSlot = 0; // into m_quantizedData
+            bool resident = false;
+            u32 slot = 0; // resident table slot, or index into m_gpuInstanceData
+        };
+
+        struct ViewState {
+            WorldTransform* transform;
+            Camera* camera;
+            vec4 viewport; // normalized
+
+            BatchMap opaqueBatches;
+            BatchMap oitBatches;
+            std::vector<DrawCommand> transparentQueue;
         };
 
         struct Frustum {
@@ -166,24 +320,38 @@ namespace Engine {
             vec4 spotAnglesRadians;
         };
 
+        // Culling input and the instance table the vertex shaders read, shared by every view. The table keeps
+        // the resident slots first and the frame's transient instances after them
         struct GPU_InstanceData {
-            mat4 modelMatrix;
+            GPU_Affine model;
             BSphere bSphere;
         };
 
+        // What a resident slot was last uploaded with, slots not queued in a frame go back to the free list
         // Camera
-        Transform* m_cameraTransform = nullptr;
+        WorldTransform* m_cameraTransform = nullptr;
         Camera* m_camera = nullptr;
         mat4 m_projViewMatrix;
         vec3 m_cameraPosition;
         vec3 m_cameraForward;
         bool m_hasCameraSet = false;
 
+        // Views, the camera members above always hold the one being drawn
+        std::vector<ViewState> m_views;
+
         // Render queues
         std::vector<DrawInstance> m_gpuInstances;
-        std::vector<GPU_InstanceData> m_gpuInstanceData;
-        std::unordered_map<BatchKey, InstanceBatch, BatchKeyHash> m_opaqueBatches;
-        std::vector<DrawCommand> m_transparentQueue;
+        std::vector<GPU_InstanceData> m_gpuInstanceData; // transient instances, uploaded whole every frame
+        std::vector<GPU_QuantizedInstance> m_quantizedData;
+        std::vector<u32> m_instanceIndices; // every batch of every view, see InstanceBatch::offset
+
+        // Geometry passes record into this and submit it to the backend when they end
+        RHI::CommandList m_commands;
+        std::unique_ptr<RHI::IBackend> m_backend;
+
+        // Transparency
+        Material::TransparencyMode m_transparencyMode = Material::TransparencyMode::Sorted;
+        bool m_oitPass = false; // material shaders write accumulation and revealage instead of color
 
         // Main render buffer
         Framebuffer* m_Framebuffer;
@@ -197,14 +365,56 @@ namespace Engine {
 
         // Culling
         ComputeShader* m_cullShader;
-        GLuint m_instanceSSBO = 0;
+        GLuint m_instanceIndexSSBO = 0;
+        GLuint m_quantizedSSBO = 0;
         GLuint m_instancesSSBO;
         GLuint m_visibilitySSBO;
         GLuint m_frustumUBO;
 
+        // Resident instance table, changed slots are uploaded as a compact delta and scattered by a compute pass
+        InstanceSlotTable m_instanceSlots;
+        std::vector<GPU_InstanceData> m_instanceTable; // CPU copy of the resident slots
+        std::vector<u32> m_deltaSlots;
+        std::vector<GPU_InstanceData> m_deltaData;
+        u32 m_residentCapacity = 0; // the transient instances start here in the GPU table
+        u32 m_transientCapacity = 0;
+        ComputeShader* m_scatterShader;
+        GLuint m_deltaSlotsSSBO = 0;
+        GLuint m_deltaDataSSBO = 0;
+
         // Tiled Deferred Light Processing
-        std::vector<std::pair<Transform*, Light*>> m_queuedLights;
-        std::vector<GPU_LightData> m_processedLights;
+        struct QueuedLight {
+            u64 key;
+            WorldTransform* transform;
+            Light* light;
+        };
+
+        // What a slot's packed data was made from, compared every frame to find the changed lights
+        struct LightSlot {
+            u64 key;
+            WorldTransform* transform;
+            Light* light;
+            mat4 modelMatrix;
+            Light source;
+            u64 lastSeen = 0;
+            bool dirty = true;
+        };
+
+        // The light buffer is persistently mapped and split in regions used round robin, a region is only
+        // written once the fence of the frame that last read it passed
+        static constexpr u32 LIGHT_BUFFER_REGIONS = 3;
+
+        std::vector<QueuedLight> m_queuedLights;
+        std::vector<LightSlot> m_lightSlots;
+        std::vector<GPU_LightData> m_lightData; // CPU copy, by slot
+        std::unordered_map<u64, u32> m_lightSlotIndex;
+        std::vector<u32> m_dirtyLights;
+        std::vector<u8> m_lightRegionStale[LIGHT_BUFFER_REGIONS]; // by slot, changed since the region was written
+        GLsync m_lightFences[LIGHT_BUFFER_REGIONS] = {};
+        u8* m_lightsMapped = nullptr;
+        size_t m_lightRegionBytes = 0;
+        u32 m_lightRegion = 0;
+        u64 m_lightFrame = 0;
         ComputeShader* m_lightCullShader;
         GLuint m_lightsSSBO;
         GLuint m_lightGridSSBO;
@@ -215,11 +425,46 @@ namespace Engine {
         std::shared_ptr<Shader> m_brightPassShader;
         std::shared_ptr<Shader> m_blurShader;
         std::shared_ptr<Shader> m_depthPrepassShader;
+        std::shared_ptr<Shader> m_oitCompositeShader;
 
         // Stats
         Stats m_stats;
         std::list<Stats> m_Stats;
 
+        // Texture streaming, fed with projected sizes of the visible instances
+        Ref<TextureStreamer> m_textureStreamer;
+        std::unordered_map<Material*, float> m_materialPixels;
+        SIMD::AffineBuffer m_worldModels; // instance models in SoA for the batched sphere transform
+        SIMD::SphereBuffer m_worldSpheres; // world space bounding spheres of this frame's instances
+
+        // Dynamic resolution, GPU timer queries are read a few frames later so they never stall
+        static constexpr u32 GPU_TIMER_QUERIES = 4;
+        DynamicResolutionConfig m_dynamicResolution;
+        f32 m_renderScale = 1.0f;
+        f32 m_gpuFrameMs = 0.0f;
+        GLuint m_gpuTimerQueries[GPU_TIMER_QUERIES] = {};
+        bool m_gpuTimerPending[GPU_TIMER_QUERIES] = {};
+        f32 m_gpuTimerScale[GPU_TIMER_QUERIES] = {}; // render scale the query was taken at
+        u32 m_gpuTimerFrame = 0;
+
+        // Pass timing, one timestamp pair per pass and view in the frame's pool
+        struct PassQueries {
+            std::vector<GLuint> queries; // begin, end
+            std::vector<RenderPass> passes; // of each pair
+            u32 used = 0; // pairs
+            bool pending = false;
+        };
+        bool m_passTiming = false;
+        PassQueries m_passQueries[GPU_TIMER_QUERIES];
+        PassQueries* m_passFrame = nullptr; // collecting this Draw, null when untimed
+        u32 m_passFrameIndex = 0;
+        u32 m_passOpen[(size_t)RenderPass::Count] = {}; // pair each pass is in
+        std::chrono::steady_clock::time_point m_passStart[(size_t)RenderPass::Count];
+        float m_passGpuMs[(size_t)RenderPass::Count] = {};
+
+        // Frame capture, see CaptureFrames
+        std::unique_ptr<RenderCaptureRecorder> m_capture;
+
         // Other
         GlState m_glState;
 
@@ -231,19 +476,50 @@ namespace Engine {
 
         // Private helper methods
         void ProcessLights();
+        static GPU_LightData PackLight(const WorldTransform& transform, const Light& light);
 
         void SetCommonUniforms(Shader* shader);
         void SetLightUniforms(Shader* shader);
         void SetMaterialUniforms(Material* material);
 
-        void DrawDepthPrepass();
-        void DrawOpaque();
-        void DrawTransparent();
+        template<typename T>
+        void RecordUniform(Shader* shader, const std::string& name, const T& value) {
+            m_commands.SetUniform(shader->GetUniformLoc(name), value);
+        }
+        void RecordShader(Shader* shader);
+        void RecordTexture(Shader* shader, const std::string& name, const Texture& texture, Shader::TextureSlot slot);
+        void RecordDraw(const Mesh& mesh, u32 instanceCount = 1);
+        void Submit();
+
+        void QueueMesh(WorldTransform* transform, Mesh* mesh, Material* material);
+
+        void BeginPass(RenderPass pass);
+        void EndPass(RenderPass pass);
+        void BeginPassTimings();
+        void ReadPassTimings();
+
+        void DrawView(ViewState& view);
+        void DrawDepthPrepass(const ViewState& view);
+        void DrawOpaque(const ViewState& view);
+        void DrawTransparent(ViewState& view);
+        void DrawTransparentOIT(const ViewState& view);
+        void DrawBatches(const BatchMap& batches);
+        bool UsesOIT(const Material& material) const;
 
         void CreateScreenQuad();
         void ExtractFrustumPlanes();
         bool IsBoxInFrustum(const BBox& bbox, const mat4& modelMatrix) const;
         void ProcessQueue();
+        u32 AcquireInstanceSlot(entity_id entity, u32 entry, const WorldTransform& transform, Mesh* mesh);
+        void UploadInstances();
+        u32 TableIndex(const DrawInstance& instance) const;
+        const GPU_InstanceData& TableData(u32 tableIndex) const;
+        void ActivateView(const ViewState& view);
+        void GetViewRect(const ViewState& view, GLint& x, GLint& y, GLsizei& width, GLsizei& height) const;
+        void BindInstances(const BatchKey& key, const InstanceBatch& batch, Shader* shader);
+
+        void UpdateRenderScale();
+        void GetRenderSize(u32& width, u32& height) const;
 
         void BeginFramebufferPass();
         void RunPostProcessPipeline();
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+#include <engine/input.hpp>
+#include <engine/renderer.hpp>
+
+#include <map>
+
+namespace Engine {
+	// Seed for any RNG that should be reproducible, particle systems and scenes take theirs from here
+	// Random outside of record/replay unless a seed was configured, derived from the base seed otherwise
+	ENGINE_API u32 RandomSeed();
+
+	// Record/replay for reproducible performance runs
+	// Record stores every frame's timestep and input events plus the base RNG seed, playback feeds
+	// them back through the input system (optionally on a fixed timestep) so two builds run the exact
+	// same frames. Any mode can dump a per-frame table of profiler sections and renderer stats
+	struct ReplayConfig {
+		enum class Mode : u8 {
+			Off, Record, Playback
+		};
+
+		Mode mode = Mode::Off;
+		path file;             // recording to write or play back
+		f32 fixedStepMs = 0.0f; // playback only, 0 plays back the recorded timesteps
+		path statsFile;        // .csv or .json, empty disables
+		bool quitAtEnd = true; // stop the application once playback runs out of frames
+		u64 seed = 0;          // base seed for off and record, 0 picks a random one. Playback uses the recording's
+	};
+
+	class Replay {
+	public:
+		ENGINE_API Replay() = default;
+		ENGINE_API ~Replay();
+
+		// Before the scene is loaded, seeds are handed out from the moment this is called
+		ENGINE_API void Configure(const ReplayConfig& config);
+		ENGINE_API const ReplayConfig& GetConfig() const { return m_Config; }
+		ENGINE_API bool IsRecording() const { return m_Config.mode == ReplayConfig::Mode::Record; }
+		ENGINE_API bool IsPlaying() const { return m_Config.mode == ReplayConfig::Mode::Playback; }
+		ENGINE_API bool IsFinished() const { return m_Finished; }
+		ENGINE_API u32 GetFrame() const { return m_Frame; }
+
+		ENGINE_API u32 NextSeed();
+
+		// Frame hooks, in Application::Run order
+		// Before the input system drains its queue: playback injects the frame's events
+		ENGINE_API void BeginFrame(InputSystem& input);
+		// Real timestep in, timestep to simulate out. inputTime is the time fixed ticks measure events against
+		ENGINE_API f32 Step(f32 deltaTime, f64& inputTime, std::span<const InputEvent> events);
+		// After the frame is submitted, appends the stats row. No renderer in headless runs, the row gets the profiler sections only
+		ENGINE_API void EndFrame(const Renderer* renderer);
+		// Writes the recording and the stats table
+		ENGINE_API void Finish();
+
+	private:
+		struct Frame {
+			f32 deltaTime = 0.0f;
+			vector<InputEvent> events; // times relative to the frame's input time
+		};
+
+		struct StatsRow {
+			u32 frame;
+			f32 deltaMs;
+			std::map<string, f64> values;
+		};
+
+		bool Load();
+		void Save() const;
+		void SaveStats() const;
+
+		ReplayConfig m_Config;
+		u64 m_BaseSeed = 0;
+		u32 m_SeedCount = 0;
+		u32 m_RecordedSeeds = 0;
+
+		vector<Frame> m_Frames;
+		u32 m_Frame = 0;
+		f64 m_Time = 0.0;  // playback clock, sum of the simulated timesteps
+		f32 m_DeltaTime = 0.0f;
+		bool m_Finished = false;
+		bool m_Saved = false;
+
+		vector<StatsRow> m_Rows;
+		vector<string> m_Columns; // in order of first appearance
+	};
+}
@@ -7,6 +7,90 @@
 namespace Engine {
     ENGINE_API std::string ReadFile(const std::filesystem::path&);
 
+    namespace LoadCfg {
+        enum class ColorFormat {
+            Auto = 0,      // Keep original format
+            Grayscale = 1,
+            GrayscaleAlpha = 2,
+            RGB = 3,
+            RGBA = 4
+        };
+
+        enum class TextureFormat {
+            Auto = 0,
+            RGB = 3,
+            RGBA = 4,
+            SRGB = 5,
+            SRGB_ALPHA = 6
+        };
+
+        enum class TextureFilter {
+            Nearest,
+            Linear,
+            NearestMipmapNearest,
+            LinearMipmapNearest,
+            NearestMipmapLinear,
+            LinearMipmapLinear
+        };
+
+        enum class TextureWrap {
+            Repeat,
+            MirroredRepeat,
+            ClampToEdge,
+            ClampToBorder
+        };
+
+        struct Image {
+            ColorFormat format = ColorFormat::RGB;
+            bool flip_vertically = false;
+
+            // Resize options (0 = no resize)
+            int width = 0;
+            int height = 0;
+            bool maintain_aspect = false;  // If one dimension is 0, calculate from aspect ratio
+
+            bool srgb = true;              // Color data, resampled in linear light
+            bool generate_mipmaps = false; // Fill Image::mips on the loading thread
+        };
+
+        // Has to inherit in a stupid way, sorry
+        struct Texture {
+            ColorFormat format = ColorFormat::RGB;
+            TextureFormat texFormat = TextureFormat::Auto;
+            bool flip_vertically = false;
+
+            // Resize options (0 = no resize)
+            int width = 0;
+            int height = 0;
+            bool maintain_aspect = false;  // If one dimension is 0, calculate from aspect ratio
+
+            TextureFilter min_filter = TextureFilter::LinearMipmapLinear;
+            TextureFilter mag_filter = TextureFilter::Linear;
+            TextureWrap wrap_s = TextureWrap::Repeat;
+            TextureWrap wrap_t = TextureWrap::Repeat;
+            bool generate_mipmaps = true;
+        };
+
+        struct Model {
+            bool normalize = false; // doesn't work currently
+            bool static_mesh = false;
+            bool flip_uvs = true;
+        };
+
+        // The part of the texture streamer's config decode needs to cook big textures, taken on the main thread
+        // since decode runs on the streaming workers. Disabled cooks nothing
+        struct TextureCooking {
+            bool enabled = false;
+            u32 tailSize = 64;
+            path cacheDir;
+        };
+
+        struct Shader {
+            optional<path> vertex_shader_filepath = std::nullopt;
+            optional<path> fragment_shader_filepath = std::nullopt;
+        };
+    }
+
     struct IResource {
     public:
         ENGINE_API virtual ~IResource() = default;
@@ -45,20 +129,35 @@ namespace Engine {
         ENGINE_API void Enable();
         ENGINE_API ~Shader();
     private:
-        unordered_map<std::string, u32> m_CacheLoc;
+        void BuildUniformCache() const;
+
+        mutable unordered_map<std::string, u32> m_CacheLoc; // filled on first use
     };
 
     struct Image : public IResource {
     public:
         int width = 0, height = 0, channels = 0;
         unsigned char* data = nullptr;
+        vector<vector<unsigned char>> mips; // levels 1..N of the mip chain, level 0 is data
+
+        // Builds the full chain on the CPU, meant for loader threads so the upload doesn't need glGenerateMipmap
+        ENGINE_API void GenerateMips(bool srgb = true);
         
         ENGINE_API ~Image();
     };
 
+    // Separable polyphase resampler, filters in linear light with premultiplied alpha
+    // and splits rows across OpenMP threads
+    namespace Resample {
+        ENGINE_API void Resize(const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst, int dstWidth, int dstHeight, int channels, bool srgb = true);
+        ENGINE_API u32 MipCount(int width, int height);
+    }
+
     struct Texture : IResource {
         u32 id = 0;
-        int width = 0, height = 0;
+        int width = 0, height = 0; // full resolution, even when streamed textures only hold coarser levels
+        u32 levels = 1;            // mip levels of the full chain
+        u32 baseLevel = 0;         // finest level in VRAM, GL level 0 of id is this one
 
         Texture() = default;
         ENGINE_API Texture(const Image& img);
@@ -78,6 +177,11 @@ namespace Engine {
             UNLIT, LIT, TEXTURED, EMMISIVE
         };
 
+        // How transparent materials get composited, Default follows Renderer::SetTransparencyMode
+        enum class TransparencyMode : u8 {
+            Default, Sorted, OIT
+        };
+
         glm::vec3 diffuseColor{ 1.0f };
         glm::vec3 specularColor{ 1.0f };
         float shininess = 32.0f;
@@ -87,6 +191,7 @@ namespace Engine {
         RenderType renderType;
         bool isTransparent;
         float opacity = 1.0f;
+        TransparencyMode transparencyMode = TransparencyMode::Default;
 
         std::shared_ptr<Texture> diffuse;
         std::shared_ptr<Texture> specular;
@@ -113,6 +218,7 @@ namespace Engine {
         u32 vbo = 0;
         u32 ebo = 0;
         u32 indicesCount = 0;
+        u32 verticesCount = 0;
 
         BBox bbox;
         BSphere bsphere;
@@ -121,6 +227,7 @@ namespace Engine {
         ENGINE_API void Draw() const;
 
         ENGINE_API Mesh(std::vector<Vertex>& vertices, std::vector<u32>& indices);
+        ENGINE_API Mesh(std::vector<Vertex>& vertices, std::vector<u32>& indices, const BBox& bounds);
         ENGINE_API ~Mesh();
     };
 
@@ -132,7 +239,7 @@ namespace Engine {
         };
 
         struct BlueprintNode {
-            string name;
+            Component::Name name; // interned once here, instances share it
             entity_id parent; // model relative parent
             unsigned int collectionIndex;
             Component::Transform transform;
@@ -145,89 +252,65 @@ namespace Engine {
 
         std::vector<BlueprintNode> blueprint;
         BBox bounds;
+        LoadCfg::Model loadCfg; // what it was decoded with, the mesh and collection layout depends on it
         
         // We'll have ECS::Instantiate(entity_id parent = null, Component::Transform transform = Component::Transform(), Model& model)
         ENGINE_API ~Model() = default;
     };
 
-    namespace Component {
-        struct Drawable3D {
-            std::shared_ptr<Model> model;
-            u32 collectionIndex;
-            ENGINE_API const Model::MeshCollection& GetCollection() const;
-        };
-    }
-
-    namespace LoadCfg {
-        enum class ColorFormat {
-            Auto = 0,      // Keep original format
-            Grayscale = 1,
-            GrayscaleAlpha = 2,
-            RGB = 3,
-            RGBA = 4
-        };
-
-        enum class TextureFormat {
-            Auto = 0,
-            RGB = 3,
-            RGBA = 4,
-            SRGB = 5,
-            SRGB_ALPHA = 6
+    // CPU side result of decoding a model file, no GL objects in here
+    // Safe to build off the main thread, turned into a Model by ResourceLoader::upload
+    struct ModelData {
+        struct MeshData {
+            std::vector<Vertex> vertices;
+            std::vector<u32> indices;
+            BBox bounds; // filled during conversion, Mesh doesn't recompute it
         };
 
-        enum class TextureFilter {
-            Nearest,
-            Linear,
-            NearestMipmapNearest,
-            LinearMipmapNearest,
-            NearestMipmapLinear,
-            LinearMipmapLinear
+        struct TextureData {
+            std::shared_ptr<Image> image; // null = use default asset
+            std::string cacheKey; // non-empty for embedded textures
+            optional<path> cooked; // mip chain written for texture streaming
         };
 
-        enum class TextureWrap {
-            Repeat,
-            MirroredRepeat,
-            ClampToEdge,
-            ClampToBorder
+        struct MaterialData {
+            glm::vec3 diffuseColor{ 1.0f };
+            glm::vec3 specularColor{ 1.0f };
+            float shininess = 32.0f;
+            float emmisiveIntensity = 0.0f;
+            glm::vec3 emmisiveColor{ 0.0f };
+            float opacity = 1.0f;
+            bool isTransparent = false;
+            bool isEmmisive = false;
+
+            // Indexed by Shader::TextureSlot
+            std::array<TextureData, 4> textures;
+            std::string cacheKey;
         };
 
-        struct Image {
-            ColorFormat format = ColorFormat::RGB;
-            bool flip_vertically = false;
-
-            // Resize options (0 = no resize)
-            int width = 0;
-            int height = 0;
-            bool maintain_aspect = false;  // If one dimension is 0, calculate from aspect ratio
+        struct NodeData {
+            string name;
+            entity_id parent;
+            Component::Transform transform;
+            std::vector<std::pair<u32, u32>> entries; // mesh index, material index
         };
 
-        // Has to inherit in a stupid way, sorry
-        struct Texture {
-            ColorFormat format = ColorFormat::RGB;
-            TextureFormat texFormat = TextureFormat::Auto;
-            bool flip_vertically = false;
-
-            // Resize options (0 = no resize)
-            int width = 0;
-            int height = 0;
-            bool maintain_aspect = false;  // If one dimension is 0, calculate from aspect ratio
-
-            TextureFilter min_filter = TextureFilter::LinearMipmapLinear;
-            TextureFilter mag_filter = TextureFilter::Linear;
-            TextureWrap wrap_s = TextureWrap::Repeat;
-            TextureWrap wrap_t = TextureWrap::Repeat;
-            bool generate_mipmaps = true;
-        };
+        std::filesystem::path path;
+        LoadCfg::Model cfg;
+        std::vector<MeshData> meshes;
+        std::vector<MaterialData> materials;
+        std::vector<NodeData> nodes;
+        BBox bounds;
 
-        struct Model {
-            bool normalize = false; // doesn't work currently
-            bool static_mesh = false;
-            bool flip_uvs = true;
-        };
+        ENGINE_API size_t GetByteSize() const;
+        ENGINE_API static BBox CombineBounds(const std::vector<MeshData>& meshes);
+    };
 
-        struct Shader {
-            optional<path> vertex_shader_filepath = std::nullopt;
-            optional<path> fragment_shader_filepath = std::nullopt;
+    namespace Component {
+        struct Drawable3D {
+            std::shared_ptr<Model> model;
+            u32 collectionIndex;
+            ENGINE_API const Model::MeshCollection& GetCollection() const;
         };
     }
 
@@ -236,6 +319,21 @@ namespace Engine {
         ENGINE_API std::shared_ptr<Texture> load(const std::filesystem::path& path, const LoadCfg::Texture& cfg = LoadCfg::Texture());
         ENGINE_API std::shared_ptr<Shader> load(const std::filesystem::path& path, const LoadCfg::Shader& cfg = LoadCfg::Shader());
         ENGINE_API std::shared_ptr<Model> load(const std::filesystem::path& path, const LoadCfg::Model& cfg = LoadCfg::Model());
+
+        // Split model loading, decode touches no GL, ResourceSystem or Application state so it can run on any thread
+        ENGINE_API std::shared_ptr<ModelData> decode(const std::filesystem::path& path, const LoadCfg::Model& cfg = LoadCfg::Model(),
+            const LoadCfg::TextureCooking& cooking = LoadCfg::TextureCooking());
+        ENGINE_API std::shared_ptr<Model> upload(ModelData& data); // main thread only
+        // Snapshot of the renderer's texture streaming config for decode, main thread only
+        ENGINE_API LoadCfg::TextureCooking textureCooking();
+
+        // Native glTF 2.0 / GLB path of decode, null when the file needs something only Assimp handles
+        ENGINE_API std::shared_ptr<ModelData> decodeGLTF(const std::filesystem::path& path, const LoadCfg::Model& cfg = LoadCfg::Model());
+
+        // Off for headless runs, set before anything loads. Meshes keep their counts and bounds, textures their size
+        // (read from the header, no decode or mips) and shaders stay unlinked, none of them own GL objects
+        ENGINE_API void setGpuUpload(bool enabled);
+        ENGINE_API bool isGpuUploadEnabled();
     }
 
     // Traits to get config type for each resource
@@ -297,10 +395,22 @@ namespace Engine {
             m_cache[key] = resource;
         }
 
+        // Cache lookup without loading, null if missing
+        template<typename T>
+        std::shared_ptr<T> find(const std::filesystem::path& path) {
+            if (auto it = m_cache.find(makeCacheKey<T>(path)); it != m_cache.end())
+                return std::static_pointer_cast<T>(it->second);
+            return nullptr;
+        }
+
         ENGINE_API void clear() {
             m_cache.clear();
         }
 
+        // Drops entries only the cache still holds, path has to start with prefix
+        // Runs until nothing changes since materials keep their textures alive
+        ENGINE_API size_t evict_unused(const std::string& prefix = "");
+
         ENGINE_API std::unordered_map<std::string, std::shared_ptr<IResource>>& get_cache() { return m_cache; }
 
     private:
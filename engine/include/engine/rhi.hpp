@@ -0,0 +1,112 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+
+namespace Engine::RHI {
+    // Thin layer between the renderer and the graphics API. The renderer records what it draws into a CommandList
+    // and a backend executes it: GL for real, Null only counts, so the CPU side of the renderer can be measured and
+    // exercised without any driver work in the way
+
+    enum class CommandType : u8 {
+        BindPipeline,     // a: program
+        BindVertexArray,  // a: vertex array
+        BindTexture,      // a: unit, b: 2D texture
+        BindStorageRange, // a: binding, b: buffer, c: offset, d: size in bytes
+        SetInt,           // a: location, b: value
+        SetFloat,         // a: location, b: payload offset, the same for the vector and matrix ones
+        SetVec3,
+        SetVec4,
+        SetMat4,
+        DrawIndexed,      // a: index count (u32 triangles), b: instance count
+        Count
+    };
+
+    // 20 bytes, the bigger uniform values live in the list's payload
+    struct Command {
+        CommandType type;
+        u32 a = 0, b = 0, c = 0, d = 0;
+    };
+
+    class CommandList {
+    public:
+        void BindPipeline(u32 program) { Push(CommandType::BindPipeline, program); }
+        void BindVertexArray(u32 vertexArray) { Push(CommandType::BindVertexArray, vertexArray); }
+        void BindTexture(u32 unit, u32 texture) { Push(CommandType::BindTexture, unit, texture); }
+        void BindStorageRange(u32 binding, u32 buffer, u32 offset, u32 size) { Push(CommandType::BindStorageRange, binding, buffer, offset, size); }
+
+        void SetUniform(u32 location, int v) { Push(CommandType::SetInt, location, (u32)v); }
+        void SetUniform(u32 location, f32 v) { Push(CommandType::SetFloat, location, PushPayload(&v, 1)); }
+        void SetUniform(u32 location, const vec3& v) { Push(CommandType::SetVec3, location, PushPayload(glm::value_ptr(v), 3)); }
+        void SetUniform(u32 location, const vec4& v) { Push(CommandType::SetVec4, location, PushPayload(glm::value_ptr(v), 4)); }
+        void SetUniform(u32 location, const mat4& v) { Push(CommandType::SetMat4, location, PushPayload(glm::value_ptr(v), 16)); }
+
+        void DrawIndexed(u32 indexCount, u32 instanceCount = 1) { Push(CommandType::DrawIndexed, indexCount, instanceCount); }
+
+        void Clear() {
+            m_Commands.clear();
+            m_Payload.clear();
+        }
+
+        size_t Size() const { return m_Commands.size(); }
+        bool Empty() const { return m_Commands.empty(); }
+        const vector<Command>& Commands() const { return m_Commands; }
+        const f32* Payload(u32 offset) const { return m_Payload.data() + offset; }
+
+    private:
+        void Push(CommandType type, u32 a = 0, u32 b = 0, u32 c = 0, u32 d = 0) {
+            m_Commands.push_back(Command{ type, a, b, c, d });
+        }
+
+        u32 PushPayload(const f32* data, u32 count) {
+            const u32 offset = (u32)m_Payload.size();
+            m_Payload.insert(m_Payload.end(), data, data + count);
+            return offset;
+        }
+
+        vector<Command> m_Commands;
+        vector<f32> m_Payload;
+    };
+
+    enum class BackendType : u8 {
+        GL, Null
+    };
+
+    class IBackend {
+    public:
+        virtual ~IBackend() = default;
+        ENGINE_API virtual void Execute(const CommandList& commands) = 0;
+        ENGINE_API virtual BackendType GetType() const = 0;
+    };
+
+    // Needs the GL context current, skips binds that repeat the previous one within a list
+    class GLBackend : public IBackend {
+    public:
+        ENGINE_API void Execute(const CommandList& commands) override;
+        ENGINE_API BackendType GetType() const override { return BackendType::GL; }
+    };
+
+    // Touches no API, only counts what it was given
+    class NullBackend : public IBackend {
+    public:
+        struct Counters {
+            u64 commands = 0;
+            u64 draws = 0;
+            u64 instances = 0;
+            u64 indices = 0; // over all instances
+            u64 byType[(size_t)CommandType::Count] = {};
+        };
+
+        ENGINE_API void Execute(const CommandList& commands) override;
+        ENGINE_API BackendType GetType() const override { return BackendType::Null; }
+
+        const Counters& GetCounters() const { return m_Counters; }
+        void Reset() { m_Counters = Counters{}; }
+
+    private:
+        Counters m_Counters;
+    };
+
+    ENGINE_API std::unique_ptr<IBackend> CreateBackend(BackendType type);
+    ENGINE_API const char* GetBackendName(BackendType type);
+}
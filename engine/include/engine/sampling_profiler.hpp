@@ -0,0 +1,32 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+
+namespace Engine::SamplingProfiler {
+	// Statistical profiler for whatever the PERF sections don't cover: scene modules, the driver, third party code.
+	// Linux walks frame pointers from a SIGPROF handler on every thread that burns CPU (x86-64 and arm64), Windows
+	// suspends and unwinds the thread that started the capture from a sampler thread. Once the capture ends the stacks
+	// are symbolized with backward-cpp and written as folded stacks ("thread;root;...;leaf count" lines), what
+	// flamegraph.pl and speedscope read
+	struct Config {
+		u32 frequencyHz = 1000;
+		u32 frames = 120; // capture window in Application::Run frames, 0 runs until Stop
+		path output = "profile.folded";
+	};
+
+	ENGINE_API bool IsSupported();
+
+	// Ends a running capture first
+	ENGINE_API bool Start(const Config& config);
+	// Ends the capture and writes the folded stacks
+	ENGINE_API void Stop();
+	ENGINE_API bool IsRunning();
+	// Once per frame, stops after the configured window
+	ENGINE_API void OnFrame();
+
+	// Of the running capture, or the last one
+	ENGINE_API u64 GetSampleCount();
+	ENGINE_API u64 GetDroppedCount(); // buffer full or the stack couldn't be read
+	ENGINE_API const path& GetLastOutput();
+}
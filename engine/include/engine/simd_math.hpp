@@ -0,0 +1,143 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+
+namespace Engine::SIMD {
+	// Batched math over SoA streams, scalar/SSE4/AVX2 kernels picked at startup from what the CPU supports
+	// Every kernel is elementwise, outputs may alias their inputs
+
+	enum class Level : u8 {
+		Scalar, SSE4, AVX2
+	};
+
+	ENGINE_API Level GetLevel();
+	ENGINE_API Level GetSupportedLevel();
+	// Clamped to what the CPU supports, for comparing the paths
+	ENGINE_API void SetLevel(Level level);
+	ENGINE_API const char* GetLevelName(Level level);
+
+	// Stream pointers of one batch, element i of every stream belongs together
+	struct TRSArrays {
+		f32* px; f32* py; f32* pz;
+		f32* qx; f32* qy; f32* qz; f32* qw;
+		f32* sx; f32* sy; f32* sz;
+	};
+
+	// Affine 3x4, row-major: m[row * 4 + column], the bottom row is always 0 0 0 1
+	struct AffineArrays {
+		f32* m[12];
+	};
+
+	struct SphereArrays {
+		f32* cx; f32* cy; f32* cz; f32* r;
+	};
+
+	struct QuatArrays {
+		f32* x; f32* y; f32* z; f32* w;
+	};
+
+	// translate(p) * mat4_cast(q) * scale(s)
+	ENGINE_API void ComposeTRS(const TRSArrays& in, const AffineArrays& out, size_t count);
+	// parents[i] * locals[i]
+	ENGINE_API void MultiplyAffine(const AffineArrays& parents, const AffineArrays& locals, const AffineArrays& out, size_t count);
+	// World center and radius scaled by the largest axis scale
+	ENGINE_API void TransformSpheres(const AffineArrays& models, const SphereArrays& in, const SphereArrays& out, size_t count);
+	// glm::slerp per element, shortest path, t per element
+	ENGINE_API void SlerpQuats(const QuatArrays& a, const QuatArrays& b, const f32* t, const QuatArrays& out, size_t count);
+	// out[i] += in[i] * weight, plain arrays without padding (the resampler's filter taps)
+	ENGINE_API void ScaleAdd(const f32* in, f32 weight, f32* out, size_t count);
+
+	// Storage for Streams SoA streams in one allocation, grows but never shrinks
+	template<u32 Streams>
+	class SoABuffer {
+	public:
+		void Resize(size_t count) {
+			m_Count = count;
+			// Padded so the full width loads of the last group stay in bounds of every stream
+			size_t stride = (count + 7) & ~size_t(7);
+			if (stride > m_Stride) {
+				m_Stride = stride;
+				m_Storage.resize(m_Stride * Streams);
+			}
+		}
+
+		size_t Size() const { return m_Count; }
+		f32* Stream(u32 stream) { return m_Storage.data() + stream * m_Stride; }
+
+	protected:
+		vector<f32> m_Storage;
+		size_t m_Stride = 0;
+		size_t m_Count = 0;
+	};
+
+	class TRSBuffer : public SoABuffer<10> {
+	public:
+		TRSArrays Arrays() {
+			return { Stream(0), Stream(1), Stream(2), Stream(3), Stream(4), Stream(5), Stream(6), Stream(7), Stream(8), Stream(9) };
+		}
+
+		void Set(size_t i, const vec3& position, const quat& rotation, const vec3& scale) {
+			Stream(0)[i] = position.x; Stream(1)[i] = position.y; Stream(2)[i] = position.z;
+			Stream(3)[i] = rotation.x; Stream(4)[i] = rotation.y; Stream(5)[i] = rotation.z; Stream(6)[i] = rotation.w;
+			Stream(7)[i] = scale.x; Stream(8)[i] = scale.y; Stream(9)[i] = scale.z;
+		}
+	};
+
+	class AffineBuffer : public SoABuffer<12> {
+	public:
+		AffineArrays Arrays() {
+			AffineArrays arrays;
+			for (u32 i = 0; i < 12; i++) arrays.m[i] = Stream(i);
+			return arrays;
+		}
+
+		void Set(size_t i, const mat4& m) {
+			for (u32 row = 0; row < 3; row++)
+				for (u32 column = 0; column < 4; column++)
+					Stream(row * 4 + column)[i] = m[column][row];
+		}
+
+		void SetIdentity(size_t i) {
+			for (u32 j = 0; j < 12; j++) Stream(j)[i] = (j == 0 || j == 5 || j == 10) ? 1.0f : 0.0f;
+		}
+
+		// Row-major 3x4 rows, the layout the renderer uploads instances in
+		void SetRows(size_t i, const vec4 rows[3]) {
+			for (u32 row = 0; row < 3; row++)
+				for (u32 column = 0; column < 4; column++)
+					Stream(row * 4 + column)[i] = rows[row][column];
+		}
+
+		mat4 Get(size_t i) {
+			mat4 m(1.0f);
+			for (u32 row = 0; row < 3; row++)
+				for (u32 column = 0; column < 4; column++)
+					m[column][row] = Stream(row * 4 + column)[i];
+			return m;
+		}
+	};
+
+	class SphereBuffer : public SoABuffer<4> {
+	public:
+		SphereArrays Arrays() { return { Stream(0), Stream(1), Stream(2), Stream(3) }; }
+
+		void Set(size_t i, const vec3& center, f32 radius) {
+			Stream(0)[i] = center.x; Stream(1)[i] = center.y; Stream(2)[i] = center.z; Stream(3)[i] = radius;
+		}
+
+		vec3 Center(size_t i) { return { Stream(0)[i], Stream(1)[i], Stream(2)[i] }; }
+		f32 Radius(size_t i) { return Stream(3)[i]; }
+	};
+
+	class QuatBuffer : public SoABuffer<4> {
+	public:
+		QuatArrays Arrays() { return { Stream(0), Stream(1), Stream(2), Stream(3) }; }
+
+		void Set(size_t i, const quat& q) {
+			Stream(0)[i] = q.x; Stream(1)[i] = q.y; Stream(2)[i] = q.z; Stream(3)[i] = q.w;
+		}
+
+		quat Get(size_t i) { return quat(Stream(3)[i], Stream(0)[i], Stream(1)[i], Stream(2)[i]); }
+	};
+}
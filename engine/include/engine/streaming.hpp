@@ -0,0 +1,138 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+#include <engine/ecs.hpp>
+#include <engine/resource.hpp>
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+
+namespace Engine {
+	// World partitioned into a grid of cells on the XZ plane
+	// Cells around the main camera get decoded on worker threads, instantiated in time-sliced batches
+	// on the main thread and destroyed again once the camera is far enough (load/unload radius = hysteresis)
+	struct StreamingConfig {
+		f32 cellSize = 64.0f;
+		f32 loadRadius = 128.0f;
+		f32 unloadRadius = 192.0f; // > loadRadius, otherwise cells on the edge thrash
+		u32 workerThreads = 2;
+		f32 frameBudgetMs = 2.0f; // main thread upload + instantiate time per frame
+	};
+
+	struct CellCoord {
+		i32 x = 0;
+		i32 z = 0;
+
+		bool operator<(const CellCoord& other) const { return x != other.x ? x < other.x : z < other.z; }
+		bool operator==(const CellCoord& other) const { return x == other.x && z == other.z; }
+	};
+
+	class StreamingSystem : public ISystem {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		enum class CellState : u8 {
+			Unloaded, Loading, Instantiating, Resident
+		};
+
+		struct CellObject {
+			path model;
+			LoadCfg::Model cfg;
+			Component::Transform transform;
+		};
+
+		// Telemetry, latencies are in ms and only valid after the cell got that far
+		struct CellStats {
+			size_t cpuBytes = 0;     // decoded data that went through the workers
+			size_t gpuBytes = 0;     // vertex/index buffers + textures of the models the cell uses
+			f32 decodeMs = 0.0f;     // request -> decoded
+			f32 instantiateMs = 0.0f; // decoded -> resident
+			u32 entities = 0;
+			u32 frames = 0;          // frames spent instantiating
+			u32 loads = 0;           // times this cell became resident
+		};
+
+		struct Cell {
+			CellCoord coord;
+			CellState state = CellState::Unloaded;
+			vector<CellObject> objects;
+			entity_id root = null;
+			CellStats stats;
+
+			// Internal bookkeeping
+			u32 generation = 0;
+			size_t nextObject = 0;
+			unordered_map<string, Ref<ModelData>> decoded;
+			unordered_map<string, Ref<Model>> models; // keeps models alive while resident
+			clock::time_point requested;
+			clock::time_point decodedAt;
+		};
+
+		ENGINE_API StreamingSystem(ECS& ecs);
+		ENGINE_API ~StreamingSystem();
+
+		ENGINE_API void Configure(const StreamingConfig& config);
+		ENGINE_API const StreamingConfig& GetConfig() const { return m_Config; }
+
+		// Registers a model placement, the cell is picked from the transform position
+		ENGINE_API void AddObject(const path& model, const Component::Transform& transform, const LoadCfg::Model& cfg = LoadCfg::Model());
+		// Unloads everything and forgets all cells
+		ENGINE_API void Clear();
+
+		// Overrides the main camera as the streaming focus
+		ENGINE_API void SetFocus(optional<vec3> focus) { m_Focus = focus; }
+
+		ENGINE_API optional<vector<entity_id>> Update(f32 deltaTime) override;
+		ENGINE_API void PostUpdate() override;
+
+		ENGINE_API const std::map<CellCoord, Cell>& GetCells() const { return m_Cells; }
+		ENGINE_API size_t GetPendingJobs();
+
+	private:
+		struct Job {
+			CellCoord coord;
+			u32 generation;
+			vector<std::pair<path, LoadCfg::Model>> models;
+			LoadCfg::TextureCooking cooking; // taken when the cell is requested, the workers don't touch the renderer
+		};
+
+		struct JobResult {
+			CellCoord coord;
+			u32 generation;
+			unordered_map<string, Ref<ModelData>> decoded;
+			size_t bytes;
+			clock::time_point finished;
+		};
+
+		CellCoord ToCell(const vec3& position) const;
+		f32 DistanceToCell(const CellCoord& coord, const vec3& point) const;
+		optional<vec3> FindFocus();
+
+		void StartWorkers();
+		void StopWorkers();
+		void WorkerLoop();
+
+		void RequestCell(Cell& cell);
+		void UnloadCell(Cell& cell);
+		void CollectResults();
+		void InstantiateCells(const vec3& focus);
+
+		StreamingConfig m_Config;
+		std::map<CellCoord, Cell> m_Cells;
+		optional<vec3> m_Focus;
+
+		// Worker side, guarded by m_Mutex
+		vector<std::thread> m_Workers;
+		std::deque<Job> m_Jobs;
+		vector<JobResult> m_Results;
+		std::mutex m_Mutex;
+		std::condition_variable m_Signal;
+		bool m_Stop = false;
+	};
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <engine/api.hpp>
+#include <engine/types.hpp>
+#include <engine/resource.hpp>
+#include <glad/glad.h>
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace Engine {
+	// Streamed textures start with only the tail of their mip chain in VRAM, finer levels are read back
+	// from a cooked mip file on worker threads once the renderer sees them big enough on screen
+	struct TextureStreamingConfig {
+		bool enabled = true;
+		path cacheDir = "cache/textures";
+		size_t budgetBytes = 512ull * 1024 * 1024; // VRAM for streamed textures, tails always fit
+		u32 tailSize = 64;           // levels this size or smaller are always resident
+		u32 workerThreads = 1;
+		u32 maxUploadsPerFrame = 4;
+		u32 idleFrames = 120;        // after this long without a request only the tail is wanted
+		f32 lodBias = 0.0f;          // > 0 settles for coarser levels
+	};
+
+	class TextureStreamer {
+	public:
+		struct Stats {
+			u32 textures = 0;
+			u32 pending = 0;          // reads queued or in flight
+			size_t residentBytes = 0;
+			size_t wantedBytes = 0;   // what we'd have resident without a budget
+			u32 uploads = 0;          // last frame
+			u32 evictions = 0;        // total
+		};
+
+		ENGINE_API TextureStreamer();
+		ENGINE_API ~TextureStreamer();
+
+		ENGINE_API void Configure(const TextureStreamingConfig& config);
+		ENGINE_API TextureStreamingConfig GetConfig(); // copy, loader threads read it too
+
+		// Any thread, writes the image with its full mip chain to cacheDir and returns the file
+		// An up to date file (newer than source) is reused as is
+		ENGINE_API static optional<path> Cook(const Image& image, const string& key, const path& cacheDir, const path& source);
+
+		// Main thread, uploads only the tail levels of image, the rest comes from cooked on demand
+		ENGINE_API Ref<Texture> Create(const Image& image, const path& cooked);
+
+		// Renderer, called for every visible use of a texture this frame with its projected size in pixels
+		ENGINE_API void Request(const Texture* texture, f32 screenPixels);
+
+		// Main thread, once per frame after the requests: uploads finished reads, queues new ones, evicts over budget
+		ENGINE_API void Update();
+
+		ENGINE_API const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Entry {
+			std::weak_ptr<Texture> texture;
+			path cooked;
+			int width = 0, height = 0;  // level 0
+			u32 levels = 1;             // full chain
+			u32 tailLevel = 0;          // coarsest level we ever drop to
+			u32 wantedLevel = 0;
+			GLenum imgFormat = 0;
+			GLenum texFormat = 0;
+			f32 requestedPixels = 0.0f; // max over this frame
+			u64 lastRequested = 0;
+			bool pending = false;
+		};
+
+		struct Job {
+			const Texture* key;
+			std::weak_ptr<Texture> texture;
+			path cooked;
+			u32 first, last; // [first, last)
+		};
+
+		struct JobResult {
+			const Texture* key;
+			std::weak_ptr<Texture> texture;
+			u32 first;
+			vector<vector<u8>> levels; // empty on failure
+		};
+
+		void StartWorkers();
+		void StopWorkers();
+		void WorkerLoop();
+
+		// Swaps tex to fresh storage starting at newBase, keeps the levels both have and uploads newLevels on top
+		void Reallocate(Entry& entry, Texture& texture, u32 newBase, const vector<vector<u8>>* newLevels);
+		size_t LevelBytes(const Entry& entry, u32 level) const;
+		size_t ResidentBytes(const Entry& entry, u32 base) const;
+
+		TextureStreamingConfig m_Config;
+		std::mutex m_ConfigMutex;
+
+		unordered_map<const Texture*, Entry> m_Entries;
+		vector<JobResult> m_Ready; // read but waiting for an upload slot
+		u64 m_Frame = 0;
+		Stats m_Stats;
+
+		// Worker side, guarded by m_Mutex
+		vector<std::thread> m_Workers;
+		std::deque<Job> m_Jobs;
+		vector<JobResult> m_Results;
+		std::mutex m_Mutex;
+		std::condition_variable m_Signal;
+		bool m_Stop = false;
+	};
+}
@@ -4,12 +4,15 @@
 // No heavy includes, only forward decls for external libs
 // ...well this aged poorly
 
+#include <engine/api.hpp>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <string>
+#include <string_view>
 #include <list>
 #include <vector>
 #include <array>
@@ -164,13 +167,22 @@ namespace Engine {
     using entity_id = u32; // entity id type, please use
     constexpr entity_id null = 0xFFFFFFFF; // entity_id that represents no entity
 
+    // Global string table, every distinct string is stored once for the life of the process and handed out as a 32 bit handle
+    namespace Names {
+        ENGINE_API u32 Intern(std::string_view str);
+        // Handle of an already interned string without adding it, 0 when it never was
+        ENGINE_API u32 Find(std::string_view str);
+        // Valid for the life of the process, handles are never freed
+        ENGINE_API const string& Get(u32 handle);
+        ENGINE_API size_t Count();
+    }
+
     namespace Component {
-        // Default initialized to identity values
+        // Local TRS, the part gameplay and tweens write. Default initialized to identity values
         struct Transform {
             vec3 position{ 0.0f };
             quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
             vec3 scale{ 1.0f };
-            mat4 modelMatrix{ 1.0f };
 
             // Local direction vectors
             vec3 Forward() const {
@@ -186,6 +198,29 @@ namespace Engine {
             }
         };
 
+        // World matrix of a Transform, written by the TransformSystem and read by rendering
+        // Kept in its own pool so neither side pulls the other's half through the cache
+        struct WorldTransform {
+            mat4 modelMatrix{ 1.0f };
+
+            vec3 Position() const {
+                return vec3(modelMatrix[3]);
+            }
+
+            // World direction vectors, same conventions as the local ones
+            vec3 Forward() const {
+                return glm::normalize(vec3(modelMatrix * vec4(0.0f, 0.0f, -1.0f, 0.0f)));
+            }
+
+            vec3 Right() const {
+                return glm::normalize(vec3(modelMatrix[0]));
+            }
+
+            vec3 Up() const {
+                return glm::normalize(vec3(modelMatrix[1]));
+            }
+        };
+
         // No default initialization, please tread carefully
         struct Hierarchy {
             entity_id parent;
@@ -246,12 +281,21 @@ namespace Engine {
             }
         };
 
+        // Interned, all entities with the same name share one string. Rename through ECS::SetName so the name index follows
         struct Name {
-            string name;
+            u32 id = 0; // Names handle, 0 is the empty string
+
+            Name() = default;
+            explicit Name(std::string_view name) : id{ Names::Intern(name) } {}
+
+            const string& str() const { return Names::Get(id); }
+            bool operator==(const Name& other) const { return id == other.id; }
         };
 
         struct Camera {
             bool isMain = false;
+            bool isExtraView = false; // drawn after the main camera into viewport, e.g. split screen or a minimap
+            vec4 viewport = vec4(0.0f, 0.0f, 1.0f, 1.0f); // normalized x, y, width, height of the output
             mat4 viewMatrix = mat4(1.0f);
             mat4 projectionMatrix = mat4(1.0f);
 
@@ -294,6 +338,14 @@ namespace Engine {
         };
     }
 
+    // Zero storage markers, a bit in the entity's tag mask instead of a component pool (ECS::AddTag, View::With/Without)
+    namespace Tag {
+        struct Static {}; // never moves after spawning
+        struct Hidden {}; // kept alive and updated, just not drawn
+        struct Disabled {}; // neither drawn nor lit nor used as a camera
+        struct Culled {}; // outside of everything that looks at it, for gameplay that wants to know
+    }
+
     struct BBox {
         glm::vec3 min;
         glm::vec3 max;
@@ -28,6 +28,9 @@ namespace Engine {
 		ENGINE_API ~Window();
 
 		ENGINE_API void OnUpdate();
+		// OnUpdate in two halves, for callers that want input polled at the start of the frame
+		ENGINE_API void PollEvents();
+		ENGINE_API void SwapBuffers();
 
 		ENGINE_API unsigned int GetWidth() const { return m_Data.Width; }
 		ENGINE_API unsigned int GetHeight() const { return m_Data.Height; }
@@ -0,0 +1,182 @@
+#include <engine/access_check.hpp>
+#include <engine/log.hpp>
+#include <engine/exception.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace Engine::AccessCheck {
+	struct Site {
+		const char* file = nullptr;
+		u32 line = 0;
+		const char* function = nullptr;
+
+		bool Valid() const { return file != nullptr; }
+	};
+
+	// First site of each kind of access a thread made to a pool in the current phase
+	struct PoolAccess {
+		Site read;
+		Site write;
+	};
+
+	// One per thread that ever recorded, owned by s_Threads so EndPhase can still read it after the thread is gone
+	struct ThreadLog {
+		u32 index = 0;
+		u64 phase = 0;
+		std::mutex mutex; // only contended while EndPhase reads it
+		std::unordered_map<std::type_index, PoolAccess> pools;
+	};
+
+	struct Iteration {
+		u32 count = 0;
+		u32 thread = 0; // the one that started the oldest live iteration
+	};
+
+	static std::atomic<bool> s_Enabled{ false };
+	static std::atomic<bool> s_Fatal{ false };
+	static std::atomic<u64> s_Conflicts{ 0 };
+	static std::atomic<u64> s_Phase{ 1 };
+	static const char* s_PhaseName = "none";
+
+	static std::mutex s_Mutex; // s_Threads, s_Iterations, s_Reported
+	static vector<std::unique_ptr<ThreadLog>> s_Threads;
+	static std::unordered_map<std::type_index, Iteration> s_Iterations;
+	static std::unordered_set<string> s_Reported;
+
+	static ThreadLog& GetThreadLog() {
+		thread_local ThreadLog* log = nullptr;
+		if (!log) {
+			std::lock_guard lock(s_Mutex);
+			s_Threads.push_back(std::make_unique<ThreadLog>());
+			log = s_Threads.back().get();
+			log->index = (u32)s_Threads.size() - 1;
+		}
+		return *log;
+	}
+
+	static Site ToSite(const std::source_location& where) {
+		return Site{ where.file_name(), (u32)where.line(), where.function_name() };
+	}
+
+	// "struct Engine::Component::Transform" -> "Transform", same as the ECS pool telemetry
+	static string TypeName(std::type_index type) {
+		string name = type.name();
+		size_t start = name.find_last_of(": ");
+		return start == string::npos ? name : name.substr(start + 1);
+	}
+
+	static string Describe(const Site& site) {
+		return fmt::format("{}:{} ({})", site.file, site.line, site.function);
+	}
+
+	// Caller holds s_Mutex, key makes sure each distinct conflict is reported once
+	static void Report(const string& key, const string& message) {
+		if (!s_Reported.insert(key).second) return;
+		s_Conflicts.fetch_add(1, std::memory_order_relaxed);
+		Log::error("ECS access conflict: {}", message);
+		if (s_Fatal.load(std::memory_order_relaxed)) ENGINE_THROW("ECS access conflict: " + message);
+	}
+
+	void SetEnabled(bool enabled) {
+		s_Enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool IsEnabled() {
+		return s_Enabled.load(std::memory_order_relaxed);
+	}
+
+	void SetFatal(bool fatal) {
+		s_Fatal.store(fatal, std::memory_order_relaxed);
+	}
+
+	u64 GetConflictCount() {
+		return s_Conflicts.load(std::memory_order_relaxed);
+	}
+
+	void BeginPhase(const char* name) {
+		if (!IsEnabled()) return;
+		std::lock_guard lock(s_Mutex);
+		s_PhaseName = name;
+		// Threads drop what they recorded for older phases the next time they record
+		s_Phase.fetch_add(1, std::memory_order_release);
+	}
+
+	void EndPhase() {
+		if (!IsEnabled()) return;
+		std::lock_guard lock(s_Mutex);
+		const u64 phase = s_Phase.load(std::memory_order_acquire);
+
+		struct Toucher {
+			u32 thread;
+			PoolAccess access;
+		};
+		std::unordered_map<std::type_index, vector<Toucher>> touched;
+		for (auto& log : s_Threads) {
+			std::lock_guard threadLock(log->mutex);
+			if (log->phase != phase) continue;
+			for (auto& [pool, access] : log->pools)
+				touched[pool].push_back({ log->index, access });
+		}
+
+		for (auto& [pool, touchers] : touched) {
+			if (touchers.size() < 2) continue;
+			auto writer = std::find_if(touchers.begin(), touchers.end(), [](const Toucher& t) { return t.access.write.Valid(); });
+			if (writer == touchers.end()) continue; // readers only, that's fine
+
+			const Toucher& other = writer == touchers.begin() ? touchers[1] : touchers.front();
+			const bool otherWrites = other.access.write.Valid();
+			const Site& otherSite = otherWrites ? other.access.write : other.access.read;
+
+			string key = fmt::format("{}|{}|{}:{}|{}:{}", s_PhaseName, pool.name(), writer->access.write.file, writer->access.write.line, otherSite.file, otherSite.line);
+			Report(key, fmt::format("{} written by thread #{} at {} and {} by thread #{} at {} during phase '{}'",
+				TypeName(pool), writer->thread, Describe(writer->access.write),
+				otherWrites ? "written" : "read", other.thread, Describe(otherSite), s_PhaseName));
+		}
+	}
+
+	void Record(std::type_index pool, Access access, const std::source_location& where) {
+		if (!IsEnabled()) return;
+		ThreadLog& log = GetThreadLog();
+		std::lock_guard lock(log.mutex);
+
+		const u64 phase = s_Phase.load(std::memory_order_acquire);
+		if (log.phase != phase) {
+			log.pools.clear();
+			log.phase = phase;
+		}
+
+		PoolAccess& entry = log.pools[pool];
+		Site& site = access == Access::Write ? entry.write : entry.read;
+		if (!site.Valid()) site = ToSite(where);
+	}
+
+	void RecordStructural(std::type_index pool, const std::source_location& where) {
+		if (!IsEnabled()) return;
+		Record(pool, Access::Write, where);
+		const u32 thread = GetThreadLog().index;
+
+		std::lock_guard lock(s_Mutex);
+		auto it = s_Iterations.find(pool);
+		if (it == s_Iterations.end() || it->second.count == 0) return;
+
+		const Site site = ToSite(where);
+		Report(fmt::format("iter|{}|{}:{}", pool.name(), site.file, site.line),
+			fmt::format("{} added to or removed from at {} on thread #{} while thread #{} iterates it",
+				TypeName(pool), Describe(site), thread, it->second.thread));
+	}
+
+	void BeginIteration(std::type_index pool) {
+		const u32 thread = GetThreadLog().index;
+		std::lock_guard lock(s_Mutex);
+		Iteration& iteration = s_Iterations[pool];
+		if (iteration.count++ == 0) iteration.thread = thread;
+	}
+
+	void EndIteration(std::type_index pool) {
+		std::lock_guard lock(s_Mutex);
+		auto it = s_Iterations.find(pool);
+		if (it != s_Iterations.end() && it->second.count > 0) it->second.count--;
+	}
+}
@@ -1,6 +1,9 @@
 #include <engine/application.hpp>
 #include <engine/log.hpp>
 #include <engine/perf_profiler.hpp>
+#include <engine/streaming.hpp>
+#include <engine/access_check.hpp>
+#include <engine/sampling_profiler.hpp>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -14,13 +17,83 @@ static void glfw_resize_callback(GLFWwindow* window, int width, int height) {
 namespace Engine {
 	static Application* g_Application_Instance = nullptr;
 
+	// Series the main loop touches every frame, looked up once
+	struct FrameMetrics {
+		Counter& frames;
+		Histogram& frameMs;
+		Histogram& gpuFrameMs;
+		Counter& drawCallsTotal;
+		Gauge& drawCalls;
+		Gauge& instancedDrawCalls;
+		Gauge& objects;
+		Gauge& culled;
+		Gauge& drawn;
+		Gauge& batches;
+		Gauge& instanceBytes;
+		Gauge& instanceUpdates;
+		Gauge& views;
+		Gauge& lightUpdates;
+		Gauge& renderScale;
+
+		FrameMetrics(MetricsRegistry& registry)
+			: frames{ registry.GetCounter("grinder_frames_total", "Frames rendered") }
+			, frameMs{ registry.GetHistogram("grinder_frame_ms", "CPU frame time in milliseconds", { 4, 8, 12, 16.7, 20, 25, 33.3, 50, 100 }) }
+			, gpuFrameMs{ registry.GetHistogram("grinder_gpu_frame_ms", "GPU frame time in milliseconds", { 2, 4, 8, 12, 16.7, 25, 33.3, 50 }) }
+			, drawCallsTotal{ registry.GetCounter("grinder_draw_calls_total", "Draw calls issued") }
+			, drawCalls{ registry.GetGauge("grinder_draw_calls", "Draw calls in the last frame") }
+			, instancedDrawCalls{ registry.GetGauge("grinder_instanced_draw_calls", "Instanced draw calls in the last frame") }
+			, objects{ registry.GetGauge("grinder_render_objects", "Objects submitted in the last frame") }
+			, culled{ registry.GetGauge("grinder_culled_objects", "Objects culled in the last frame") }
+			, drawn{ registry.GetGauge("grinder_drawn_objects", "Objects drawn in the last frame") }
+			, batches{ registry.GetGauge("grinder_batches", "Instanced batches in the last frame") }
+			, instanceBytes{ registry.GetGauge("grinder_instance_bytes", "Instance data uploaded in the last frame") }
+			, instanceUpdates{ registry.GetGauge("grinder_instance_updates", "Resident instance slots rewritten in the last frame") }
+			, views{ registry.GetGauge("grinder_views", "Views rendered in the last frame") }
+			, lightUpdates{ registry.GetGauge("grinder_light_updates", "Lights repacked in the last frame") }
+			, renderScale{ registry.GetGauge("grinder_render_scale", "Dynamic resolution scale") } {}
+
+		void Publish(f32 frameMsValue, const Renderer::Stats& stats) {
+			frames.Add();
+			frameMs.Observe(frameMsValue);
+			if (stats.gpuFrameMs > 0.0f) gpuFrameMs.Observe(stats.gpuFrameMs);
+			drawCallsTotal.Add(stats.drawCalls + stats.instancedDrawCalls);
+			drawCalls.Set((f64)stats.drawCalls);
+			instancedDrawCalls.Set((f64)stats.instancedDrawCalls);
+			objects.Set((f64)stats.totalObjects);
+			culled.Set((f64)stats.culledObjects);
+			drawn.Set((f64)stats.drawnObjects);
+			batches.Set((f64)stats.batchCount);
+			instanceBytes.Set((f64)stats.instanceBytes);
+			instanceUpdates.Set((f64)stats.instanceUpdates);
+			views.Set((f64)stats.views);
+			lightUpdates.Set((f64)stats.lightUpdates);
+			renderScale.Set(stats.renderScale);
+		}
+	};
+
 	Application::Application(std::shared_ptr<Window> window, std::shared_ptr<VFS> vfs, std::shared_ptr<ResourceSystem> rs, std::shared_ptr<ECS> ecs)
 		: m_Vfs{ vfs }, m_Rs{ rs }, m_Ecs{ ecs }, m_Window{ window } {
 		g_Application_Instance = this;
 		m_Renderer = std::make_shared<Renderer>();
+		m_FramePacer = std::make_shared<FramePacer>();
+		m_Input = std::make_shared<InputSystem>(m_Window->GetNativeWindow());
+		m_Replay = std::make_shared<Replay>();
+		m_Metrics = std::make_shared<MetricsRegistry>();
+		m_MetricsExporter = std::make_shared<MetricsExporter>(*m_Metrics);
 		Log::trace("Initializing Grinder Application");
 	}
 
+	Application::Application(std::shared_ptr<VFS> vfs, std::shared_ptr<ResourceSystem> rs, std::shared_ptr<ECS> ecs, const HeadlessConfig& headless)
+		: m_Vfs{ vfs }, m_Rs{ rs }, m_Ecs{ ecs }, m_Headless{ true }, m_HeadlessConfig{ headless } {
+		g_Application_Instance = this;
+		ResourceLoader::setGpuUpload(false);
+		m_Input = std::make_shared<InputSystem>(nullptr);
+		m_Replay = std::make_shared<Replay>();
+		m_Metrics = std::make_shared<MetricsRegistry>();
+		m_MetricsExporter = std::make_shared<MetricsExporter>(*m_Metrics);
+		Log::trace("Initializing headless Grinder Application");
+	}
+
 	void Application::Run() {
 		// Default GL state variables
 		using clock = std::chrono::steady_clock;
@@ -32,51 +105,181 @@ namespace Engine {
 		vector<entity_id> updatedEntities = m_Ecs->GetSystem<TransformSystem>()->Update(fixedDelta).value_or(std::vector<entity_id>());
 		m_Ecs->GetSystem<TransformSystem>()->PostUpdate();
 
+		FrameMetrics metrics(*m_Metrics);
+		float slowMetricsTimer = 0.0f;
+		const auto startTime = clock::now();
+		u32 frames = 0;
+		f64 simulatedTime = 0.0;
+
 		while (m_Running) {
+			// Wait for the GPU and the limiter first, then poll so the frame runs on the freshest input
+			if (!m_Headless) {
+				m_FramePacer->BeginFrame();
+				m_Window->PollEvents();
+				m_FramePacer->MarkInputSampled();
+			}
+			m_Replay->BeginFrame(*m_Input);
+			m_Input->BeginFrame();
+
 			PERF_BEGIN("Time_Full");
-			if (glfwWindowShouldClose(m_Window->GetNativeWindow()))
-				m_Running = false;
+			if (!m_Headless) {
+				if (glfwWindowShouldClose(m_Window->GetNativeWindow()))
+					m_Running = false;
 
-			if (m_Window->HasResized()) {
-				OnResize(m_Window->GetWidth(), m_Window->GetHeight());
+				if (m_Window->HasResized()) {
+					OnResize(m_Window->GetWidth(), m_Window->GetHeight());
+				}
 			}
 			
 			// Compute time delta
 			auto now = clock::now();
+			f64 inputNow = m_Input->Now();
 			float deltaTime = std::chrono::duration<float>(now - lastTime).count();
 			lastTime = now;
+			if (m_Headless && m_HeadlessConfig.fixedStepMs > 0.0f)
+				deltaTime = m_HeadlessConfig.fixedStepMs / 1000.0f;
+			deltaTime = m_Replay->Step(deltaTime, inputNow, m_Input->GetFrameEvents());
 			accumulator = std::min(accumulator + deltaTime, fixedDelta * 5.0f); // cap to prevent infinite fixed updates while debugging
+			simulatedTime += deltaTime;
 
 			// Clear screen
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			if (!m_Headless)
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 			
 			PERF_BEGIN("Update_Fixed");
+			ECS_PHASE_BEGIN("Update_Fixed");
 			while (accumulator >= fixedDelta) {
+				// The tick simulates up to where the accumulator says, it gets the input from before that
+				m_Input->BeginFixedTick(inputNow - (accumulator - fixedDelta));
 				for (ILayer* layer : m_LayerStack)
 					layer->OnUpdateFixed(fixedDelta);
 				accumulator -= fixedDelta;
 			}
+			ECS_PHASE_END();
 			PERF_END("Update_Fixed");
 
 			PERF_BEGIN("Update");
+			ECS_PHASE_BEGIN("Update");
 			for (ILayer* layer : m_LayerStack)
 				layer->OnUpdate(deltaTime);
+			ECS_PHASE_END();
 			PERF_END("Update");
 
+			PERF_BEGIN("Streaming");
+			ECS_PHASE_BEGIN("Streaming");
+			m_Ecs->GetSystem<StreamingSystem>()->Update(deltaTime);
+			ECS_PHASE_END();
+			PERF_END("Streaming");
+
 			PERF_BEGIN("Simulation");
+			ECS_PHASE_BEGIN("Simulation");
 			vector<entity_id> updatedEntities = m_Ecs->GetSystem<TransformSystem>()->Update(deltaTime).value_or(std::vector<entity_id>());
 			m_Ecs->GetSystem<TransformSystem>()->PostUpdate();
+			ECS_PHASE_END();
 			PERF_END("Simulation");
 
-			PERF_BEGIN("Render_Total");
-			for (auto it = m_LayerStack.begin(); it != m_LayerStack.end(); ++it) {
-				ILayer* layer = *it;
-				layer->OnRender(updatedEntities);
-			}
-			PERF_END("Render_Total");
+			if (!m_Headless) {
+				if (m_FramePacer->LateLatch()) {
+					PERF_BEGIN("LateLatch");
+					ECS_PHASE_BEGIN("LateLatch");
+					LatchCamera(updatedEntities);
+					ECS_PHASE_END();
+					PERF_END("LateLatch");
+				}
 
-			m_Window->OnUpdate();
+				PERF_BEGIN("Render_Total");
+				ECS_PHASE_BEGIN("Render_Total");
+				for (auto it = m_LayerStack.begin(); it != m_LayerStack.end(); ++it) {
+					ILayer* layer = *it;
+					layer->OnRender(updatedEntities);
+				}
+				ECS_PHASE_END();
+				PERF_END("Render_Total");
+
+				m_Window->SwapBuffers();
+				m_FramePacer->EndFrame();
+			}
 			PERF_END("Time_Full");
+
+			const f32 frameMs = std::chrono::duration<f32, std::milli>(clock::now() - now).count();
+			if (m_Headless) {
+				metrics.frames.Add();
+				metrics.frameMs.Observe(frameMs);
+			}
+			else if (!m_Renderer->GetStats().empty())
+				metrics.Publish(frameMs, m_Renderer->GetStats().front());
+			slowMetricsTimer += deltaTime;
+			if (slowMetricsTimer >= 1.0f) {
+				slowMetricsTimer = 0.0f;
+				UpdateSlowMetrics();
+			}
+
+			m_Replay->EndFrame(m_Renderer.get());
+			if (m_Replay->IsFinished() && m_Replay->GetConfig().quitAtEnd)
+				m_Running = false;
+			SamplingProfiler::OnFrame();
+
+			frames++;
+			if (m_Headless && m_HeadlessConfig.frames > 0 && frames >= m_HeadlessConfig.frames)
+				m_Running = false;
+		}
+		m_Replay->Finish();
+		SamplingProfiler::Stop();
+
+		if (m_Headless) {
+			const f64 seconds = std::chrono::duration<f64>(clock::now() - startTime).count();
+			Log::info("Simulated {} frames ({:.2f} s of game time) in {:.2f} s, {:.3f} ms per frame",
+				frames, simulatedTime, seconds, frames > 0 ? seconds * 1000.0 / frames : 0.0);
+		}
+	}
+
+	void Application::LatchCamera(vector<entity_id>& updatedEntities) {
+		// Only what the callbacks touched is queued, usually the camera and its children
+		std::shared_ptr<TransformSystem> transforms = m_Ecs->GetSystem<TransformSystem>();
+		vector<entity_id> moved = transforms->Update(0.0f).value_or(vector<entity_id>());
+		transforms->PostUpdate();
+		updatedEntities.insert(updatedEntities.end(), moved.begin(), moved.end());
+
+		const entity_id camera = m_FramePacer->GetLatchedCamera();
+		if (camera == null || !m_Ecs->Exists(camera) || !m_Ecs->HasComponent<Component::Camera>(camera)) return;
+		m_Ecs->GetComponent<Component::Camera>(camera).viewMatrix = glm::inverse(m_Ecs->GetComponent<Component::WorldTransform>(camera).modelMatrix);
+	}
+
+	void Application::UpdateSlowMetrics() {
+		m_Metrics->GetGauge("grinder_entities", "Live entities").Set((f64)m_Ecs->GetEntityCount());
+		for (auto& [pool, size] : m_Ecs->GetPoolSizes())
+			m_Metrics->GetGauge("grinder_pool_entities", "Entities per component pool", "pool=\"" + pool + "\"").Set((f64)size);
+
+		// Rough sizes, same estimate the streaming stats use: RGBA8 textures with mips, vertex + index buffers
+		struct Totals { size_t count = 0, bytes = 0; };
+		std::map<string, Totals> totals{ { "texture", {} }, { "image", {} }, { "model", {} }, { "shader", {} }, { "other", {} } };
+		for (auto& [key, resource] : m_Rs->get_cache()) {
+			if (const Texture* texture = dynamic_cast<const Texture*>(resource.get())) {
+				totals["texture"].count++;
+				totals["texture"].bytes += (size_t)std::max(1, texture->width >> texture->baseLevel) * std::max(1, texture->height >> texture->baseLevel) * 4 * 4 / 3;
+			}
+			else if (const Image* image = dynamic_cast<const Image*>(resource.get())) {
+				totals["image"].count++;
+				totals["image"].bytes += (size_t)image->width * image->height * image->channels;
+				for (const auto& mip : image->mips)
+					totals["image"].bytes += mip.size();
+			}
+			else if (const Model* model = dynamic_cast<const Model*>(resource.get())) {
+				totals["model"].count++;
+				for (const Mesh& mesh : model->meshes)
+					totals["model"].bytes += (size_t)mesh.verticesCount * sizeof(Vertex) + (size_t)mesh.indicesCount * sizeof(u32);
+			}
+			else if (dynamic_cast<const Shader*>(resource.get())) {
+				totals["shader"].count++;
+			}
+			else {
+				totals["other"].count++;
+			}
+		}
+		for (auto& [type, total] : totals) {
+			string labels = "type=\"" + type + "\"";
+			m_Metrics->GetGauge("grinder_resource_count", "Cached resources", labels).Set((f64)total.count);
+			m_Metrics->GetGauge("grinder_resource_bytes", "Estimated memory of cached resources", labels).Set((f64)total.bytes);
 		}
 	}
 
@@ -113,6 +316,6 @@ namespace Engine {
 	}
 
 	ENGINE_API void Application::OnResize(unsigned int width, unsigned int height) {
-		m_Renderer->OnResize(width, height);
+		if (m_Renderer) m_Renderer->OnResize(width, height);
 	}
 }
\ No newline at end of file
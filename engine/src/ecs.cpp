@@ -1,6 +1,7 @@
 #include <engine/ecs.hpp>
 #include <engine/exception.hpp>
 #include <engine/resource.hpp>
+#include <engine/streaming.hpp>
 
 namespace Engine {
 	struct ECSImpl {
@@ -11,6 +12,18 @@ namespace Engine {
 		// Component Management: Maps a component's type_index to its storage pool.
 		std::unordered_map<std::type_index, std::unique_ptr<detail::IComponentPool>> m_ComponentPools;
 
+		// Query Management: Every cached query by its type, and the queries each component type takes part in.
+		std::unordered_map<std::type_index, std::unique_ptr<detail::QueryBase>> m_Queries;
+		std::unordered_map<std::type_index, std::vector<detail::QueryBase*>> m_ComponentQueries;
+
+		// Name Management: Entities by interned name, maintained as Name components come and go.
+		bool m_NameIndexEnabled = true;
+		std::unordered_map<u32, std::vector<entity_id>> m_NameIndex;
+		std::vector<entity_id> m_NameScratch; // FindByName result without the index
+
+		// Tag Management: Maps a tag's type_index to its bit in the tag masks.
+		std::unordered_map<std::type_index, u64> m_TagBits;
+
 		// System Management: Maps a system's type_index to its instance.
 		std::unordered_map<std::type_index, std::shared_ptr<ISystem>> m_Systems;
 
@@ -22,17 +35,59 @@ namespace Engine {
 			}
 			return it->second.get();
 		}
+
+		void IndexName(u32 name, entity_id entity) {
+			if (m_NameIndexEnabled) m_NameIndex[name].push_back(entity);
+		}
+
+		void UnindexName(u32 name, entity_id entity) {
+			if (!m_NameIndexEnabled) return;
+			auto it = m_NameIndex.find(name);
+			if (it == m_NameIndex.end()) return;
+			std::vector<entity_id>& entities = it->second;
+			auto found = std::find(entities.begin(), entities.end(), entity);
+			if (found != entities.end()) {
+				*found = entities.back();
+				entities.pop_back();
+			}
+			if (entities.empty()) m_NameIndex.erase(it);
+		}
+
+		// Whether the entity has everything the query asks for
+		bool Matches(const detail::QueryBase& query, entity_id entity) {
+			for (const std::type_index& type : query.Types()) {
+				detail::IComponentPool* pool = GetPool(type);
+				if (!pool || !pool->Has(entity)) return false;
+			}
+			return true;
+		}
+
+		// Keep the queries over this component type in step with an add or remove
+		void UpdateQueries(entity_id entity, std::type_index type, bool added) {
+			auto it = m_ComponentQueries.find(type);
+			if (it == m_ComponentQueries.end()) return;
+			for (detail::QueryBase* query : it->second) {
+				if (!added) query->Erase(entity);
+				else if (Matches(*query, entity)) query->Insert(entity);
+			}
+		}
 	};
 
 	ECS::ECS() : m_Impl(std::make_unique<ECSImpl>()) {
 		// Register default components and systems
 		RegisterComponent<Component::Transform>();
+		RegisterComponent<Component::WorldTransform>();
 		RegisterComponent<Component::Hierarchy>();
 		RegisterComponent<Component::Light>();
 		RegisterComponent<Component::Drawable3D>();
 		RegisterComponent<Component::Name>();
 		RegisterComponent<Component::Camera>();
+		RegisterTag<Tag::Static>();
+		RegisterTag<Tag::Hidden>();
+		RegisterTag<Tag::Disabled>();
+		RegisterTag<Tag::Culled>();
 		RegisterSystem<TransformSystem>();
+		RegisterSystem<StreamingSystem>();
 	}
 
 	ECS::~ECS() = default;
@@ -51,12 +106,14 @@ namespace Engine {
 		return id;
 	}
 
-	entity_id ECS::CreateEntity3D(entity_id parent, Component::Transform transform, const std::string& name) {
+	entity_id ECS::CreateEntity3D(entity_id parent, Component::Transform transform, const std::string& name, const std::source_location& where) {
 		// Create a base entity with a unique ID.
 		const entity_id id = CreateEntity();
 
 		// Add a default Transform component, as all 3D entities have one.
-		AddComponent(id, transform);
+		// The world matrix lives in its own pool, the TransformSystem fills it in.
+		AddComponent(id, transform, where);
+		AddComponent(id, Component::WorldTransform{}, where);
 
 		// Create and configure the Hierarchy component based on the parent.
 		Component::Hierarchy hierarchy = { null, null, null, null, 0 }; // default initialized to a root element
@@ -84,11 +141,11 @@ namespace Engine {
 		}
 
 		// Add the fully configured Hierarchy component to the new entity.
-		AddComponent(id, hierarchy);
+		AddComponent(id, hierarchy, where);
 
 		// Add a name if provided
 		if (name.size() != 0) {
-			AddComponent(id, Component::Name{ .name = name });
+			AddComponent(id, Component::Name(name), where);
 		}
 
 		// Enqueue for update, since user will most likely modify entity
@@ -171,7 +228,7 @@ namespace Engine {
 		GetSystem<TransformSystem>()->Enqueue(entity);
 	}
 
-	void ECS::DestroyEntity(entity_id entity, bool recurse) {
+	void ECS::DestroyEntity(entity_id entity, bool recurse, const std::source_location& where) {
 		if (!Exists(entity))
 			return;
 
@@ -180,7 +237,7 @@ namespace Engine {
 			entity_id child = hierarchy.first_child;
 			while (child != null) {
 				entity_id next = GetComponent<Component::Hierarchy>(child).next_sibling;
-				DestroyEntity(child, true); // recurse downwards
+				DestroyEntity(child, true, where); // recurse downwards
 				child = next;
 			}
 		}
@@ -213,9 +270,17 @@ namespace Engine {
 				GetComponent<Component::Hierarchy>(hierarchy_to_destroy.next_sibling).prev_sibling = hierarchy_to_destroy.prev_sibling;
 		}
 
-		// Wipe out components
-		for (auto const& [type, pool] : m_Impl->m_ComponentPools)
+		// Wipe out components and tags
+		if (HasComponent<Component::Name>(entity))
+			m_Impl->UnindexName(GetComponent<Component::Name>(entity).id, entity);
+		for (auto const& [type, pool] : m_Impl->m_ComponentPools) {
+			if (pool->Has(entity)) ECS_STRUCTURAL(type, where);
 			pool->OnEntityDestroyed(entity);
+		}
+		for (auto const& [type, query] : m_Impl->m_Queries)
+			query->Erase(entity);
+		if (entity < m_TagMasks.size())
+			m_TagMasks[entity] = 0;
 
 		// Recycle the entity ID
 		m_Impl->m_FreeEntitySet.insert(entity);
@@ -233,6 +298,9 @@ namespace Engine {
 		detail::IComponentPool* pool = m_Impl->GetPool(type);
 		if (!pool) ENGINE_THROW("Component type not registered.");
 		pool->Add(entity, pData);
+		if (type == std::type_index(typeid(Component::Name)))
+			m_Impl->IndexName(static_cast<Component::Name*>(pData)->id, entity);
+		m_Impl->UpdateQueries(entity, type, true);
 	}
 
 	void* ECS::GetComponentImpl(entity_id entity, std::type_index type) {
@@ -244,7 +312,10 @@ namespace Engine {
 	void ECS::RemoveComponentImpl(entity_id entity, std::type_index type) {
 		detail::IComponentPool* pool = m_Impl->GetPool(type);
 		if (!pool) ENGINE_THROW("Component type not registered.");
+		if (type == std::type_index(typeid(Component::Name)) && pool->Has(entity))
+			m_Impl->UnindexName(static_cast<Component::Name*>(pool->Get(entity))->id, entity);
 		pool->Remove(entity);
+		m_Impl->UpdateQueries(entity, type, false);
 	}
 
 	bool ECS::HasComponentImpl(entity_id entity, std::type_index type) {
@@ -261,6 +332,97 @@ namespace Engine {
 		return pool;
 	}
 
+	// --- Name Implementation ---
+	void ECS::SetName(entity_id entity, std::string_view name) {
+		if (HasComponent<Component::Name>(entity)) RemoveComponent<Component::Name>(entity);
+		if (!name.empty()) AddComponent(entity, Component::Name(name));
+	}
+
+	const vector<entity_id>& ECS::FindByName(std::string_view name) {
+		static const vector<entity_id> none;
+		// Never interned means no entity can have it, and nothing gets added to the table by looking
+		const u32 id = Names::Find(name);
+		if (id == 0) return none;
+
+		if (m_Impl->m_NameIndexEnabled) {
+			auto it = m_Impl->m_NameIndex.find(id);
+			return it != m_Impl->m_NameIndex.end() ? it->second : none;
+		}
+
+		m_Impl->m_NameScratch.clear();
+		for (auto [entity, entityName] : View<Component::Name>()) {
+			if (entityName.id == id) m_Impl->m_NameScratch.push_back(entity);
+		}
+		return m_Impl->m_NameScratch;
+	}
+
+	entity_id ECS::FindEntity(std::string_view name) {
+		const vector<entity_id>& entities = FindByName(name);
+		return entities.empty() ? null : entities.front();
+	}
+
+	void ECS::SetNameIndexEnabled(bool enabled) {
+		if (enabled == m_Impl->m_NameIndexEnabled) return;
+		m_Impl->m_NameIndex.clear();
+		m_Impl->m_NameIndexEnabled = enabled;
+		if (!enabled) return;
+
+		// Rebuilt from the pool, whatever happened while it was off
+		for (auto [entity, name] : View<Component::Name>())
+			m_Impl->IndexName(name.id, entity);
+	}
+
+	// --- Query Implementation ---
+	detail::QueryBase* ECS::GetQueryImpl(std::type_index type) {
+		auto it = m_Impl->m_Queries.find(type);
+		return it == m_Impl->m_Queries.end() ? nullptr : it->second.get();
+	}
+
+	detail::QueryBase* ECS::AddQueryImpl(std::type_index type, std::unique_ptr<detail::QueryBase> query) {
+		if (m_Impl->m_Queries.find(type) != m_Impl->m_Queries.end()) ENGINE_THROW("Query already registered.");
+
+		// Seed it from the smallest pool, the one full scan this query will ever do
+		detail::IComponentPool* smallest = nullptr;
+		for (const std::type_index& component : query->Types()) {
+			detail::IComponentPool* pool = GetPoolImpl(component);
+			if (!smallest || pool->Size() < smallest->Size()) smallest = pool;
+		}
+		for (size_t i = 0; i < smallest->Size(); i++) {
+			entity_id entity = smallest->DenseToEntity(i);
+			if (m_Impl->Matches(*query, entity)) query->Insert(entity);
+		}
+
+		detail::QueryBase* result = query.get();
+		for (const std::type_index& component : query->Types())
+			m_Impl->m_ComponentQueries[component].push_back(result);
+		m_Impl->m_Queries[type] = std::move(query);
+		return result;
+	}
+
+	// --- Tag Implementation ---
+	void ECS::RegisterTagImpl(std::type_index type) {
+		if (m_Impl->m_TagBits.find(type) != m_Impl->m_TagBits.end()) ENGINE_THROW("Tag type already registered.");
+		if (m_Impl->m_TagBits.size() >= 64) ENGINE_THROW("Out of tag bits, at most 64 tag types can be registered.");
+		m_Impl->m_TagBits[type] = 1ull << m_Impl->m_TagBits.size();
+	}
+
+	u64 ECS::TagBitImpl(std::type_index type) const {
+		auto it = m_Impl->m_TagBits.find(type);
+		if (it == m_Impl->m_TagBits.end()) ENGINE_THROW("Tag not registered");
+		return it->second;
+	}
+
+	void ECS::SetTagsImpl(entity_id entity, u64 bits, bool set) {
+		if (!Exists(entity)) ENGINE_THROW("Tagging an entity that doesn't exist.");
+		if (entity >= m_TagMasks.size()) {
+			if (!set) return;
+			// Same growth as the component pools' sparse arrays
+			m_TagMasks.resize((entity * 2) + 1, 0);
+		}
+		if (set) m_TagMasks[entity] |= bits;
+		else m_TagMasks[entity] &= ~bits;
+	}
+
 	// --- System Implementation ---
 	void ECS::RegisterSystemImpl(std::type_index type, std::shared_ptr<ISystem> system) {
 		if (m_Impl->m_Systems.find(type) != m_Impl->m_Systems.end()) ENGINE_THROW("System type already registered.");
@@ -279,14 +441,16 @@ namespace Engine {
 		auto transformSystem = GetSystem<TransformSystem>();
 		if (!transformSystem) ENGINE_THROW("TransformSystem is not registered.");
 
-		// Get the actual Transform component data from its pool.
+		// Get the actual Transform component data from its pools.
 		auto& transformComponent = GetComponent<Component::Transform>(entity);
+		auto& worldComponent = GetComponent<Component::WorldTransform>(entity);
 
 		// Return a reference with some other bound information
 		return RefTransform(
 			*this,
 			entity,
 			transformComponent,
+			worldComponent,
 			*transformSystem
 		);
 	}
@@ -296,7 +460,23 @@ namespace Engine {
 		return entity < m_Impl->m_NextEntityID && !m_Impl->m_FreeEntitySet.contains(entity);
 	}
 
-	entity_id ECS::Instantiate(entity_id parent, Component::Transform rootTransform, std::shared_ptr<Model> model) {
+	size_t ECS::GetEntityCount() const {
+		return m_Impl->m_NextEntityID - m_Impl->m_FreeEntitySet.size();
+	}
+
+	vector<std::pair<string, size_t>> ECS::GetPoolSizes() const {
+		vector<std::pair<string, size_t>> sizes;
+		sizes.reserve(m_Impl->m_ComponentPools.size());
+		for (auto& [type, pool] : m_Impl->m_ComponentPools) {
+			// "struct Engine::Component::Transform" -> "Transform"
+			string name = type.name();
+			size_t start = name.find_last_of(": ");
+			sizes.emplace_back(start == string::npos ? name : name.substr(start + 1), pool->Size());
+		}
+		return sizes;
+	}
+
+	entity_id ECS::Instantiate(entity_id parent, Component::Transform rootTransform, std::shared_ptr<Model> model, const std::source_location& where) {
 		if (!model) ENGINE_THROW("Trying to instantiate non-existant model");
 
 		// Keep track of mapping from blueprint node index → actual entity
@@ -310,7 +490,6 @@ namespace Engine {
 			// Combine blueprint transform with the instantiation root if this is the root node
 			Component::Transform worldTransform = bp.transform;
 			if (bp.parent == null) {
-				// worldTransform.modelMatrix = rootTransform.modelMatrix * worldTransform.modelMatrix;
 				worldTransform = rootTransform;
 			}
 
@@ -319,7 +498,7 @@ namespace Engine {
 				? entityMap[bp.parent]
 				: parent;
 
-			entity_id entity = CreateEntity3D(parentEntity, worldTransform);
+			entity_id entity = CreateEntity3D(parentEntity, worldTransform, "", where);
 			entityMap[i] = entity;
 
 			if (bp.parent == null)
@@ -333,9 +512,9 @@ namespace Engine {
 						.model = model,
 						.collectionIndex = bp.collectionIndex
 					};
-					AddComponent<Component::Drawable3D>(entity, drawable);
+					AddComponent<Component::Drawable3D>(entity, drawable, where);
 				}
-				AddComponent<Component::Name>(entity, Component::Name{.name = bp.name});
+				AddComponent<Component::Name>(entity, bp.name, where); // interned at load, nothing to allocate here
 			}
 
 			// Step 3: schedule transform system update
@@ -378,41 +557,44 @@ namespace Engine {
 		// We use an index-based loop because the m_DepthBuckets vector can and will grow during iteration
 		// as we enqueue children from parent transforms.
 		for (size_t depth = 0; depth < m_DepthBuckets.size(); ++depth) {
-			const auto& bucket = m_DepthBuckets[depth];
-
-			// Process every entity that has been marked dirty at this depth level.
-			for (entity_id entity : bucket) {
+			// Gather the live entities of this level first, children enqueued below land in deeper buckets
+			m_Batch.clear();
+			for (entity_id entity : m_DepthBuckets[depth]) {
 				// Check if entity is still valid
-				if (!m_Ecs->Exists(entity)) continue;
-
-				updatedEntities.push_back(entity);
-				auto& transform = m_Ecs->GetComponent<Component::Transform>(entity);
-				const auto& hierarchy = m_Ecs->GetComponent<Component::Hierarchy>(entity);
+				if (m_Ecs->Exists(entity)) m_Batch.push_back(entity);
+			}
+			if (m_Batch.empty()) continue;
 
-				// 1. CALCULATE LOCAL MATRIX from individual TRS components.
-				// The multiplication order is Scale -> Rotate -> Translate.
-				const mat4 localMatrix = glm::translate(mat4(1.0f), transform.position) *
-					Math::mat4_cast(transform.rotation) *
-					Math::scale(mat4(1.0f), transform.scale);
+			const size_t count = m_Batch.size();
+			m_Locals.Resize(count);
+			m_Parents.Resize(count);
+			m_Models.Resize(count);
+			for (size_t i = 0; i < count; i++) {
+				const auto& transform = m_Ecs->GetComponent<Component::Transform>(m_Batch[i]);
+				const auto& hierarchy = m_Ecs->GetComponent<Component::Hierarchy>(m_Batch[i]);
+				m_Locals.Set(i, transform.position, transform.rotation, transform.scale);
 
 				// No need to check parents as they already passed the earlier check due to breadth first nature of this update scheme
-				// 2. CALCULATE WORLD MATRIX (the final modelMatrix).
-				if (hierarchy.parent != null) {
-					// This entity has a parent. Its world transform is the parent's world transform
-					// multiplied by its own local transform.
-					// We are guaranteed the parent's matrix is up-to-date because we process depth-by-depth.
-					const auto& parentTransform = m_Ecs->GetComponent<Component::Transform>(hierarchy.parent);
-					transform.modelMatrix = parentTransform.modelMatrix * localMatrix;
-				}
-				else {
-					// This is a root entity; its world transform is just its local transform.
-					transform.modelMatrix = localMatrix;
-				}
+				// We are guaranteed the parent's matrix is up-to-date because we process depth-by-depth.
+				if (hierarchy.parent != null)
+					m_Parents.Set(i, m_Ecs->GetComponent<Component::WorldTransform>(hierarchy.parent).modelMatrix);
+				else
+					m_Parents.SetIdentity(i); // root, world is just the local transform
+			}
+
+			// 1. LOCAL MATRIX translate * rotate * scale, 2. WORLD MATRIX parent * local, the whole level at once
+			SIMD::ComposeTRS(m_Locals.Arrays(), m_Models.Arrays(), count);
+			SIMD::MultiplyAffine(m_Parents.Arrays(), m_Models.Arrays(), m_Models.Arrays(), count);
+
+			for (size_t i = 0; i < count; i++) {
+				const entity_id entity = m_Batch[i];
+				updatedEntities.push_back(entity);
+				m_Ecs->GetComponent<Component::WorldTransform>(entity).modelMatrix = m_Models.Get(i);
 
 				// 3. PROPAGATE the change to all direct children.
 				// Since this parent's matrix has changed, all its children are now also "dirty".
 				// We enqueue them so they will be processed in their respective (deeper) buckets.
-				entity_id child_id = hierarchy.first_child;
+				entity_id child_id = m_Ecs->GetComponent<Component::Hierarchy>(entity).first_child;
 				while (child_id != null) {
 					Enqueue(child_id); // Enqueue the child for processing.
 					// Move to the next child in the sibling list.
@@ -451,8 +633,8 @@ namespace Engine {
 		return data.scale;
 	}
 
-	RefTransform::RefTransform(ECS& ecs, entity_id entity, Component::Transform& transform, TransformSystem& system)
-		: ecs{ ecs }, id{ entity }, data{ transform }, system{ system }, isDirty{ false } {
+	RefTransform::RefTransform(ECS& ecs, entity_id entity, Component::Transform& transform, const Component::WorldTransform& worldTransform, TransformSystem& system)
+		: ecs{ ecs }, id{ entity }, data{ transform }, world{ worldTransform }, system{ system }, isDirty{ false } {
 	}
 
 	void RefTransform::SetTransform(Component::Transform& transform) {
@@ -537,7 +719,7 @@ namespace Engine {
 	}
 
 	const mat4& RefTransform::GetModelMatrix() const {
-		return data.modelMatrix;
+		return world.modelMatrix;
 	}
 
 	vec3 RefTransform::GetWorldPosition() const {
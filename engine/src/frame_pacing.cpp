@@ -0,0 +1,135 @@
+#include <engine/frame_pacing.hpp>
+#include <engine/perf_profiler.hpp>
+
+#include <GLFW/glfw3.h>
+
+#include <thread>
+#include <algorithm>
+
+namespace Engine {
+	static f32 Milliseconds(FramePacer::clock::duration duration) {
+		return std::chrono::duration<f32, std::milli>(duration).count();
+	}
+
+	FramePacer::~FramePacer() {
+		for (InFlight& frame : m_InFlight)
+			glDeleteSync(frame.fence);
+	}
+
+	void FramePacer::Configure(const FramePacingConfig& config) {
+		m_Config = config;
+		m_Config.maxFramesInFlight = std::clamp(config.maxFramesInFlight, 1u, 3u);
+		m_Config.targetFps = std::max(config.targetFps, 0.0f);
+		m_Config.spinMs = std::max(config.spinMs, 0.0f);
+	}
+
+	void FramePacer::BeginFrame() {
+		m_Stats.fenceWaitMs = 0.0f;
+		m_Stats.limiterMs = 0.0f;
+
+		// Whatever finished already is retired without waiting, keeps the latency current
+		while (!m_InFlight.empty() && Retire(false)) {}
+
+		if (m_Config.enabled) {
+			// The frame we're about to start counts as in flight too
+			clock::time_point waitStart = clock::now();
+			while (m_InFlight.size() >= m_Config.maxFramesInFlight)
+				Retire(true);
+			m_Stats.fenceWaitMs = Milliseconds(clock::now() - waitStart);
+			PERF_VALUE("Pacing_FenceWait", m_Stats.fenceWaitMs);
+
+			Limit();
+		}
+		else {
+			// Not pacing, the driver queues what it wants, only keep the fence list from growing
+			while (m_InFlight.size() > 8)
+				Retire(true);
+		}
+
+		clock::time_point now = clock::now();
+		if (m_Started) {
+			m_Stats.frameMs = Milliseconds(now - m_FrameStart);
+			PERF_VALUE("Pacing_Frame", m_Stats.frameMs);
+		}
+		m_FrameStart = now;
+		m_InputTime = now;
+		m_Started = true;
+		m_Stats.framesInFlight = (u32)m_InFlight.size();
+	}
+
+	void FramePacer::Limit() {
+		if (m_Config.targetFps <= 0.0f || !m_Started) return;
+
+		clock::time_point limiterStart = clock::now();
+		clock::time_point deadline = m_FrameStart + std::chrono::duration_cast<clock::duration>(std::chrono::duration<f32>(1.0f / m_Config.targetFps));
+		if (deadline <= limiterStart) return; // behind already, don't build up debt
+
+		// Sleep is only good to a millisecond or worse, spin the rest
+		// The sleep is spent in the OS event pump so input keeps getting stamped while we idle
+		clock::time_point wake = deadline - std::chrono::duration_cast<clock::duration>(std::chrono::duration<f32, std::milli>(m_Config.spinMs));
+		for (clock::time_point now = limiterStart; now < wake; now = clock::now())
+			glfwWaitEventsTimeout(std::chrono::duration<double>(wake - now).count());
+		while (clock::now() < deadline)
+			std::this_thread::yield();
+
+		m_Stats.limiterMs = Milliseconds(clock::now() - limiterStart);
+		PERF_VALUE("Pacing_Limiter", m_Stats.limiterMs);
+	}
+
+	bool FramePacer::Retire(bool block) {
+		InFlight& frame = m_InFlight.front();
+
+		GLenum result;
+		if (block) {
+			// Short waits with the event pump in between, a slow GPU shouldn't mean coarse input timestamps
+			result = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000ull);
+			while (result == GL_TIMEOUT_EXPIRED) {
+				glfwPollEvents();
+				result = glClientWaitSync(frame.fence, 0, 1000000ull);
+			}
+		}
+		else {
+			result = glClientWaitSync(frame.fence, 0, 0);
+			if (result == GL_TIMEOUT_EXPIRED) return false;
+		}
+
+		// GL_WAIT_FAILED lands here too, nothing better to do than to forget the frame
+		if (result != GL_WAIT_FAILED) {
+			m_Stats.inputLatencyMs = Milliseconds(clock::now() - frame.inputTime);
+			PERF_VALUE("Pacing_InputLatency", m_Stats.inputLatencyMs);
+		}
+
+		glDeleteSync(frame.fence);
+		m_InFlight.pop_front();
+		return true;
+	}
+
+	void FramePacer::MarkInputSampled() {
+		m_InputTime = clock::now();
+	}
+
+	u32 FramePacer::AddLateLatch(std::function<void()> callback) {
+		u32 id = m_NextLatchId++;
+		m_LateLatches.emplace_back(id, std::move(callback));
+		return id;
+	}
+
+	void FramePacer::RemoveLateLatch(u32 id) {
+		std::erase_if(m_LateLatches, [id](const auto& latch) { return latch.first == id; });
+	}
+
+	bool FramePacer::LateLatch() {
+		if (!m_Config.enabled || !m_Config.lateLatch) return false;
+
+		// Simulation ran on the input from the start of the frame, anything newer only gets to the callbacks
+		glfwPollEvents();
+		MarkInputSampled();
+		for (auto& [id, callback] : m_LateLatches)
+			callback();
+		return !m_LateLatches.empty();
+	}
+
+	void FramePacer::EndFrame() {
+		m_InFlight.push_back(InFlight{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_InputTime });
+	}
+}
@@ -0,0 +1,891 @@
+#include <engine/resource.hpp>
+#include <engine/exception.hpp>
+#include <engine/log.hpp>
+
+#include <stb_image.h>
+
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cfloat>
+#include <functional>
+#include <exception>
+
+// Native glTF 2.0 / GLB decoder, produces the same ModelData the Assimp path does
+// Anything we don't handle (draco, sparse, quantized attributes, skins...) returns null and Assimp takes over
+
+namespace Engine::GLTF {
+	// ========== Minimal JSON ==========
+	struct Json {
+		enum class Type : u8 { Null, Bool, Number, String, Array, Object };
+
+		Type type = Type::Null;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<Json> array;
+		std::vector<std::pair<std::string, Json>> object;
+
+		const Json* find(std::string_view key) const {
+			if (type != Type::Object) return nullptr;
+			for (const auto& [k, v] : object)
+				if (k == key) return &v;
+			return nullptr;
+		}
+
+		const Json& operator[](std::string_view key) const {
+			static const Json empty;
+			const Json* v = find(key);
+			return v ? *v : empty;
+		}
+
+		const Json& operator[](size_t index) const {
+			static const Json empty;
+			return (type == Type::Array && index < array.size()) ? array[index] : empty;
+		}
+
+		bool has(std::string_view key) const { return find(key) != nullptr; }
+		size_t size() const { return type == Type::Array ? array.size() : 0; }
+
+		double num(double def = 0.0) const { return type == Type::Number ? number : def; }
+		int integer(int def = -1) const { return type == Type::Number ? (int)number : def; }
+		const std::string& str() const { static const std::string empty; return type == Type::String ? string : empty; }
+	};
+
+	class JsonParser {
+	public:
+		JsonParser(const char* begin, const char* end) : m_Cur{ begin }, m_End{ end } {}
+
+		Json Parse() {
+			Json value = ParseValue(0);
+			SkipWhitespace();
+			if (m_Cur != m_End) Fail("trailing characters");
+			return value;
+		}
+
+	private:
+		static constexpr int MAX_DEPTH = 128;
+
+		[[noreturn]] void Fail(const char* what) {
+			ENGINE_THROW(std::string("glTF JSON parse error: ") + what);
+		}
+
+		void SkipWhitespace() {
+			while (m_Cur < m_End && (*m_Cur == ' ' || *m_Cur == '\t' || *m_Cur == '\n' || *m_Cur == '\r')) ++m_Cur;
+		}
+
+		bool Consume(const char* literal) {
+			size_t len = strlen(literal);
+			if ((size_t)(m_End - m_Cur) < len || memcmp(m_Cur, literal, len) != 0) return false;
+			m_Cur += len;
+			return true;
+		}
+
+		Json ParseValue(int depth) {
+			if (depth > MAX_DEPTH) Fail("nesting too deep");
+			SkipWhitespace();
+			if (m_Cur >= m_End) Fail("unexpected end");
+
+			Json v;
+			switch (*m_Cur) {
+				case '{': ParseObject(v, depth); break;
+				case '[': ParseArray(v, depth); break;
+				case '"': v.type = Json::Type::String; v.string = ParseString(); break;
+				case 't': if (!Consume("true")) Fail("bad literal"); v.type = Json::Type::Bool; v.boolean = true; break;
+				case 'f': if (!Consume("false")) Fail("bad literal"); v.type = Json::Type::Bool; v.boolean = false; break;
+				case 'n': if (!Consume("null")) Fail("bad literal"); break;
+				default: v.type = Json::Type::Number; v.number = ParseNumber(); break;
+			}
+			return v;
+		}
+
+		void ParseObject(Json& v, int depth) {
+			v.type = Json::Type::Object;
+			++m_Cur; // {
+			SkipWhitespace();
+			if (m_Cur < m_End && *m_Cur == '}') { ++m_Cur; return; }
+
+			while (true) {
+				SkipWhitespace();
+				if (m_Cur >= m_End || *m_Cur != '"') Fail("expected key");
+				std::string key = ParseString();
+				SkipWhitespace();
+				if (m_Cur >= m_End || *m_Cur != ':') Fail("expected ':'");
+				++m_Cur;
+				v.object.emplace_back(std::move(key), ParseValue(depth + 1));
+				SkipWhitespace();
+				if (m_Cur >= m_End) Fail("unterminated object");
+				if (*m_Cur == ',') { ++m_Cur; continue; }
+				if (*m_Cur == '}') { ++m_Cur; return; }
+				Fail("expected ',' or '}'");
+			}
+		}
+
+		void ParseArray(Json& v, int depth) {
+			v.type = Json::Type::Array;
+			++m_Cur; // [
+			SkipWhitespace();
+			if (m_Cur < m_End && *m_Cur == ']') { ++m_Cur; return; }
+
+			while (true) {
+				v.array.push_back(ParseValue(depth + 1));
+				SkipWhitespace();
+				if (m_Cur >= m_End) Fail("unterminated array");
+				if (*m_Cur == ',') { ++m_Cur; continue; }
+				if (*m_Cur == ']') { ++m_Cur; return; }
+				Fail("expected ',' or ']'");
+			}
+		}
+
+		static void AppendUtf8(std::string& out, u32 cp) {
+			if (cp < 0x80) out += (char)cp;
+			else if (cp < 0x800) { out += (char)(0xC0 | (cp >> 6)); out += (char)(0x80 | (cp & 0x3F)); }
+			else if (cp < 0x10000) { out += (char)(0xE0 | (cp >> 12)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+			else { out += (char)(0xF0 | (cp >> 18)); out += (char)(0x80 | ((cp >> 12) & 0x3F)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+		}
+
+		u32 ParseHex4() {
+			if (m_End - m_Cur < 4) Fail("bad unicode escape");
+			u32 cp = 0;
+			for (int i = 0; i < 4; ++i) {
+				char c = *m_Cur++;
+				cp <<= 4;
+				if (c >= '0' && c <= '9') cp |= c - '0';
+				else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+				else Fail("bad unicode escape");
+			}
+			return cp;
+		}
+
+		std::string ParseString() {
+			++m_Cur; // "
+			std::string out;
+			while (true) {
+				if (m_Cur >= m_End) Fail("unterminated string");
+				char c = *m_Cur++;
+				if (c == '"') return out;
+				if (c != '\\') { out += c; continue; }
+
+				if (m_Cur >= m_End) Fail("unterminated escape");
+				char e = *m_Cur++;
+				switch (e) {
+					case '"': out += '"'; break;
+					case '\\': out += '\\'; break;
+					case '/': out += '/'; break;
+					case 'b': out += '\b'; break;
+					case 'f': out += '\f'; break;
+					case 'n': out += '\n'; break;
+					case 'r': out += '\r'; break;
+					case 't': out += '\t'; break;
+					case 'u': {
+						u32 cp = ParseHex4();
+						// Surrogate pair
+						if (cp >= 0xD800 && cp <= 0xDBFF && Consume("\\u")) {
+							u32 low = ParseHex4();
+							cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+						}
+						AppendUtf8(out, cp);
+						break;
+					}
+					default: Fail("bad escape");
+				}
+			}
+		}
+
+		double ParseNumber() {
+			// strtod needs a terminator, numbers are short so copy them out
+			const char* start = m_Cur;
+			while (m_Cur < m_End && (std::isdigit((unsigned char)*m_Cur) || *m_Cur == '-' || *m_Cur == '+' || *m_Cur == '.' || *m_Cur == 'e' || *m_Cur == 'E')) ++m_Cur;
+			if (start == m_Cur) Fail("unexpected character");
+
+			char buffer[64];
+			size_t len = std::min<size_t>(m_Cur - start, sizeof(buffer) - 1);
+			memcpy(buffer, start, len);
+			buffer[len] = '\0';
+
+			char* parsedEnd = nullptr;
+			double value = std::strtod(buffer, &parsedEnd);
+			if (parsedEnd != buffer + len) Fail("bad number");
+			return value;
+		}
+
+		const char* m_Cur;
+		const char* m_End;
+	};
+
+	// ========== Document ==========
+	enum ComponentType : int {
+		COMPONENT_BYTE = 5120, COMPONENT_UNSIGNED_BYTE = 5121, COMPONENT_SHORT = 5122, COMPONENT_UNSIGNED_SHORT = 5123, COMPONENT_UNSIGNED_INT = 5125, COMPONENT_FLOAT = 5126
+	};
+
+	struct Accessor {
+		const u8* data = nullptr;
+		size_t count = 0;
+		size_t stride = 0;
+		int componentType = 0;
+		int components = 0;
+		bool normalized = false;
+	};
+
+	struct Document {
+		std::filesystem::path path;
+		std::vector<u8> file;      // whole .glb/.gltf, BIN chunk is referenced in place
+		Json json;
+		std::vector<std::vector<u8>> external; // buffers that live in other files or data uris
+		std::vector<std::pair<const u8*, size_t>> buffers;
+	};
+
+	// Thrown for valid files we just don't support, caught to fall back to Assimp
+	struct Unsupported {
+		std::string reason;
+	};
+
+	static std::vector<u8> ReadBinary(const std::filesystem::path& path) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) ENGINE_THROW("Failed to open file: " + path.string());
+
+		std::streamsize size = file.tellg();
+		file.seekg(0, std::ios::beg);
+
+		std::vector<u8> bytes((size_t)size);
+		if (size > 0 && !file.read(reinterpret_cast<char*>(bytes.data()), size))
+			ENGINE_THROW("Failed to read file: " + path.string());
+		return bytes;
+	}
+
+	static std::string UriDecode(const std::string& uri) {
+		std::string out;
+		out.reserve(uri.size());
+		for (size_t i = 0; i < uri.size(); ++i) {
+			if (uri[i] == '%' && i + 2 < uri.size()) {
+				out += (char)std::strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16);
+				i += 2;
+			}
+			else out += uri[i];
+		}
+		return out;
+	}
+
+	static std::vector<u8> Base64Decode(std::string_view in) {
+		static const auto table = []() {
+			std::array<i8, 256> t;
+			t.fill(-1);
+			const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			for (int i = 0; i < 64; ++i) t[(u8)chars[i]] = (i8)i;
+			return t;
+		}();
+
+		std::vector<u8> out;
+		out.reserve(in.size() * 3 / 4);
+		u32 acc = 0;
+		int bits = 0;
+		for (char c : in) {
+			i8 v = table[(u8)c];
+			if (v < 0) continue; // padding / whitespace
+			acc = (acc << 6) | (u32)v;
+			bits += 6;
+			if (bits >= 8) {
+				bits -= 8;
+				out.push_back((u8)((acc >> bits) & 0xFF));
+			}
+		}
+		return out;
+	}
+
+	// Returns data uri payload, or reads the file relative to the gltf
+	static std::vector<u8> LoadUri(const Document& doc, const std::string& uri) {
+		if (uri.rfind("data:", 0) == 0) {
+			size_t comma = uri.find(',');
+			if (comma == std::string::npos || uri.find(";base64") > comma) throw Unsupported{ "non base64 data uri" };
+			return Base64Decode(std::string_view(uri).substr(comma + 1));
+		}
+		return ReadBinary(doc.path.parent_path() / UriDecode(uri));
+	}
+
+	static void ParseContainer(Document& doc) {
+		constexpr u32 GLB_MAGIC = 0x46546C67; // "glTF"
+		constexpr u32 CHUNK_JSON = 0x4E4F534A;
+		constexpr u32 CHUNK_BIN = 0x004E4942;
+
+		const u8* bin = nullptr;
+		size_t binSize = 0;
+
+		auto readU32 = [&](size_t offset) {
+			u32 v;
+			memcpy(&v, doc.file.data() + offset, sizeof(u32));
+			return v;
+		};
+
+		if (doc.file.size() >= 12 && readU32(0) == GLB_MAGIC) {
+			if (readU32(4) != 2) throw Unsupported{ "GLB container version " + std::to_string(readU32(4)) };
+			size_t length = std::min<size_t>(readU32(8), doc.file.size());
+
+			const char* jsonBegin = nullptr;
+			size_t jsonSize = 0;
+			size_t offset = 12;
+			while (offset + 8 <= length) {
+				u32 chunkLength = readU32(offset);
+				u32 chunkType = readU32(offset + 4);
+				offset += 8;
+				if (offset + chunkLength > length) ENGINE_THROW("Truncated GLB chunk in " + doc.path.string());
+
+				if (chunkType == CHUNK_JSON && !jsonBegin) {
+					jsonBegin = reinterpret_cast<const char*>(doc.file.data() + offset);
+					jsonSize = chunkLength;
+				}
+				else if (chunkType == CHUNK_BIN && !bin) {
+					bin = doc.file.data() + offset;
+					binSize = chunkLength;
+				}
+				offset += (chunkLength + 3) & ~3u;
+			}
+
+			if (!jsonBegin) ENGINE_THROW("GLB without JSON chunk: " + doc.path.string());
+			doc.json = JsonParser(jsonBegin, jsonBegin + jsonSize).Parse();
+		}
+		else {
+			const char* begin = reinterpret_cast<const char*>(doc.file.data());
+			doc.json = JsonParser(begin, begin + doc.file.size()).Parse();
+		}
+
+		const std::string& version = doc.json["asset"]["version"].str();
+		if (version.empty() || version[0] != '2') throw Unsupported{ "glTF version '" + version + "'" };
+
+		if (doc.json["extensionsRequired"].size() > 0)
+			throw Unsupported{ "required extension " + doc.json["extensionsRequired"][0].str() };
+
+		// Buffers, the first one without an uri is the BIN chunk
+		const Json& buffers = doc.json["buffers"];
+		doc.external.reserve(buffers.size());
+		for (size_t i = 0; i < buffers.size(); ++i) {
+			const Json& buffer = buffers[i];
+			size_t byteLength = (size_t)buffer["byteLength"].num();
+
+			if (!buffer.has("uri")) {
+				if (!bin || binSize < byteLength) ENGINE_THROW("glTF buffer " + std::to_string(i) + " has no data in " + doc.path.string());
+				doc.buffers.push_back({ bin, binSize });
+				continue;
+			}
+
+			doc.external.push_back(LoadUri(doc, buffer["uri"].str()));
+			const std::vector<u8>& data = doc.external.back();
+			if (data.size() < byteLength) ENGINE_THROW("glTF buffer " + std::to_string(i) + " is truncated in " + doc.path.string());
+			doc.buffers.push_back({ data.data(), data.size() });
+		}
+	}
+
+	static std::pair<const u8*, size_t> GetBufferView(const Document& doc, int index) {
+		const Json& view = doc.json["bufferViews"][(size_t)index];
+		if (view.type != Json::Type::Object) ENGINE_THROW("glTF bufferView out of range in " + doc.path.string());
+
+		int buffer = view["buffer"].integer();
+		if (buffer < 0 || (size_t)buffer >= doc.buffers.size()) ENGINE_THROW("glTF buffer out of range in " + doc.path.string());
+
+		size_t offset = (size_t)view["byteOffset"].num(0);
+		size_t length = (size_t)view["byteLength"].num(0);
+		auto [data, size] = doc.buffers[buffer];
+		if (offset + length > size) ENGINE_THROW("glTF bufferView exceeds its buffer in " + doc.path.string());
+		return { data + offset, length };
+	}
+
+	static size_t ComponentSize(int componentType) {
+		switch (componentType) {
+			case COMPONENT_BYTE: case COMPONENT_UNSIGNED_BYTE: return 1;
+			case COMPONENT_SHORT: case COMPONENT_UNSIGNED_SHORT: return 2;
+			case COMPONENT_UNSIGNED_INT: case COMPONENT_FLOAT: return 4;
+			default: return 0;
+		}
+	}
+
+	static int ComponentCount(const std::string& type) {
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		if (type == "MAT2") return 4;
+		if (type == "MAT3") return 9;
+		if (type == "MAT4") return 16;
+		return 0;
+	}
+
+	static Accessor GetAccessor(const Document& doc, int index) {
+		const Json& json = doc.json["accessors"][(size_t)index];
+		if (json.type != Json::Type::Object) ENGINE_THROW("glTF accessor out of range in " + doc.path.string());
+		if (json.has("sparse")) throw Unsupported{ "sparse accessors" };
+
+		Accessor a;
+		a.count = (size_t)json["count"].num(0);
+		a.componentType = json["componentType"].integer(0);
+		a.components = ComponentCount(json["type"].str());
+		a.normalized = json["normalized"].boolean;
+
+		size_t elementSize = ComponentSize(a.componentType) * a.components;
+		if (elementSize == 0) ENGINE_THROW("glTF accessor with invalid type in " + doc.path.string());
+
+		if (!json.has("bufferView")) throw Unsupported{ "accessors without bufferView" };
+		auto [data, length] = GetBufferView(doc, json["bufferView"].integer());
+		size_t offset = (size_t)json["byteOffset"].num(0);
+
+		const Json& view = doc.json["bufferViews"][(size_t)json["bufferView"].integer()];
+		a.stride = view.has("byteStride") ? (size_t)view["byteStride"].num() : elementSize;
+		if (a.count > 0 && offset + a.stride * (a.count - 1) + elementSize > length)
+			ENGINE_THROW("glTF accessor exceeds its bufferView in " + doc.path.string());
+
+		a.data = data + offset;
+		return a;
+	}
+
+	static void RequireFloat(const Accessor& a, int components, const char* semantic) {
+		if (a.componentType != COMPONENT_FLOAT || a.components != components)
+			throw Unsupported{ std::string("non float ") + semantic };
+	}
+
+	// ========== Mesh conversion ==========
+	static void ReadIndices(const Accessor& a, std::vector<u32>& out) {
+		out.resize(a.count);
+		if (a.componentType == COMPONENT_UNSIGNED_INT && a.stride == sizeof(u32)) {
+			memcpy(out.data(), a.data, a.count * sizeof(u32)); // straight copy, no conversion
+			return;
+		}
+
+		switch (a.componentType) {
+			case COMPONENT_UNSIGNED_BYTE:
+				for (size_t i = 0; i < a.count; ++i) out[i] = a.data[i * a.stride];
+				break;
+			case COMPONENT_UNSIGNED_SHORT:
+				for (size_t i = 0; i < a.count; ++i) { u16 v; memcpy(&v, a.data + i * a.stride, sizeof(u16)); out[i] = v; }
+				break;
+			case COMPONENT_UNSIGNED_INT:
+				for (size_t i = 0; i < a.count; ++i) memcpy(&out[i], a.data + i * a.stride, sizeof(u32));
+				break;
+			default:
+				throw Unsupported{ "index component type " + std::to_string(a.componentType) };
+		}
+	}
+
+	// Copies N floats per element from a strided accessor into a member of Vertex
+	template<size_t N>
+	static void ReadAttribute(const Accessor& a, std::vector<Vertex>& vertices, size_t memberOffset) {
+		u8* dst = reinterpret_cast<u8*>(vertices.data()) + memberOffset;
+		for (size_t i = 0; i < a.count; ++i)
+			memcpy(dst + i * sizeof(Vertex), a.data + i * a.stride, N * sizeof(float));
+	}
+
+	// Same thing assimp's CalcTangentSpace does, per vertex accumulation of the triangle tangents
+	static void GenerateTangents(std::vector<Vertex>& vertices, const std::vector<u32>& indices) {
+		std::vector<vec3> tangents(vertices.size(), vec3(0.0f));
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			const Vertex& v0 = vertices[indices[i]];
+			const Vertex& v1 = vertices[indices[i + 1]];
+			const Vertex& v2 = vertices[indices[i + 2]];
+
+			vec3 e1 = v1.position - v0.position;
+			vec3 e2 = v2.position - v0.position;
+			vec2 d1 = v1.uv - v0.uv;
+			vec2 d2 = v2.uv - v0.uv;
+
+			float det = d1.x * d2.y - d2.x * d1.y;
+			if (std::abs(det) < 1e-12f) continue;
+			vec3 t = (e1 * d2.y - e2 * d1.y) * (1.0f / det);
+
+			tangents[indices[i]] += t;
+			tangents[indices[i + 1]] += t;
+			tangents[indices[i + 2]] += t;
+		}
+
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			// Gram-Schmidt against the normal
+			vec3 n = vertices[i].normal;
+			vec3 t = tangents[i] - n * glm::dot(n, tangents[i]);
+			float len = glm::length(t);
+			vertices[i].tangent = len > 1e-12f ? t / len : vec3(0.0f);
+		}
+	}
+
+	// glTF wants flat normals when none are given, so every triangle gets its own vertices
+	static void GenerateFlatNormals(std::vector<Vertex>& vertices, std::vector<u32>& indices) {
+		std::vector<Vertex> unwelded(indices.size());
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			Vertex a = vertices[indices[i]];
+			Vertex b = vertices[indices[i + 1]];
+			Vertex c = vertices[indices[i + 2]];
+			vec3 n = glm::cross(b.position - a.position, c.position - a.position);
+			float len = glm::length(n);
+			n = len > 1e-12f ? n / len : vec3(0.0f, 1.0f, 0.0f);
+			a.normal = b.normal = c.normal = n;
+			unwelded[i] = a;
+			unwelded[i + 1] = b;
+			unwelded[i + 2] = c;
+		}
+		vertices = std::move(unwelded);
+		for (size_t i = 0; i < indices.size(); ++i) indices[i] = (u32)i;
+	}
+
+	static void ConvertPrimitive(const Document& doc, const Json& primitive, const LoadCfg::Model& cfg, ModelData::MeshData& mesh) {
+		if (primitive["mode"].integer(4) != 4) throw Unsupported{ "non triangle primitives" };
+		if (primitive.has("targets")) throw Unsupported{ "morph targets" };
+		if (primitive.has("extensions")) throw Unsupported{ "primitive extensions" };
+
+		const Json& attributes = primitive["attributes"];
+		if (!attributes.has("POSITION")) throw Unsupported{ "primitive without POSITION" };
+
+		Accessor position = GetAccessor(doc, attributes["POSITION"].integer());
+		RequireFloat(position, 3, "POSITION");
+		size_t count = position.count;
+
+		optional<Accessor> normal, uv, tangent;
+		if (attributes.has("NORMAL")) { normal = GetAccessor(doc, attributes["NORMAL"].integer()); RequireFloat(*normal, 3, "NORMAL"); }
+		if (attributes.has("TEXCOORD_0")) { uv = GetAccessor(doc, attributes["TEXCOORD_0"].integer()); RequireFloat(*uv, 2, "TEXCOORD_0"); }
+		if (attributes.has("TANGENT")) { tangent = GetAccessor(doc, attributes["TANGENT"].integer()); RequireFloat(*tangent, 4, "TANGENT"); }
+
+		for (const optional<Accessor>& a : { normal, uv, tangent })
+			if (a && a->count != count) ENGINE_THROW("glTF attribute count mismatch in " + doc.path.string());
+
+		// Exact size, value initialized so missing attributes are zero
+		mesh.vertices.assign(count, Vertex{});
+
+		// Already laid out like our Vertex (our own exports), one copy and done
+		bool matchesLayout = normal && uv && !tangent &&
+			position.stride == sizeof(Vertex) && normal->stride == sizeof(Vertex) && uv->stride == sizeof(Vertex) &&
+			normal->data == position.data + offsetof(Vertex, normal) &&
+			uv->data == position.data + offsetof(Vertex, uv);
+
+		if (matchesLayout) {
+			if (count > 0) memcpy(mesh.vertices.data(), position.data, (count - 1) * sizeof(Vertex) + offsetof(Vertex, tangent));
+		}
+		else {
+			ReadAttribute<3>(position, mesh.vertices, offsetof(Vertex, position));
+			if (normal) ReadAttribute<3>(*normal, mesh.vertices, offsetof(Vertex, normal));
+			if (uv) ReadAttribute<2>(*uv, mesh.vertices, offsetof(Vertex, uv));
+			if (tangent) ReadAttribute<3>(*tangent, mesh.vertices, offsetof(Vertex, tangent)); // w is handedness, dropped
+		}
+
+		// glTF uvs are top-left origin, assimp flips them on import and flip_uvs flips back
+		if (uv && !cfg.flip_uvs) {
+			for (Vertex& v : mesh.vertices) v.uv.y = 1.0f - v.uv.y;
+		}
+
+		if (primitive.has("indices")) {
+			ReadIndices(GetAccessor(doc, primitive["indices"].integer()), mesh.indices);
+			for (u32 idx : mesh.indices)
+				if (idx >= count) ENGINE_THROW("glTF index out of range in " + doc.path.string());
+		}
+		else {
+			mesh.indices.resize(count);
+			for (size_t i = 0; i < count; ++i) mesh.indices[i] = (u32)i;
+		}
+		mesh.indices.resize(mesh.indices.size() - mesh.indices.size() % 3);
+
+		if (!normal) GenerateFlatNormals(mesh.vertices, mesh.indices);
+		if (!tangent && uv) GenerateTangents(mesh.vertices, mesh.indices);
+
+		if (mesh.vertices.empty()) return;
+		vec3 minBounds(FLT_MAX);
+		vec3 maxBounds(-FLT_MAX);
+		for (const Vertex& v : mesh.vertices) {
+			minBounds = glm::min(minBounds, v.position);
+			maxBounds = glm::max(maxBounds, v.position);
+		}
+		mesh.bounds = BBox{ minBounds, maxBounds };
+	}
+
+	// ========== Nodes ==========
+	static Component::Transform NodeTransform(const Json& node) {
+		Component::Transform t;
+
+		if (node.has("matrix")) {
+			const Json& m = node["matrix"];
+			mat4 mat(1.0f);
+			for (int c = 0; c < 4; ++c)
+				for (int r = 0; r < 4; ++r)
+					mat[c][r] = (float)m[(size_t)(c * 4 + r)].num(c == r ? 1.0 : 0.0);
+
+			// Decompose, column major like the spec
+			t.position = vec3(mat[3]);
+			vec3 c0 = vec3(mat[0]), c1 = vec3(mat[1]), c2 = vec3(mat[2]);
+			t.scale = vec3(glm::length(c0), glm::length(c1), glm::length(c2));
+			if (glm::dot(glm::cross(c0, c1), c2) < 0.0f) t.scale.x = -t.scale.x;
+
+			mat3 rot(
+				t.scale.x != 0.0f ? c0 / t.scale.x : c0,
+				t.scale.y != 0.0f ? c1 / t.scale.y : c1,
+				t.scale.z != 0.0f ? c2 / t.scale.z : c2
+			);
+			t.rotation = glm::normalize(glm::quat_cast(rot));
+		}
+		else {
+			const Json& tr = node["translation"];
+			const Json& ro = node["rotation"];
+			const Json& sc = node["scale"];
+			if (tr.size() == 3) t.position = vec3((float)tr[0].num(), (float)tr[1].num(), (float)tr[2].num());
+			if (ro.size() == 4) t.rotation = quat((float)ro[3].num(1.0), (float)ro[0].num(), (float)ro[1].num(), (float)ro[2].num()); // glTF is xyzw
+			if (sc.size() == 3) t.scale = vec3((float)sc[0].num(1.0), (float)sc[1].num(1.0), (float)sc[2].num(1.0));
+		}
+
+		return t;
+	}
+
+	// ========== Images ==========
+	static std::shared_ptr<Image> DecodeImage(const Document& doc, const Json& image) {
+		std::shared_ptr<Image> img;
+
+		if (image.has("bufferView")) {
+			auto [data, size] = GetBufferView(doc, image["bufferView"].integer());
+			img = std::make_shared<Image>();
+			int w, h, c;
+			img->data = stbi_load_from_memory(data, (int)size, &w, &h, &c, 4);
+			img->width = w;
+			img->height = h;
+			img->channels = 4;
+		}
+		else if (image.has("uri")) {
+			const std::string& uri = image["uri"].str();
+			if (uri.rfind("data:", 0) == 0) {
+				std::vector<u8> bytes = LoadUri(doc, uri);
+				img = std::make_shared<Image>();
+				int w, h, c;
+				img->data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &w, &h, &c, 4);
+				img->width = w;
+				img->height = h;
+				img->channels = 4;
+			}
+			else {
+				// External file, same as the assimp path
+				img = ResourceLoader::load(doc.path.parent_path() / UriDecode(uri), LoadCfg::Image());
+			}
+		}
+
+		if (img && !img->data) return nullptr;
+		if (img) img->m_path = doc.path;
+		return img;
+	}
+}
+
+namespace Engine {
+	std::shared_ptr<ModelData> ResourceLoader::decodeGLTF(const std::filesystem::path& path, const LoadCfg::Model& cfg) {
+		using namespace GLTF;
+
+		if (cfg.static_mesh) return nullptr; // wants assimp's OptimizeGraph
+
+		Document doc;
+		doc.path = path;
+		doc.file = ReadBinary(path);
+
+		try {
+			ParseContainer(doc);
+			const Json& json = doc.json;
+
+			for (const char* unsupported : { "skins", "animations" })
+				if (json[unsupported].size() > 0) throw Unsupported{ unsupported };
+
+			std::shared_ptr<ModelData> model = std::make_shared<ModelData>();
+			model->path = path;
+
+			// ========== Meshes, one per primitive like assimp ==========
+			const Json& meshes = json["meshes"];
+			std::vector<u32> firstPrimitive(meshes.size());
+			size_t primitiveCount = 0;
+			for (size_t m = 0; m < meshes.size(); ++m) {
+				firstPrimitive[m] = (u32)primitiveCount;
+				primitiveCount += meshes[m]["primitives"].size();
+			}
+
+			std::vector<const Json*> primitiveJson;
+			primitiveJson.reserve(primitiveCount);
+			for (size_t m = 0; m < meshes.size(); ++m)
+				for (size_t p = 0; p < meshes[m]["primitives"].size(); ++p)
+					primitiveJson.push_back(&meshes[m]["primitives"][p]);
+
+			// One primitive per thread, exceptions can't leave the parallel region so they get rethrown after
+			model->meshes.resize(primitiveCount);
+			std::vector<std::exception_ptr> errors(primitiveCount);
+
+			#pragma omp parallel for schedule(dynamic)
+			for (int i = 0; i < (int)primitiveCount; ++i) {
+				try {
+					ConvertPrimitive(doc, *primitiveJson[i], cfg, model->meshes[i]);
+				}
+				catch (...) {
+					errors[i] = std::current_exception();
+				}
+			}
+
+			for (const std::exception_ptr& error : errors)
+				if (error) std::rethrow_exception(error);
+
+			model->bounds = ModelData::CombineBounds(model->meshes);
+
+			// ========== Scene graph ==========
+			const Json& nodes = json["nodes"];
+			std::vector<int> roots;
+			const Json& scene = json["scenes"][(size_t)std::max(0, json["scene"].integer(0))];
+			if (scene.has("nodes")) {
+				for (size_t i = 0; i < scene["nodes"].size(); ++i) roots.push_back(scene["nodes"][i].integer());
+			}
+			else {
+				// No scene, every node nobody references is a root
+				std::vector<bool> isChild(nodes.size(), false);
+				for (size_t i = 0; i < nodes.size(); ++i)
+					for (size_t c = 0; c < nodes[i]["children"].size(); ++c) {
+						int child = nodes[i]["children"][c].integer();
+						if (child >= 0 && (size_t)child < nodes.size()) isChild[child] = true;
+					}
+				for (size_t i = 0; i < nodes.size(); ++i)
+					if (!isChild[i]) roots.push_back((int)i);
+			}
+
+			// Materials get compacted to the used ones, -1 is the default material
+			std::vector<int> usedMaterials;
+			std::unordered_map<int, u32> materialRemap;
+			auto remapMaterial = [&](int gltfIndex) -> u32 {
+				if (gltfIndex >= (int)json["materials"].size()) gltfIndex = -1;
+				auto [it, inserted] = materialRemap.try_emplace(gltfIndex, (u32)usedMaterials.size());
+				if (inserted) usedMaterials.push_back(gltfIndex);
+				return it->second;
+			};
+
+			std::vector<bool> visited(nodes.size(), false);
+			std::function<void(int, entity_id)> processNode = [&](int index, entity_id parent) {
+				if (index < 0 || (size_t)index >= nodes.size()) ENGINE_THROW("glTF node out of range in " + path.string());
+				if (visited[index]) ENGINE_THROW("glTF node graph is not a tree in " + path.string());
+				visited[index] = true;
+
+				const Json& node = nodes[(size_t)index];
+				ModelData::NodeData nodeData;
+				nodeData.name = node.has("name") ? node["name"].str() : "node_" + std::to_string(index);
+				nodeData.parent = parent;
+				nodeData.transform = NodeTransform(node);
+
+				if (node.has("mesh")) {
+					int m = node["mesh"].integer();
+					if (m < 0 || (size_t)m >= meshes.size()) ENGINE_THROW("glTF mesh out of range in " + path.string());
+					const Json& primitives = meshes[(size_t)m]["primitives"];
+					for (size_t p = 0; p < primitives.size(); ++p)
+						nodeData.entries.push_back({ firstPrimitive[m] + (u32)p, remapMaterial(primitives[p]["material"].integer(-1)) });
+				}
+
+				entity_id thisIdx = (entity_id)model->nodes.size();
+				model->nodes.push_back(std::move(nodeData));
+
+				for (size_t c = 0; c < node["children"].size(); ++c)
+					processNode(node["children"][c].integer(), thisIdx);
+			};
+
+			if (roots.size() == 1) {
+				processNode(roots[0], null);
+			}
+			else {
+				// Several roots get a common parent, Instantiate wants a single one
+				ModelData::NodeData root;
+				root.name = scene.has("name") ? scene["name"].str() : "ROOT";
+				root.parent = null;
+				model->nodes.push_back(std::move(root));
+				for (int r : roots) processNode(r, 0);
+			}
+
+			// ========== Materials ==========
+			// Mapped the way assimp's glTF2 importer fills aiMaterial so both paths render the same
+			auto textureImage = [&](const Json& textureInfo) -> int {
+				if (textureInfo.type != Json::Type::Object) return -1;
+				if (textureInfo["texCoord"].integer(0) != 0) return -1; // we only have one uv set
+				const Json& texture = json["textures"][(size_t)textureInfo["index"].integer()];
+				int source = texture["source"].integer();
+				return (source >= 0 && (size_t)source < json["images"].size()) ? source : -1;
+			};
+
+			struct MaterialImages { int diffuse = -1, normal = -1, emmisive = -1; };
+			std::vector<MaterialImages> materialImages(usedMaterials.size());
+
+			model->materials.resize(usedMaterials.size());
+			for (size_t i = 0; i < usedMaterials.size(); ++i) {
+				ModelData::MaterialData& material = model->materials[i];
+				int gltfIndex = usedMaterials[i];
+				material.cacheKey = path.string() + ":mat:" + (gltfIndex < 0 ? std::string("default") : std::to_string(gltfIndex));
+				if (gltfIndex < 0) continue;
+
+				const Json& mat = json["materials"][(size_t)gltfIndex];
+				const Json& pbr = mat["pbrMetallicRoughness"];
+
+				const Json& baseColor = pbr["baseColorFactor"];
+				if (baseColor.size() == 4) {
+					material.diffuseColor = vec3((float)baseColor[0].num(1.0), (float)baseColor[1].num(1.0), (float)baseColor[2].num(1.0));
+					float opacity = (float)baseColor[3].num(1.0);
+					if (opacity < 1.0f) {
+						material.isTransparent = true;
+						material.opacity = opacity;
+					}
+				}
+
+				// Assimp turns roughness into shininess as (1 - r)^2 * 1000
+				constexpr float SHININESS_DEFAULT = 32.0f;
+				float smoothness = 1.0f - (float)pbr["roughnessFactor"].num(1.0);
+				float shininess = smoothness * smoothness * 1000.0f;
+				material.shininess = shininess > 0.0f ? shininess : SHININESS_DEFAULT;
+
+				const Json& emissive = mat["emissiveFactor"];
+				if (emissive.size() == 3) {
+					material.emmisiveColor = vec3((float)emissive[0].num(), (float)emissive[1].num(), (float)emissive[2].num());
+					if (material.emmisiveColor.r != 0 || material.emmisiveColor.g != 0 || material.emmisiveColor.b != 0)
+						material.isEmmisive = true;
+				}
+				if (const Json* strength = mat["extensions"].find("KHR_materials_emissive_strength")) {
+					material.emmisiveIntensity = (float)(*strength)["emissiveStrength"].num(1.0);
+					material.isEmmisive = true;
+				}
+
+				materialImages[i].diffuse = textureImage(pbr["baseColorTexture"]);
+				materialImages[i].normal = textureImage(mat["normalTexture"]);
+				materialImages[i].emmisive = textureImage(mat["emissiveTexture"]);
+			}
+
+			// ========== Images, decoded in parallel ==========
+			std::vector<int> neededImages;
+			std::vector<bool> isNeeded(json["images"].size(), false);
+			for (const MaterialImages& mi : materialImages)
+				for (int img : { mi.diffuse, mi.normal, mi.emmisive })
+					if (img >= 0 && !isNeeded[img]) { isNeeded[img] = true; neededImages.push_back(img); }
+
+			std::vector<std::shared_ptr<Image>> images(json["images"].size());
+			std::vector<std::string> imageErrors(neededImages.size());
+
+			#pragma omp parallel for schedule(dynamic)
+			for (int i = 0; i < (int)neededImages.size(); ++i) {
+				try {
+					images[neededImages[i]] = DecodeImage(doc, json["images"][(size_t)neededImages[i]]);
+				}
+				catch (const std::exception& e) {
+					imageErrors[i] = e.what();
+				}
+				catch (const Unsupported& u) {
+					imageErrors[i] = u.reason;
+				}
+			}
+
+			for (size_t i = 0; i < neededImages.size(); ++i) {
+				if (!images[neededImages[i]])
+					Log::warn("Failed to decode image {} of '{}' {}", neededImages[i], path.string(), imageErrors[i]);
+			}
+
+			// Images are shared between materials, key by image so the upload makes one texture each
+			auto textureData = [&](int image) -> ModelData::TextureData {
+				if (image < 0 || !images[image]) return {};
+				return { images[image], path.string() + ":img:" + std::to_string(image) };
+			};
+
+			for (size_t i = 0; i < model->materials.size(); ++i) {
+				ModelData::MaterialData& material = model->materials[i];
+				material.textures[(int)Shader::TextureSlot::DIFFUSE] = textureData(materialImages[i].diffuse);
+				material.textures[(int)Shader::TextureSlot::NORMAL] = textureData(materialImages[i].normal);
+				material.textures[(int)Shader::TextureSlot::EMMISIVE] = textureData(materialImages[i].emmisive);
+			}
+
+			return model;
+		}
+		catch (const Unsupported& u) {
+			Log::info("Native glTF loader skipping '{}' ({}), using Assimp", path.string(), u.reason);
+			return nullptr;
+		}
+	}
+}
@@ -1,5 +1,6 @@
 #include <engine/log.hpp>
 #include <engine/exception.hpp>
+#include <engine/simd_math.hpp>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -21,7 +22,7 @@ ENGINE_API void engine_destroy() {
     glfwTerminate();
 }
 
-ENGINE_API void engine_initialize() {
+ENGINE_API void engine_initialize(bool headless) {
     Engine::Log::setup_logging();
     atexit(engine_destroy);
 
@@ -30,7 +31,11 @@ ENGINE_API void engine_initialize() {
     omp_set_num_threads(4);
     Engine::Log::info("OpenMP initialized with {} threads", omp_get_max_threads());
     #endif
+
+    Engine::Log::info("Math kernels: {}", Engine::SIMD::GetLevelName(Engine::SIMD::GetLevel()));
     
+    if (headless) return;
+
     // Prepare glfw and opengl
     // ==== Initialize Window
     if (!glfwInit()) {
@@ -0,0 +1,163 @@
+#include <engine/input.hpp>
+#include <engine/log.hpp>
+#include <engine/exception.hpp>
+
+#include <GLFW/glfw3.h>
+
+namespace Engine {
+	// The window user pointer belongs to Window, one input system per process is plenty
+	static InputSystem* s_Input = nullptr;
+
+	// Whatever was installed before us (ImGui installs after and chains to us on its own)
+	static GLFWkeyfun s_PrevKey = nullptr;
+	static GLFWcharfun s_PrevChar = nullptr;
+	static GLFWmousebuttonfun s_PrevMouseButton = nullptr;
+	static GLFWcursorposfun s_PrevCursorPos = nullptr;
+	static GLFWscrollfun s_PrevScroll = nullptr;
+	static GLFWwindowfocusfun s_PrevFocus = nullptr;
+
+	void InputState::Apply(const InputEvent& event) {
+		switch (event.type) {
+		case InputEvent::Type::Key:
+			if (event.code >= 0 && (u32)event.code < MAX_KEYS && event.action != GLFW_REPEAT)
+				keys[event.code] = event.action == GLFW_PRESS;
+			break;
+		case InputEvent::Type::MouseButton:
+			if (event.code >= 0 && (u32)event.code < MAX_BUTTONS)
+				buttons[event.code] = event.action == GLFW_PRESS;
+			break;
+		case InputEvent::Type::CursorMove:
+			cursorX = event.x;
+			cursorY = event.y;
+			break;
+		case InputEvent::Type::Scroll:
+			scrollX += event.x;
+			scrollY += event.y;
+			break;
+		case InputEvent::Type::Focus:
+			focused = event.code != 0;
+			// Releases get lost while unfocused, don't leave keys stuck down
+			if (!focused) {
+				keys.reset();
+				buttons.reset();
+			}
+			break;
+		case InputEvent::Type::Char:
+			break;
+		}
+	}
+
+	InputSystem::InputSystem(GLFWwindow* window) : m_Window{ window }, m_Epoch{ clock::now() } {
+		if (s_Input)
+			ENGINE_THROW("Only one InputSystem can exist at a time");
+		s_Input = this;
+
+		m_FrameEvents.reserve(256);
+		m_FixedPending.reserve(256);
+
+		// Headless, nothing but replays and Inject feed it
+		if (!m_Window) return;
+
+		double x, y;
+		glfwGetCursorPos(m_Window, &x, &y);
+		m_LiveState.cursorX = m_FrameState.cursorX = m_FixedState.cursorX = x;
+		m_LiveState.cursorY = m_FrameState.cursorY = m_FixedState.cursorY = y;
+
+		s_PrevKey = glfwSetKeyCallback(m_Window, KeyCallback);
+		s_PrevChar = glfwSetCharCallback(m_Window, CharCallback);
+		s_PrevMouseButton = glfwSetMouseButtonCallback(m_Window, MouseButtonCallback);
+		s_PrevCursorPos = glfwSetCursorPosCallback(m_Window, CursorPosCallback);
+		s_PrevScroll = glfwSetScrollCallback(m_Window, ScrollCallback);
+		s_PrevFocus = glfwSetWindowFocusCallback(m_Window, FocusCallback);
+	}
+
+	InputSystem::~InputSystem() {
+		// Callbacks stay installed, ImGui may still be chained on top of them, they only forward from now on
+		s_Input = nullptr;
+		if (m_Dropped > 0)
+			Log::warn("Input queue overflowed, {} events were dropped", m_Dropped);
+	}
+
+	f64 InputSystem::Now() const {
+		return std::chrono::duration<f64>(clock::now() - m_Epoch).count();
+	}
+
+	void InputSystem::Pump() {
+		if (m_Window) glfwPollEvents();
+	}
+
+	void InputSystem::Wait(f64 timeout) {
+		if (!m_Window) return;
+		if (timeout > 0.0) glfwWaitEventsTimeout(timeout);
+		else glfwPollEvents();
+	}
+
+	void InputSystem::Push(const InputEvent& event) {
+		m_LiveState.Apply(event);
+		if (!m_Queue.Push(event))
+			m_Dropped++;
+	}
+
+	void InputSystem::BeginFrame() {
+		// Whatever the last tick got is consumed
+		m_FixedPending.erase(m_FixedPending.begin(), m_FixedPending.begin() + m_FixedCount);
+		m_FixedCount = 0;
+
+		m_FrameEvents.clear();
+		m_FrameState.scrollX = m_FrameState.scrollY = 0.0;
+		m_LiveState.scrollX = m_LiveState.scrollY = 0.0;
+
+		InputEvent event;
+		while (m_Queue.Pop(event)) {
+			m_FrameEvents.push_back(event);
+			m_FixedPending.push_back(event);
+			m_FrameState.Apply(event);
+		}
+	}
+
+	void InputSystem::BeginFixedTick(f64 tickEnd) {
+		m_FixedPending.erase(m_FixedPending.begin(), m_FixedPending.begin() + m_FixedCount);
+		m_FixedCount = 0;
+
+		m_FixedState.scrollX = m_FixedState.scrollY = 0.0;
+		// Events arrive in order, the tick takes the prefix that happened before it ends
+		while (m_FixedCount < m_FixedPending.size() && m_FixedPending[m_FixedCount].time <= tickEnd)
+			m_FixedState.Apply(m_FixedPending[m_FixedCount++]);
+	}
+
+	void InputSystem::KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+		if (s_PrevKey) s_PrevKey(window, key, scancode, action, mods);
+		if (!s_Input || !s_Input->m_RealInput) return;
+		s_Input->Push(InputEvent{ InputEvent::Type::Key, key, action, mods, 0.0, 0.0, s_Input->Now() });
+	}
+
+	void InputSystem::CharCallback(GLFWwindow* window, unsigned int codepoint) {
+		if (s_PrevChar) s_PrevChar(window, codepoint);
+		if (!s_Input || !s_Input->m_RealInput) return;
+		s_Input->Push(InputEvent{ InputEvent::Type::Char, (i32)codepoint, 0, 0, 0.0, 0.0, s_Input->Now() });
+	}
+
+	void InputSystem::MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+		if (s_PrevMouseButton) s_PrevMouseButton(window, button, action, mods);
+		if (!s_Input || !s_Input->m_RealInput) return;
+		s_Input->Push(InputEvent{ InputEvent::Type::MouseButton, button, action, mods, 0.0, 0.0, s_Input->Now() });
+	}
+
+	void InputSystem::CursorPosCallback(GLFWwindow* window, double x, double y) {
+		if (s_PrevCursorPos) s_PrevCursorPos(window, x, y);
+		if (!s_Input || !s_Input->m_RealInput) return;
+		s_Input->Push(InputEvent{ InputEvent::Type::CursorMove, 0, 0, 0, x, y, s_Input->Now() });
+	}
+
+	void InputSystem::ScrollCallback(GLFWwindow* window, double x, double y) {
+		if (s_PrevScroll) s_PrevScroll(window, x, y);
+		if (!s_Input || !s_Input->m_RealInput) return;
+		s_Input->Push(InputEvent{ InputEvent::Type::Scroll, 0, 0, 0, x, y, s_Input->Now() });
+	}
+
+	void InputSystem::FocusCallback(GLFWwindow* window, int focused) {
+		if (s_PrevFocus) s_PrevFocus(window, focused);
+		if (!s_Input || !s_Input->m_RealInput) return;
+		s_Input->Push(InputEvent{ InputEvent::Type::Focus, focused, 0, 0, 0.0, 0.0, s_Input->Now() });
+	}
+}
@@ -5,6 +5,8 @@
 #include <engine/resource.hpp>
 #include <engine/vfs.hpp>
 #include <engine/renderer.hpp>
+#include <engine/streaming.hpp>
+#include <engine/sampling_profiler.hpp>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -18,6 +20,7 @@
 
 #ifdef _DEBUG
 #include <engine/perf_profiler.hpp>
+#include <engine/access_check.hpp>
 PerfProfiler gProfiler;
 #endif
 
@@ -394,7 +397,7 @@ namespace Engine {
         char label[64];
         if (ecs->HasComponent<Component::Name>(entity)) {
             Component::Name& name = ecs->GetComponent<Component::Name>(entity);
-            snprintf(label, sizeof(label), "%s", name.name.c_str());
+            snprintf(label, sizeof(label), "%s", name.str().c_str());
         }
         else snprintf(label, sizeof(label), "Entity %u", entity);
 
@@ -432,6 +435,15 @@ namespace Engine {
     }
 
     // Helper to draw the inspector panel for selected entity
+    template<typename T>
+    static void DrawTagToggle(ECS& ecs, entity_id entity, const char* label) {
+        bool tagged = ecs.HasTag<T>(entity);
+        if (ImGui::Checkbox(label, &tagged)) {
+            if (tagged) ecs.AddTag<T>(entity);
+            else ecs.RemoveTag<T>(entity);
+        }
+    }
+
     static void DrawInspector(entity_id entity) {
         if (entity == null) {
             ImGui::TextDisabled("No entity selected");
@@ -453,9 +465,18 @@ namespace Engine {
         if (ecs->HasComponent<Component::Name>(entity)) {
             ImGui::SameLine();
             auto& nameComp = ecs->GetComponent<Component::Name>(entity);
-            ImGui::Text("Name: %s", nameComp.name.c_str());
+            ImGui::Text("Name: %s", nameComp.str().c_str());
         }
 
+        // Tags, toggled in place
+        DrawTagToggle<Tag::Static>(*ecs, entity, "Static");
+        ImGui::SameLine();
+        DrawTagToggle<Tag::Hidden>(*ecs, entity, "Hidden");
+        ImGui::SameLine();
+        DrawTagToggle<Tag::Disabled>(*ecs, entity, "Disabled");
+        ImGui::SameLine();
+        DrawTagToggle<Tag::Culled>(*ecs, entity, "Culled");
+
         // Hierarchy Component
         if (ecs->HasComponent<Component::Hierarchy>(entity)) {
             auto& h = ecs->GetComponent<Component::Hierarchy>(entity);
@@ -530,12 +551,13 @@ namespace Engine {
 
                 // Model Matrix (collapsed by default)
                 if (ImGui::TreeNode("Model Matrix")) {
+                    const mat4& model = tref.GetModelMatrix();
                     for (int row = 0; row < 4; row++) {
                         ImGui::Text("%.2f  %.2f  %.2f  %.2f",
-                            t.modelMatrix[0][row],
-                            t.modelMatrix[1][row],
-                            t.modelMatrix[2][row],
-                            t.modelMatrix[3][row]);
+                            model[0][row],
+                            model[1][row],
+                            model[2][row],
+                            model[3][row]);
                     }
                     ImGui::TreePop();
                 }
@@ -641,6 +663,37 @@ namespace Engine {
                 ImGui::Text("%s: avg %.2f | min %.2f | max %.2f | p99 %.2f | last %.2f ms",
                     name.c_str(), s.avg(), s.min(), s.max(), s.p99(), s.last);
             }
+
+            ImGui::Separator();
+            bool accessChecks = AccessCheck::IsEnabled();
+            if (ImGui::Checkbox("ECS access checks", &accessChecks))
+                AccessCheck::SetEnabled(accessChecks);
+            static bool accessFatal = false;
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Throw on conflict", &accessFatal))
+                AccessCheck::SetFatal(accessFatal);
+            ImGui::Text("> Conflicts      : %llu", (unsigned long long)AccessCheck::GetConflictCount());
+
+            ImGui::Separator();
+            if (!SamplingProfiler::IsSupported()) {
+                ImGui::TextDisabled("Sampling profiler isn't supported on this platform");
+            }
+            else {
+                static int sampleHz = 1000;
+                static int sampleFrames = 120;
+                ImGui::SliderInt("Sample rate (Hz)", &sampleHz, 100, 10000);
+                ImGui::SliderInt("Frames to sample", &sampleFrames, 1, 1000);
+                if (SamplingProfiler::IsRunning()) {
+                    if (ImGui::Button("Stop sampling")) SamplingProfiler::Stop();
+                }
+                else if (ImGui::Button("Sample frames")) {
+                    SamplingProfiler::Start({ .frequencyHz = (u32)sampleHz, .frames = (u32)sampleFrames });
+                }
+                ImGui::Text("> Samples        : %llu (%llu dropped)", (unsigned long long)SamplingProfiler::GetSampleCount(),
+                    (unsigned long long)SamplingProfiler::GetDroppedCount());
+                if (!SamplingProfiler::GetLastOutput().empty())
+                    ImGui::Text("> Folded stacks  : %s", SamplingProfiler::GetLastOutput().string().c_str());
+            }
         }
         ImGui::End();
         #endif
@@ -700,6 +753,12 @@ namespace Engine {
                     avg.batchCount += s.batchCount;
                     avg.culledObjects += s.culledObjects;
                     avg.drawnObjects += s.drawnObjects;
+                    avg.instanceBytes += s.instanceBytes;
+                    avg.instanceUpdates += s.instanceUpdates;
+                    avg.oitObjects += s.oitObjects;
+                    avg.views += s.views;
+                    avg.lightUpdates += s.lightUpdates;
+                    avg.rhiCommands += s.rhiCommands;
                 }
                 avg.drawCalls /= renderer->GetStats().size();
                 avg.instancedDrawCalls /= renderer->GetStats().size();
@@ -707,14 +766,164 @@ namespace Engine {
                 avg.batchCount /= renderer->GetStats().size();
                 avg.culledObjects /= renderer->GetStats().size();
                 avg.drawnObjects /= renderer->GetStats().size();
+                avg.instanceBytes /= renderer->GetStats().size();
+                avg.instanceUpdates /= renderer->GetStats().size();
+                avg.oitObjects /= renderer->GetStats().size();
+                avg.views /= renderer->GetStats().size();
+                avg.lightUpdates /= renderer->GetStats().size();
+                avg.rhiCommands /= renderer->GetStats().size();
 
                 ImGui::Text("Average over %d frames:", renderer->GetStats().size());
                 ImGui::Text("> Draw Calls     : %d", avg.drawCalls);
                 ImGui::Text("> Instanced Calls: %d", avg.instancedDrawCalls);
+                ImGui::Text("> Views          : %d", avg.views);
                 ImGui::Text("> Total objects  : %d", avg.totalObjects);
                 ImGui::Text("> Drawn objects  : %d", avg.drawnObjects);
                 ImGui::Text("> Batch counts   : %d", avg.batchCount);
                 ImGui::Text("> Culled objects : %d", avg.culledObjects);
+                ImGui::Text("> Instance data  : %.1f KB", avg.instanceBytes / 1024.0f);
+                ImGui::Text("> Slot updates   : %d", avg.instanceUpdates);
+                ImGui::Text("> OIT objects    : %d", avg.oitObjects);
+                ImGui::Text("> Light updates  : %d", avg.lightUpdates);
+                ImGui::Text("> RHI commands   : %d", avg.rhiCommands);
+
+                bool oit = renderer->GetTransparencyMode() == Material::TransparencyMode::OIT;
+                if (ImGui::Checkbox("Order independent transparency", &oit))
+                    renderer->SetTransparencyMode(oit ? Material::TransparencyMode::OIT : Material::TransparencyMode::Sorted);
+
+                // Everything up to submission still runs, what's left in the frame time is the renderer's own CPU cost
+                bool nullBackend = renderer->GetBackendType() == RHI::BackendType::Null;
+                if (ImGui::Checkbox("Null backend (skip geometry submission)", &nullBackend))
+                    renderer->SetBackend(nullBackend ? RHI::BackendType::Null : RHI::BackendType::GL);
+            }
+
+            if (ImGui::CollapsingHeader("Dynamic Resolution", ImGuiTreeNodeFlags_FramePadding)) {
+                DynamicResolutionConfig config = renderer->GetDynamicResolution();
+                float gpuFrameMs = renderer->GetStats().empty() ? 0.0f : renderer->GetStats().front().gpuFrameMs;
+
+                ImGui::Text("> Render scale   : %.0f%%", renderer->GetRenderScale() * 100.0f);
+                ImGui::Text("> GPU frame      : %.2f ms", gpuFrameMs);
+
+                bool changed = ImGui::Checkbox("Enabled", &config.enabled);
+                changed |= ImGui::SliderFloat("Target (ms)", &config.targetFrameMs, 2.0f, 50.0f);
+                changed |= ImGui::SliderFloat("Min scale", &config.minScale, 0.25f, 1.0f);
+                changed |= ImGui::SliderFloat("Max scale", &config.maxScale, 0.25f, 1.0f);
+                changed |= ImGui::SliderFloat("Sharpness", &config.sharpness, 0.0f, 1.0f);
+                if (changed)
+                    renderer->SetDynamicResolution(config);
+            }
+
+            if (ImGui::CollapsingHeader("Frame Pacing", ImGuiTreeNodeFlags_FramePadding)) {
+                FramePacer& pacer = Engine::Application::Get().GetFramePacer();
+                const FramePacer::Stats& stats = pacer.GetStats();
+                FramePacingConfig config = pacer.GetConfig();
+
+                ImGui::Text("> Frame          : %.2f ms", stats.frameMs);
+                ImGui::Text("> Fence wait     : %.2f ms", stats.fenceWaitMs);
+                ImGui::Text("> Limiter        : %.2f ms", stats.limiterMs);
+                ImGui::Text("> Input latency  : %.2f ms", stats.inputLatencyMs);
+                ImGui::Text("> In flight      : %u", stats.framesInFlight);
+                InputSystem& input = Engine::Application::Get().GetInput();
+                ImGui::Text("> Input events   : %zu (%llu dropped)", input.GetFrameEvents().size(), (unsigned long long)input.GetDroppedEvents());
+
+                int framesInFlight = (int)config.maxFramesInFlight;
+                bool changed = ImGui::Checkbox("Enabled##pacing", &config.enabled);
+                changed |= ImGui::SliderInt("Frames in flight", &framesInFlight, 1, 3);
+                changed |= ImGui::SliderFloat("Target FPS (0 = off)", &config.targetFps, 0.0f, 240.0f);
+                changed |= ImGui::Checkbox("Late latch", &config.lateLatch);
+                if (changed) {
+                    config.maxFramesInFlight = (u32)framesInFlight;
+                    pacer.Configure(config);
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Texture Streaming", ImGuiTreeNodeFlags_FramePadding)) {
+                TextureStreamer& streamer = renderer->GetTextureStreamer();
+                const TextureStreamer::Stats& stats = streamer.GetStats();
+                TextureStreamingConfig config = streamer.GetConfig();
+
+                ImGui::Text("> Textures       : %u", stats.textures);
+                ImGui::Text("> Pending reads  : %u", stats.pending);
+                ImGui::Text("> Resident       : %.1f / %.1f MB", stats.residentBytes / (1024.0f * 1024.0f), config.budgetBytes / (1024.0f * 1024.0f));
+                ImGui::Text("> Wanted         : %.1f MB", stats.wantedBytes / (1024.0f * 1024.0f));
+                ImGui::Text("> Uploads        : %u", stats.uploads);
+                ImGui::Text("> Evictions      : %u", stats.evictions);
+
+                int budgetMb = (int)(config.budgetBytes / (1024 * 1024));
+                bool changed = ImGui::SliderInt("Budget (MB)", &budgetMb, 16, 4096);
+                changed |= ImGui::SliderFloat("LOD bias", &config.lodBias, -2.0f, 4.0f);
+                if (changed) {
+                    config.budgetBytes = (size_t)budgetMb * 1024 * 1024;
+                    streamer.Configure(config);
+                }
+            }
+        }
+        ImGui::End();
+    }
+
+    void DrawStreaming() {
+        Ref<StreamingSystem> streaming = Engine::Application::Get().GetECS()->GetSystem<StreamingSystem>();
+
+        if (ImGui::Begin("World Streaming")) {
+            const auto& cells = streaming->GetCells();
+            const StreamingConfig& cfg = streaming->GetConfig();
+
+            size_t resident = 0, cpuBytes = 0, gpuBytes = 0;
+            for (const auto& [coord, cell] : cells) {
+                if (cell.state != StreamingSystem::CellState::Resident) continue;
+                resident++;
+                cpuBytes += cell.stats.cpuBytes;
+                gpuBytes += cell.stats.gpuBytes;
+            }
+
+            ImGui::Text("Cells: %zu resident / %zu total", resident, cells.size());
+            ImGui::Text("Pending jobs: %zu", streaming->GetPendingJobs());
+            ImGui::Text("Cell size %.1f | load %.1f | unload %.1f | budget %.2f ms", cfg.cellSize, cfg.loadRadius, cfg.unloadRadius, cfg.frameBudgetMs);
+            ImGui::Text("Resident memory: CPU decoded %.2f MB | GPU est. %.2f MB", cpuBytes / (1024.0 * 1024.0), gpuBytes / (1024.0 * 1024.0));
+            ImGui::Separator();
+
+            constexpr const char* CELL_STATES_STR[] = {
+                "Unloaded", "Loading", "Instantiating", "Resident"
+            };
+
+            if (ImGui::BeginTable("StreamingCells", 8,
+                ImGuiTableFlags_Borders |
+                ImGuiTableFlags_RowBg |
+                ImGuiTableFlags_Resizable |
+                ImGuiTableFlags_ScrollY)) {
+
+                ImGui::TableSetupColumn("Cell");
+                ImGui::TableSetupColumn("State");
+                ImGui::TableSetupColumn("Objects");
+                ImGui::TableSetupColumn("Entities");
+                ImGui::TableSetupColumn("CPU MB");
+                ImGui::TableSetupColumn("GPU MB");
+                ImGui::TableSetupColumn("Decode ms");
+                ImGui::TableSetupColumn("Inst. ms (frames)");
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableHeadersRow();
+
+                for (const auto& [coord, cell] : cells) {
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("%d, %d", coord.x, coord.z);
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%s", CELL_STATES_STR[(u8)cell.state]);
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("%zu", cell.objects.size());
+                    ImGui::TableSetColumnIndex(3);
+                    ImGui::Text("%u", cell.stats.entities);
+                    ImGui::TableSetColumnIndex(4);
+                    ImGui::Text("%.2f", cell.stats.cpuBytes / (1024.0 * 1024.0));
+                    ImGui::TableSetColumnIndex(5);
+                    ImGui::Text("%.2f", cell.stats.gpuBytes / (1024.0 * 1024.0));
+                    ImGui::TableSetColumnIndex(6);
+                    ImGui::Text("%.2f", cell.stats.decodeMs);
+                    ImGui::TableSetColumnIndex(7);
+                    ImGui::Text("%.2f (%u)", cell.stats.instantiateMs, cell.stats.frames);
+                }
+
+                ImGui::EndTable();
             }
         }
         ImGui::End();
@@ -730,6 +939,7 @@ namespace Engine {
         DrawPerf();
         DrawLayerStack();
         DrawRenderer();
+        DrawStreaming();
 
 		End();
 	}
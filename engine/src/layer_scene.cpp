@@ -34,19 +34,28 @@ namespace Engine {
 		// Get our main camera
 		Component::Camera* mainCam = nullptr;
 		vec3 viewPos{ 0 };
-		for (auto [entity, transform, cam] : ecs->View<Component::Transform, Component::Camera>()) {
+		for (auto [entity, world, cam] : ecs->Query<Component::WorldTransform, Component::Camera>().Without<Tag::Disabled>()) {
 			if (cam.isMain) {
 				mainCam = &cam;
-				viewPos = transform.position;
-				renderer.SetCamera(&transform, &cam);
+				viewPos = world.Position();
+				renderer.SetCamera(&world, &cam);
 				break;
 			}
 		}
+		// Before the camera check, the TransformSystem won't report these moves again. Instances stay resident on the GPU
+		// and the renderer keeps the moves until their entities get queued, only those slots are uploaded again
+		renderer.MarkTransformsUpdated(updatedEntities);
 		if (!mainCam) return; // No camera, no rendering :3
 
+		// Extra views share the queue below, the renderer culls and batches all of them at once
+		for (auto [entity, world, cam] : ecs->Query<Component::WorldTransform, Component::Camera>().Without<Tag::Disabled>()) {
+			if (cam.isExtraView && !cam.isMain)
+				renderer.AddView(&world, &cam, cam.viewport);
+		}
+
 		// Get our lights
-		for (auto [entity, transform, light] : ecs->View<Component::Transform, Component::Light>()) {
-			renderer.QueueLight(&transform, &light);
+		for (auto [entity, world, light] : ecs->Query<Component::WorldTransform, Component::Light>().Without<Tag::Disabled>()) {
+			renderer.QueueLight(&world, &light, entity);
 		}
 
 		// vec3 lightPos = viewPos; // shines from camera
@@ -54,8 +63,8 @@ namespace Engine {
 		// mat4 projView = mainCam->projectionMatrix * mainCam->viewMatrix;
 
 		// Collect our drawables
-		for (auto [entity, transform, drawable] : ecs->View<Component::Transform, Component::Drawable3D>()) {
-			renderer.QueueDrawable3D(&transform, &drawable);
+		for (auto [entity, world, drawable] : ecs->Query<Component::WorldTransform, Component::Drawable3D>().Without<Tag::Hidden, Tag::Disabled>()) {
+			renderer.QueueDrawable3D(&world, &drawable, entity);
 			//const Model::MeshCollection& collection = drawable.GetCollection();
 			//for (const auto [mesh, material] : collection) {
 			//	renderer.Queue(&transform, mesh, material);
@@ -0,0 +1,281 @@
+// Sockets first, winsock2 has to come before anything pulls in windows.h
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#undef min
+#undef max
+using socket_t = SOCKET;
+static constexpr socket_t INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+static void close_socket(socket_t s) { closesocket(s); }
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+using socket_t = int;
+static constexpr socket_t INVALID_SOCKET_HANDLE = -1;
+static void close_socket(socket_t s) { close(s); }
+#endif
+
+#include <engine/metrics.hpp>
+#include <engine/log.hpp>
+#include <engine/exception.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <chrono>
+
+namespace Engine {
+	Histogram::Histogram(vector<f64> bounds) : m_Bounds{ std::move(bounds) } {
+		std::sort(m_Bounds.begin(), m_Bounds.end());
+		m_Buckets = std::make_unique<std::atomic<u64>[]>(m_Bounds.size() + 1);
+		for (size_t i = 0; i <= m_Bounds.size(); i++)
+			m_Buckets[i].store(0, std::memory_order_relaxed);
+	}
+
+	void Histogram::Observe(f64 value) {
+		size_t bucket = std::lower_bound(m_Bounds.begin(), m_Bounds.end(), value) - m_Bounds.begin();
+		m_Buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+		m_Count.fetch_add(1, std::memory_order_relaxed);
+		m_Sum.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	MetricsRegistry::Family& MetricsRegistry::GetFamily(const string& name, const string& help, Type type) {
+		auto [it, inserted] = m_Families.try_emplace(name);
+		Family& family = it->second;
+		if (inserted) {
+			family.type = type;
+			family.help = help;
+		}
+		else if (family.type != type) {
+			ENGINE_THROW("Metric " + name + " registered with two different types");
+		}
+		return family;
+	}
+
+	Counter& MetricsRegistry::GetCounter(const string& name, const string& help, const string& labels) {
+		std::lock_guard lock(m_Mutex);
+		auto& series = GetFamily(name, help, Type::Counter).counters[labels];
+		if (!series) series = std::make_unique<Counter>();
+		return *series;
+	}
+
+	Gauge& MetricsRegistry::GetGauge(const string& name, const string& help, const string& labels) {
+		std::lock_guard lock(m_Mutex);
+		auto& series = GetFamily(name, help, Type::Gauge).gauges[labels];
+		if (!series) series = std::make_unique<Gauge>();
+		return *series;
+	}
+
+	Histogram& MetricsRegistry::GetHistogram(const string& name, const string& help, vector<f64> bounds, const string& labels) {
+		std::lock_guard lock(m_Mutex);
+		auto& series = GetFamily(name, help, Type::Histogram).histograms[labels];
+		if (!series) series = std::make_unique<Histogram>(std::move(bounds));
+		return *series;
+	}
+
+	// name{labels} with the extra label merged in, braces dropped when there are none
+	static string SeriesName(const string& name, const string& labels, const string& extra = "") {
+		if (labels.empty() && extra.empty()) return name;
+		if (labels.empty()) return name + "{" + extra + "}";
+		if (extra.empty()) return name + "{" + labels + "}";
+		return name + "{" + labels + "," + extra + "}";
+	}
+
+	string MetricsRegistry::Serialize() const {
+		std::ostringstream out;
+		out.precision(17);
+
+		std::lock_guard lock(m_Mutex);
+		for (auto& [name, family] : m_Families) {
+			if (!family.help.empty())
+				out << "# HELP " << name << ' ' << family.help << '\n';
+
+			switch (family.type) {
+			case Type::Counter:
+				out << "# TYPE " << name << " counter\n";
+				for (auto& [labels, counter] : family.counters)
+					out << SeriesName(name, labels) << ' ' << counter->Get() << '\n';
+				break;
+			case Type::Gauge:
+				out << "# TYPE " << name << " gauge\n";
+				for (auto& [labels, gauge] : family.gauges)
+					out << SeriesName(name, labels) << ' ' << gauge->Get() << '\n';
+				break;
+			case Type::Histogram:
+				out << "# TYPE " << name << " histogram\n";
+				for (auto& [labels, histogram] : family.histograms) {
+					const vector<f64>& bounds = histogram->GetBounds();
+					u64 cumulative = 0;
+					for (size_t i = 0; i < bounds.size(); i++) {
+						cumulative += histogram->GetBucket(i);
+						std::ostringstream le;
+						le << "le=\"" << bounds[i] << '"';
+						out << SeriesName(name + "_bucket", labels, le.str()) << ' ' << cumulative << '\n';
+					}
+					cumulative += histogram->GetBucket(bounds.size());
+					out << SeriesName(name + "_bucket", labels, "le=\"+Inf\"") << ' ' << cumulative << '\n';
+					out << SeriesName(name + "_sum", labels) << ' ' << histogram->GetSum() << '\n';
+					out << SeriesName(name + "_count", labels) << ' ' << histogram->GetCount() << '\n';
+				}
+				break;
+			}
+		}
+		return out.str();
+	}
+
+	MetricsExporter::MetricsExporter(const MetricsRegistry& registry) : m_Registry{ registry } {}
+
+	MetricsExporter::~MetricsExporter() {
+		Stop();
+	}
+
+	void MetricsExporter::Start(const MetricsExportConfig& config) {
+		Stop();
+		if (config.file.empty() && config.port == 0) return;
+
+		m_Config = config;
+		m_Config.intervalSeconds = std::max(config.intervalSeconds, 0.1f);
+		m_Stop = false;
+		m_Thread = std::thread(&MetricsExporter::Run, this);
+	}
+
+	void MetricsExporter::Stop() {
+		if (!m_Thread.joinable()) return;
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Stop = true;
+		}
+		m_Wake.notify_all();
+		m_Thread.join();
+	}
+
+	void MetricsExporter::WriteFile() const {
+		// Write next to it and rename over, readers only ever see whole snapshots
+		path temp = m_Config.file;
+		temp += ".tmp";
+		{
+			std::ofstream file(temp, std::ios::trunc);
+			if (!file) return;
+			file << m_Registry.Serialize();
+		}
+		std::error_code error;
+		std::filesystem::rename(temp, m_Config.file, error);
+		if (error)
+			Log::warn("Failed to publish metrics to {}: {}", m_Config.file.string(), error.message());
+	}
+
+	static socket_t OpenListener(u16 port) {
+#ifdef _WIN32
+		WSADATA wsa;
+		if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return INVALID_SOCKET_HANDLE;
+#endif
+		socket_t listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (listener == INVALID_SOCKET_HANDLE) {
+#ifdef _WIN32
+			WSACleanup();
+#endif
+			return listener;
+		}
+
+		int reuse = 1;
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+		// Loopback only, this isn't meant to be reachable from outside the machine
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 4) != 0) {
+			close_socket(listener);
+#ifdef _WIN32
+			WSACleanup();
+#endif
+			return INVALID_SOCKET_HANDLE;
+		}
+		return listener;
+	}
+
+	// Bounds blocking recv/send on a client, a peer that connects and goes quiet can't stall the exporter (and Stop's join)
+	static void SetSocketTimeouts(socket_t s, u32 milliseconds) {
+#ifdef _WIN32
+		DWORD timeout = milliseconds;
+#else
+		timeval timeout{ (time_t)(milliseconds / 1000), (suseconds_t)((milliseconds % 1000) * 1000) };
+#endif
+		setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+		setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+	}
+
+	static void Serve(socket_t client, const string& body) {
+		SetSocketTimeouts(client, 500);
+
+		// Whatever got asked, the answer is the snapshot
+		char request[1024];
+		recv(client, request, sizeof(request), 0);
+
+		string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+			+ std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+		size_t sent = 0;
+		while (sent < response.size()) {
+			int n = send(client, response.data() + sent, (int)(response.size() - sent), 0);
+			if (n <= 0) break;
+			sent += n;
+		}
+		close_socket(client);
+	}
+
+	void MetricsExporter::Run() {
+		using clock = std::chrono::steady_clock;
+		const auto interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<f32>(m_Config.intervalSeconds));
+
+		socket_t listener = INVALID_SOCKET_HANDLE;
+		if (m_Config.port != 0) {
+			listener = OpenListener(m_Config.port);
+			if (listener == INVALID_SOCKET_HANDLE) Log::warn("Metrics exporter failed to listen on 127.0.0.1:{}", m_Config.port);
+			else Log::info("Serving metrics on 127.0.0.1:{}", m_Config.port);
+		}
+
+		clock::time_point nextWrite = clock::now();
+		while (true) {
+			if (!m_Config.file.empty() && clock::now() >= nextWrite) {
+				WriteFile();
+				nextWrite = clock::now() + interval;
+			}
+
+			if (listener != INVALID_SOCKET_HANDLE) {
+				// Short select timeouts, that's how Stop gets noticed while listening
+				{
+					std::lock_guard lock(m_Mutex);
+					if (m_Stop) break;
+				}
+				fd_set readable;
+				FD_ZERO(&readable);
+				FD_SET(listener, &readable);
+				timeval timeout{ 0, 250000 };
+				if (select((int)listener + 1, &readable, nullptr, nullptr, &timeout) > 0) {
+					socket_t client = accept(listener, nullptr, nullptr);
+					if (client != INVALID_SOCKET_HANDLE)
+						Serve(client, m_Registry.Serialize());
+				}
+			}
+			else {
+				std::unique_lock lock(m_Mutex);
+				if (m_Config.file.empty()) {
+					// Listener didn't come up and there's no file, nothing left to do but wait for Stop
+					m_Wake.wait(lock, [this] { return m_Stop; });
+					break;
+				}
+				if (m_Wake.wait_until(lock, nextWrite, [this] { return m_Stop; })) break;
+			}
+		}
+
+		if (listener != INVALID_SOCKET_HANDLE) {
+			close_socket(listener);
+#ifdef _WIN32
+			WSACleanup();
+#endif
+		}
+	}
+}
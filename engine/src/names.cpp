@@ -0,0 +1,62 @@
+#include <engine/types.hpp>
+#include <engine/exception.hpp>
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+
+namespace Engine::Names {
+	struct Table {
+		std::shared_mutex mutex;
+		// Deque so the strings never move, the lookup keys point into them
+		std::deque<string> strings{ string() };
+		std::unordered_map<std::string_view, u32> lookup{ { std::string_view(), 0 } };
+	};
+
+	// Function local so names interned during static initialization still find it constructed
+	static Table& GetTable() {
+		static Table table;
+		return table;
+	}
+
+	u32 Intern(std::string_view str) {
+		if (str.empty()) return 0;
+		Table& table = GetTable();
+
+		// Almost always already there (every instance of a model repeats its node names)
+		{
+			std::shared_lock lock(table.mutex);
+			auto it = table.lookup.find(str);
+			if (it != table.lookup.end()) return it->second;
+		}
+
+		std::unique_lock lock(table.mutex);
+		auto it = table.lookup.find(str);
+		if (it != table.lookup.end()) return it->second;
+
+		const u32 handle = static_cast<u32>(table.strings.size());
+		const string& stored = table.strings.emplace_back(str);
+		table.lookup.emplace(std::string_view(stored), handle);
+		return handle;
+	}
+
+	u32 Find(std::string_view str) {
+		Table& table = GetTable();
+		std::shared_lock lock(table.mutex);
+		auto it = table.lookup.find(str);
+		return it != table.lookup.end() ? it->second : 0;
+	}
+
+	const string& Get(u32 handle) {
+		Table& table = GetTable();
+		std::shared_lock lock(table.mutex);
+		if (handle >= table.strings.size()) ENGINE_THROW("Invalid name handle");
+		return table.strings[handle];
+	}
+
+	size_t Count() {
+		Table& table = GetTable();
+		std::shared_lock lock(table.mutex);
+		return table.strings.size();
+	}
+}
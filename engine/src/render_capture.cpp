@@ -0,0 +1,273 @@
+#include <engine/render_capture.hpp>
+#include <engine/log.hpp>
+
+#include <fstream>
+
+namespace Engine {
+    static constexpr u32 CAPTURE_MAGIC = 0x50435247; // "GRCP"
+    static constexpr u32 CAPTURE_VERSION = 2; // 2: model load config
+
+    template<typename T>
+    static void Write(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    static bool Read(std::ifstream& file, T& value) {
+        file.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return (bool)file;
+    }
+
+    // Field by field like the input replays, glm types are plain floats so those go whole
+    static void WriteCamera(std::ofstream& file, const Component::Camera& camera) {
+        Write(file, (u8)camera.isMain);
+        Write(file, (u8)camera.isExtraView);
+        Write(file, camera.viewport);
+        Write(file, camera.viewMatrix);
+        Write(file, camera.projectionMatrix);
+        Write(file, camera.fov);
+        Write(file, camera.aspect_ratio);
+        Write(file, camera.nearPlane);
+        Write(file, camera.farPlane);
+    }
+
+    static bool ReadCamera(std::ifstream& file, Component::Camera& camera) {
+        u8 isMain = 0, isExtraView = 0;
+        if (!Read(file, isMain) || !Read(file, isExtraView) || !Read(file, camera.viewport) || !Read(file, camera.viewMatrix)
+            || !Read(file, camera.projectionMatrix) || !Read(file, camera.fov) || !Read(file, camera.aspect_ratio)
+            || !Read(file, camera.nearPlane) || !Read(file, camera.farPlane))
+            return false;
+        camera.isMain = isMain;
+        camera.isExtraView = isExtraView;
+        return true;
+    }
+
+    static void WriteLight(std::ofstream& file, const Component::Light& light) {
+        Write(file, (u8)light.type);
+        Write(file, light.color);
+        Write(file, light.intensity);
+        Write(file, light.range);
+        Write(file, light.direction);
+        Write(file, light.innerCutoffRadians);
+        Write(file, light.outerCutoffRadians);
+    }
+
+    static bool ReadLight(std::ifstream& file, Component::Light& light) {
+        u8 type = 0;
+        if (!Read(file, type) || !Read(file, light.color) || !Read(file, light.intensity) || !Read(file, light.range)
+            || !Read(file, light.direction) || !Read(file, light.innerCutoffRadians) || !Read(file, light.outerCutoffRadians))
+            return false;
+        light.type = (Component::Light::Type)type;
+        return true;
+    }
+
+    bool RenderCapture::Save(const path& file) const {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        Write(out, CAPTURE_MAGIC);
+        Write(out, CAPTURE_VERSION);
+        Write(out, (u8)transparencyMode);
+
+        Write(out, (u32)models.size());
+        for (const ModelSource& model : models) {
+            const string name = model.file.generic_string();
+            Write(out, (u32)name.size());
+            out.write(name.data(), name.size());
+            Write(out, (u8)model.cfg.static_mesh);
+            Write(out, (u8)model.cfg.flip_uvs);
+            Write(out, (u8)model.cfg.normalize);
+        }
+
+        Write(out, (u32)frames.size());
+        for (const Frame& frame : frames) {
+            Write(out, (u32)frame.views.size());
+            for (const View& view : frame.views) {
+                Write(out, view.world);
+                Write(out, view.viewport);
+                WriteCamera(out, view.camera);
+            }
+
+            Write(out, (u32)frame.lights.size());
+            for (const Light& light : frame.lights) {
+                Write(out, light.entity);
+                Write(out, light.source);
+                Write(out, light.world);
+                WriteLight(out, light.light);
+            }
+
+            Write(out, (u32)frame.instances.size());
+            for (const Instance& instance : frame.instances) {
+                Write(out, (u8)instance.kind);
+                Write(out, instance.model);
+                Write(out, instance.mesh);
+                Write(out, instance.material);
+                Write(out, instance.entity);
+                Write(out, instance.world);
+                if (instance.kind != InstanceKind::Quantized) continue;
+                Write(out, instance.local.position);
+                Write(out, instance.local.rotation);
+                Write(out, instance.local.scale);
+            }
+
+            Write(out, (u32)frame.updated.size());
+            out.write(reinterpret_cast<const char*>(frame.updated.data()), frame.updated.size() * sizeof(entity_id));
+        }
+        return (bool)out;
+    }
+
+    bool RenderCapture::Load(const path& file) {
+        std::ifstream in(file, std::ios::binary);
+        if (!in) return false;
+
+        u32 magic = 0, version = 0, count = 0;
+        u8 mode = 0;
+        if (!Read(in, magic) || !Read(in, version) || magic != CAPTURE_MAGIC || version != CAPTURE_VERSION || !Read(in, mode))
+            return false;
+        transparencyMode = (Material::TransparencyMode)mode;
+
+        if (!Read(in, count)) return false;
+        models.resize(count);
+        for (ModelSource& model : models) {
+            u32 length = 0;
+            u8 staticMesh = 0, flipUvs = 0, normalize = 0;
+            if (!Read(in, length)) return false;
+            string name(length, '\0');
+            if (!in.read(name.data(), length)) return false;
+            if (!Read(in, staticMesh) || !Read(in, flipUvs) || !Read(in, normalize)) return false;
+            model.file = name;
+            model.cfg = LoadCfg::Model{ .normalize = normalize != 0, .static_mesh = staticMesh != 0, .flip_uvs = flipUvs != 0 };
+        }
+
+        if (!Read(in, count)) return false;
+        frames.resize(count);
+        for (Frame& frame : frames) {
+            if (!Read(in, count)) return false;
+            frame.views.resize(count);
+            for (View& view : frame.views) {
+                if (!Read(in, view.world) || !Read(in, view.viewport) || !ReadCamera(in, view.camera))
+                    return false;
+            }
+
+            if (!Read(in, count)) return false;
+            frame.lights.resize(count);
+            for (Light& light : frame.lights) {
+                if (!Read(in, light.entity) || !Read(in, light.source) || !Read(in, light.world) || !ReadLight(in, light.light))
+                    return false;
+            }
+
+            if (!Read(in, count)) return false;
+            frame.instances.resize(count);
+            for (Instance& instance : frame.instances) {
+                u8 kind = 0;
+                if (!Read(in, kind) || !Read(in, instance.model) || !Read(in, instance.mesh) || !Read(in, instance.material)
+                    || !Read(in, instance.entity) || !Read(in, instance.world))
+                    return false;
+                instance.kind = (InstanceKind)kind;
+                if (instance.model >= models.size()) return false;
+                if (instance.kind != InstanceKind::Quantized) continue;
+                if (!Read(in, instance.local.position) || !Read(in, instance.local.rotation) || !Read(in, instance.local.scale))
+                    return false;
+            }
+
+            if (!Read(in, count)) return false;
+            frame.updated.resize(count);
+            if (!in.read(reinterpret_cast<char*>(frame.updated.data()), count * sizeof(entity_id))) return false;
+        }
+        return true;
+    }
+
+    RenderCaptureRecorder::RenderCaptureRecorder(const path& file, u32 frames, u32 delay, Material::TransparencyMode transparencyMode)
+        : m_file{ file }, m_frameCount{ std::max(frames, 1u) }, m_delay{ delay } {
+        m_capture.transparencyMode = transparencyMode;
+    }
+
+    u32 RenderCaptureRecorder::AddModel(const Model& model) {
+        auto [it, inserted] = m_modelIndex.emplace(&model, (u32)m_capture.models.size());
+        if (!inserted) return it->second;
+
+        if (model.getPath().empty())
+            Log::warn("Render capture: model without a resource path, its instances won't replay");
+        m_capture.models.push_back(RenderCapture::ModelSource{ model.getPath(), model.loadCfg });
+        // Plain Queue calls only get a mesh and a material, this is how they find their way back to a model
+        for (u32 i = 0; i < (u32)model.meshes.size(); i++)
+            m_meshIndex.emplace(&model.meshes[i], std::pair{ it->second, i });
+        for (u32 i = 0; i < (u32)model.materials.size(); i++)
+            m_materialIndex.emplace(&model.materials[i], i);
+        return it->second;
+    }
+
+    void RenderCaptureRecorder::RecordView(const WorldTransform& transform, const Component::Camera& camera, const vec4& viewport) {
+        if (!IsRecording()) return;
+        m_frame.views.push_back(RenderCapture::View{ transform.modelMatrix, camera, viewport });
+    }
+
+    void RenderCaptureRecorder::RecordMesh(const WorldTransform& transform, const Mesh* mesh, const Material* material) {
+        if (!IsRecording()) return;
+        auto mesh_it = m_meshIndex.find(mesh);
+        auto material_it = m_materialIndex.find(material);
+        if (mesh_it == m_meshIndex.end() || material_it == m_materialIndex.end()) {
+            m_skipped++;
+            return;
+        }
+
+        RenderCapture::Instance& instance = m_frame.instances.emplace_back();
+        instance.kind = RenderCapture::InstanceKind::Mesh;
+        instance.model = mesh_it->second.first;
+        instance.mesh = mesh_it->second.second;
+        instance.material = material_it->second;
+        instance.world = transform.modelMatrix;
+    }
+
+    void RenderCaptureRecorder::RecordDrawable(const WorldTransform& transform, const Drawable3D& drawable, entity_id entity) {
+        if (!IsRecording()) return;
+        RenderCapture::Instance& instance = m_frame.instances.emplace_back();
+        instance.kind = RenderCapture::InstanceKind::Drawable;
+        instance.model = AddModel(*drawable.model);
+        instance.mesh = drawable.collectionIndex;
+        instance.entity = entity;
+        instance.world = transform.modelMatrix;
+    }
+
+    void RenderCaptureRecorder::RecordQuantized(const Component::Transform& local, const WorldTransform& world, const Drawable3D& drawable) {
+        if (!IsRecording()) return;
+        RenderCapture::Instance& instance = m_frame.instances.emplace_back();
+        instance.kind = RenderCapture::InstanceKind::Quantized;
+        instance.model = AddModel(*drawable.model);
+        instance.mesh = drawable.collectionIndex;
+        instance.world = world.modelMatrix;
+        instance.local = local;
+    }
+
+    void RenderCaptureRecorder::RecordLight(const WorldTransform& transform, const Component::Light& light, entity_id entity) {
+        if (!IsRecording()) return;
+        u32 source = 0;
+        if (entity == null)
+            source = m_lightSources.emplace(&light, (u32)m_lightSources.size()).first->second;
+        m_frame.lights.push_back(RenderCapture::Light{ entity, source, transform.modelMatrix, light });
+    }
+
+    void RenderCaptureRecorder::RecordUpdated(const vector<entity_id>& entities) {
+        if (!IsRecording()) return;
+        m_frame.updated.insert(m_frame.updated.end(), entities.begin(), entities.end());
+    }
+
+    bool RenderCaptureRecorder::EndFrame() {
+        if (m_delay > 0) {
+            m_delay--;
+            return false;
+        }
+
+        m_capture.frames.push_back(std::move(m_frame));
+        m_frame = RenderCapture::Frame{};
+        if (m_capture.frames.size() < m_frameCount) return false;
+
+        if (m_skipped > 0)
+            Log::warn("Render capture: skipped {} instances queued with meshes outside of any drawable's model", m_skipped);
+        if (m_capture.Save(m_file))
+            Log::info("Saved render capture {} ({} frames, {} models)", m_file.string(), m_capture.frames.size(), m_capture.models.size());
+        else
+            Log::warn("Failed to write render capture {}", m_file.string());
+        return true;
+    }
+}
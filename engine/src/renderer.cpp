@@ -3,6 +3,7 @@
 #include <engine/application.hpp>
 #include <engine/perf_profiler.hpp>
 #include <algorithm>
+#include <bit>
 
 #include <engine/log.hpp>
 
@@ -16,6 +17,12 @@ namespace Engine {
     constexpr static struct {
         static constexpr size_t MAX_LIGHTS_GLOBAL = 32;
     } LightConfig;
+
+    // Color attachments of the main framebuffer used by weighted blended transparency
+    constexpr static struct {
+        u32 AccumAttachment = 1;     // RGBA16F, premultiplied color * weight, coverage * weight
+        u32 RevealageAttachment = 2; // R16F, product of (1 - alpha)
+    } OITConfig;
 }
 
 static const char* GLErrorToString(GLenum err) {
@@ -57,6 +64,11 @@ namespace Engine {
             dataFormat = GL_RGBA;
             type = GL_FLOAT;
             return;
+        case Framebuffer::TextureFormat::R16F:
+            internalFormat = GL_R16F;
+            dataFormat = GL_RED;
+            type = GL_FLOAT;
+            return;
         case Framebuffer::TextureFormat::DEPTH24_STENCIL8:
             internalFormat = GL_DEPTH24_STENCIL8;
             dataFormat = GL_DEPTH_STENCIL;
@@ -98,6 +110,15 @@ namespace Engine {
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 
+    void Framebuffer::SetDrawBuffers(u32 attachmentMask) const {
+        std::vector<GLenum> buffers(m_ColorAttachments.size(), GL_NONE);
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            if (attachmentMask & (1u << i))
+                buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+        }
+        glDrawBuffers(buffers.size(), buffers.data());
+    }
+
     void Framebuffer::Resize(uint32_t width, uint32_t height) {
         if (width == 0 || height == 0) {
             ENGINE_THROW("Attempting to resize framebuffer to zero size");
@@ -252,15 +273,24 @@ namespace Engine {
         Ref<ResourceSystem> rs = Engine::Application::Get().GetResourceSystem();
         Window& window = Engine::Application::Get().GetWindow();
 
+        m_textureStreamer = std::make_shared<TextureStreamer>();
+        m_backend = RHI::CreateBackend(RHI::BackendType::GL);
+
         // Drawing
-        glGenBuffers(1, &m_instanceSSBO); // Prepare our reusable ssbo for instancing
+        glGenBuffers(1, &m_instanceIndexSSBO); // Prepare our reusable ssbo for instancing
+        glGenBuffers(1, &m_quantizedSSBO);
         glGenBuffers(1, &m_instancesSSBO);
         glGenBuffers(1, &m_visibilitySSBO);
         glGenBuffers(1, &m_frustumUBO);
+        glGenBuffers(1, &m_deltaSlotsSSBO);
+        glGenBuffers(1, &m_deltaDataSSBO);
+        glGenQueries(GPU_TIMER_QUERIES, m_gpuTimerQueries);
 
         // Main framebuffer
         m_Framebuffer = new Framebuffer(window.GetWidth(), window.GetHeight());
         m_Framebuffer->AddColorAttachment({ .Format = Framebuffer::TextureFormat::RGBA16F })
+            .AddColorAttachment({ .Format = Framebuffer::TextureFormat::RGBA16F }) // OIT accumulation
+            .AddColorAttachment({ .Format = Framebuffer::TextureFormat::R16F })    // OIT revealage
             .SetDepthAttachment()
             .Build();
     
@@ -282,18 +312,34 @@ namespace Engine {
 
         // Shaders and other
         m_cullShader = new ComputeShader(vfs->GetEngineResourcePath("assets/shaders/culling.glsl"));
+        m_scatterShader = new ComputeShader(vfs->GetEngineResourcePath("assets/shaders/instance_scatter.glsl"));
         m_postProcessingShader = rs->load<Shader>(vfs->GetEngineResourcePath("assets/shaders/postprocess"));
         m_brightPassShader = rs->load<Shader>(vfs->GetEngineResourcePath("assets/shaders/postprocess_bright_extract"));
         m_blurShader = rs->load<Shader>(vfs->GetEngineResourcePath("assets/shaders/postprocess_blur"));
         m_depthPrepassShader = rs->load<Shader>(vfs->GetEngineResourcePath("assets/shaders/depth_prepass"));
+        m_oitCompositeShader = rs->load<Shader>(vfs->GetEngineResourcePath("assets/shaders/oit_composite"));
 
         // Prepare buffers
         static_assert(sizeof(GPU_LightData) == 64);
-
+        static_assert(sizeof(GPU_Affine) == 48);
+        static_assert(sizeof(GPU_QuantizedInstance) == 24);
+        static_assert(sizeof(GPU_InstanceData) == 64);
+
+        GLint lightAlignment = 1;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &lightAlignment);
+        lightAlignment = std::max(lightAlignment, 1);
+        m_lightRegionBytes = (LightConfig.MAX_LIGHTS_GLOBAL * sizeof(GPU_LightData) + lightAlignment - 1) / lightAlignment * lightAlignment;
+        for (std::vector<u8>& stale : m_lightRegionStale)
+            stale.assign(LightConfig.MAX_LIGHTS_GLOBAL, 1);
+
+        constexpr GLbitfield lightMapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
         glGenBuffers(1, &m_lightsSSBO);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightsSSBO);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, LightConfig.MAX_LIGHTS_GLOBAL * sizeof(GPU_LightData), nullptr, GL_DYNAMIC_DRAW);
+        glBufferStorage(GL_SHADER_STORAGE_BUFFER, m_lightRegionBytes * LIGHT_BUFFER_REGIONS, nullptr, lightMapFlags);
+        m_lightsMapped = (u8*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_lightRegionBytes * LIGHT_BUFFER_REGIONS, lightMapFlags);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        if (!m_lightsMapped)
+            ENGINE_THROW("Failed to map the light buffer");
 
         // Do skybox stuff
         m_skyboxShader = rs->load<Shader>(vfs->GetEngineResourcePath("assets/shaders/skybox"));
@@ -301,12 +347,24 @@ namespace Engine {
     }
 
     ENGINE_API Renderer::~Renderer() {
-        glDeleteBuffers(1, &m_instanceSSBO);
         delete m_cullShader;
-        glDeleteBuffers(1, &m_instanceSSBO);
+        delete m_scatterShader;
+        glDeleteBuffers(1, &m_instanceIndexSSBO);
+        for (GLsync& fence : m_lightFences)
+            if (fence) glDeleteSync(fence);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightsSSBO);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glDeleteBuffers(1, &m_lightsSSBO);
         glDeleteBuffers(1, &m_instancesSSBO);
+        glDeleteBuffers(1, &m_quantizedSSBO);
         glDeleteBuffers(1, &m_visibilitySSBO);
         glDeleteBuffers(1, &m_frustumUBO);
+        glDeleteBuffers(1, &m_deltaSlotsSSBO);
+        glDeleteBuffers(1, &m_deltaDataSSBO);
+        glDeleteQueries(GPU_TIMER_QUERIES, m_gpuTimerQueries);
+        for (PassQueries& frame : m_passQueries)
+            if (!frame.queries.empty()) glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
 
         delete m_Framebuffer;
         delete m_postProcessBrightFBO;
@@ -323,110 +381,384 @@ namespace Engine {
         if (m_skyboxCubemap) glDeleteTextures(1, &m_skyboxCubemap);
     }
 
-    void Renderer::SetCamera(Transform* transform, Camera* camera) {
-        m_cameraTransform = transform;
-        m_camera = camera;
-        m_hasCameraSet = (transform != nullptr && camera != nullptr);
+    void Renderer::SetCamera(WorldTransform* transform, Camera* camera) {
+        ClearViews();
+        AddView(transform, camera);
+    }
 
-        if (m_hasCameraSet) {
-            m_projViewMatrix = camera->projectionMatrix * camera->viewMatrix;
-            m_cameraPosition = transform->modelMatrix * vec4(transform->position, 1.0f); // TODO
-            m_cameraForward = transform->Forward();
-            ExtractFrustumPlanes();
+    u32 Renderer::AddView(WorldTransform* transform, Camera* camera, const vec4& viewport) {
+        if (!transform || !camera) return MAX_VIEWS;
+        if (m_views.size() >= MAX_VIEWS) {
+            Log::warn("Renderer supports at most {} views, ignoring the rest", MAX_VIEWS);
+            return MAX_VIEWS;
         }
+
+        m_views.push_back(ViewState{ transform, camera, viewport });
+        m_hasCameraSet = true;
+
+        // Outside of Draw the camera members describe the main view
+        if (m_views.size() == 1) ActivateView(m_views.front());
+        return (u32)m_views.size() - 1;
     }
 
-    void Renderer::Queue(Transform* transform, Mesh* mesh, Material* material) {
+    void Renderer::ClearViews() {
+        m_views.clear();
+        m_cameraTransform = nullptr;
+        m_camera = nullptr;
+        m_hasCameraSet = false;
+    }
+
+    void Renderer::ActivateView(const ViewState& view) {
+        m_cameraTransform = view.transform;
+        m_camera = view.camera;
+        m_projViewMatrix = view.camera->projectionMatrix * view.camera->viewMatrix;
+        m_cameraPosition = view.transform->Position();
+        m_cameraForward = view.transform->Forward();
+        ExtractFrustumPlanes();
+    }
+
+    void Renderer::GetViewRect(const ViewState& view, GLint& x, GLint& y, GLsizei& width, GLsizei& height) const {
+        u32 renderWidth, renderHeight;
+        GetRenderSize(renderWidth, renderHeight);
+        x = (GLint)std::lround(view.viewport.x * renderWidth);
+        y = (GLint)std::lround(view.viewport.y * renderHeight);
+        width = std::max<GLsizei>(1, (GLsizei)std::lround(view.viewport.z * renderWidth));
+        height = std::max<GLsizei>(1, (GLsizei)std::lround(view.viewport.w * renderHeight));
+    }
+
+    void Renderer::Queue(WorldTransform* transform, Mesh* mesh, Material* material) {
+        if (!mesh || !material || !material->shader) return;
+        if (m_capture) m_capture->RecordMesh(*transform, mesh, material);
+        QueueMesh(transform, mesh, material);
+    }
+
+    void Renderer::QueueMesh(WorldTransform* transform, Mesh* mesh, Material* material) {
         if (!mesh || !material || !material->shader) return;
 
-        // Enqueue for culling
-        m_gpuInstanceData.emplace_back(transform->modelMatrix, mesh->bsphere);
-        m_gpuInstances.emplace_back(transform, mesh, material);
+        // Enqueue for culling, transient so it's uploaded again every frame
+        m_gpuInstances.push_back(DrawInstance{ transform, mesh, material, false, 0, false, (u32)m_gpuInstanceData.size() });
+        m_gpuInstanceData.emplace_back(GPU_Affine(transform->modelMatrix), mesh->bsphere);
     }
 
-    void Renderer::QueueDrawable3D(Transform* transform, Component::Drawable3D* drawable) {
-        if (!drawable || !drawable->model) return;
+    void Renderer::QueueDrawable3D(WorldTransform* transform, Component::Drawable3D* drawable, entity_id entity) {
+        if (!transform || !drawable || !drawable->model) return;
+        if (m_capture) m_capture->RecordDrawable(*transform, *drawable, entity);
 
         // Queue all mesh entries in the collection
         const auto& collection = drawable->GetCollection();
-        for (const auto& entry : collection) {
-            Queue(transform, entry.mesh, entry.material);
+        if (entity == null) {
+            for (const auto& entry : collection) {
+                QueueMesh(transform, entry.mesh, entry.material);
+            }
+            return;
+        }
+
+        for (u32 i = 0; i < (u32)collection.size(); i++) {
+            const auto& entry = collection[i];
+            if (!entry.mesh || !entry.material || !entry.material->shader) continue;
+            u32 slot = AcquireInstanceSlot(entity, i, *transform, entry.mesh);
+            m_gpuInstances.push_back(DrawInstance{ transform, entry.mesh, entry.material, false, 0, true, slot });
+        }
+    }
+
+    void Renderer::MarkTransformsUpdated(const std::vector<entity_id>& entities) {
+        if (m_capture) m_capture->RecordUpdated(entities);
+        m_instanceSlots.MarkUpdated(entities);
+    }
+
+    u32 Renderer::AcquireInstanceSlot(entity_id entity, u32 entry, const WorldTransform& transform, Mesh* mesh) {
+        const auto [slot, rewrite] = m_instanceSlots.Acquire(entity, entry, mesh);
+        if (slot >= m_instanceTable.size()) m_instanceTable.resize(m_instanceSlots.Size());
+        if (rewrite) {
+            m_instanceTable[slot] = GPU_InstanceData{ GPU_Affine(transform.modelMatrix), mesh->bsphere };
+            m_deltaSlots.push_back(slot);
+            m_deltaData.push_back(m_instanceTable[slot]);
+        }
+        return slot;
+    }
+
+    void InstanceSlotTable::MarkUpdated(const std::vector<entity_id>& entities) {
+        for (entity_id entity : entities) {
+            if (entity >= m_entityMoved.size()) m_entityMoved.resize((entity * 2) + 1, 0);
+            m_entityMoved[entity] = m_frame;
+        }
+    }
+
+    InstanceSlotTable::Acquired InstanceSlotTable::Acquire(entity_id entity, u32 entry, const Mesh* mesh) {
+        const u64 key = ((u64)entity << 32) | entry;
+        auto [it, isNew] = m_index.try_emplace(key, 0u);
+        if (isNew) {
+            if (!m_free.empty()) {
+                it->second = m_free.back();
+                m_free.pop_back();
+            }
+            else {
+                it->second = (u32)m_slots.size();
+                m_slots.emplace_back();
+            }
+            m_slots[it->second] = Slot{ key };
+        }
+
+        // Compared against the last write rather than this frame, moves marked on frames that never queued it still count
+        Slot& slot = m_slots[it->second];
+        const bool moved = entity < m_entityMoved.size() && m_entityMoved[entity] > slot.written;
+        const bool rewrite = slot.lastSeen != m_frame && (isNew || moved || slot.mesh != mesh);
+        if (rewrite) {
+            slot.mesh = mesh;
+            slot.written = m_frame;
+        }
+        slot.lastSeen = m_frame;
+        return { it->second, rewrite };
+    }
+
+    void InstanceSlotTable::ReleaseUnseen() {
+        // The stale data left in a freed slot gets culled but nothing draws it
+        for (u32 i = 0; i < (u32)m_slots.size(); ++i) {
+            Slot& slot = m_slots[i];
+            if (!slot.mesh || slot.lastSeen == m_frame) continue;
+            m_index.erase(slot.key);
+            slot.mesh = nullptr;
+            m_free.push_back(i);
         }
     }
 
-    void Renderer::QueueLight(Transform* transform, Light* light) {
+    void InstanceSlotTable::EndFrame() {
+        m_frame++;
+    }
+
+    u32 Renderer::TableIndex(const DrawInstance& instance) const {
+        return instance.resident ? instance.slot : m_residentCapacity + instance.slot;
+    }
+
+    const Renderer::GPU_InstanceData& Renderer::TableData(u32 tableIndex) const {
+        return tableIndex < m_residentCapacity ? m_instanceTable[tableIndex] : m_gpuInstanceData[tableIndex - m_residentCapacity];
+    }
+
+    void Renderer::UploadInstances() {
+        // Slots that weren't queued are free again
+        m_instanceSlots.ReleaseUnseen();
+
+        const u32 residentCount = m_instanceSlots.Size();
+        const u32 transientCount = (u32)m_gpuInstanceData.size();
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instancesSSBO);
+
+        if (residentCount > m_residentCapacity || transientCount > m_transientCapacity) {
+            // Outgrew the buffer, the new one gets the whole resident table at once and the deltas are in it already
+            m_residentCapacity = std::max(m_residentCapacity, std::bit_ceil(std::max(residentCount, 1024u)));
+            m_transientCapacity = std::max(m_transientCapacity, std::bit_ceil(std::max(transientCount, 1024u)));
+            const size_t tableSize = (size_t)m_residentCapacity + m_transientCapacity;
+            glBufferData(GL_SHADER_STORAGE_BUFFER, tableSize * sizeof(GPU_InstanceData), nullptr, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, residentCount * sizeof(GPU_InstanceData), m_instanceTable.data());
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibilitySSBO);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, tableSize * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instancesSSBO);
+
+            m_stats.instanceBytes = residentCount * sizeof(GPU_InstanceData);
+            m_stats.instanceUpdates = residentCount;
+            m_deltaSlots.clear();
+            m_deltaData.clear();
+        }
+
+        // Transient instances sit after the resident capacity and are all new every frame
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)m_residentCapacity * sizeof(GPU_InstanceData),
+            transientCount * sizeof(GPU_InstanceData), m_gpuInstanceData.data());
+        m_stats.instanceBytes += transientCount * sizeof(GPU_InstanceData);
+
+        if (m_deltaSlots.empty()) return;
+
+        // Only the changed resident slots go over the bus, the scatter pass puts them where they belong
+        const u32 deltaCount = (u32)m_deltaSlots.size();
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_deltaSlotsSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, deltaCount * sizeof(u32), m_deltaSlots.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_deltaDataSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, deltaCount * sizeof(GPU_InstanceData), m_deltaData.data(), GL_STREAM_DRAW);
+
+        glUseProgram(m_scatterShader->program);
+        glUniform1ui(glGetUniformLocation(m_scatterShader->program, "uDeltaCount"), deltaCount);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_instancesSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_deltaSlotsSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_deltaDataSSBO);
+        glDispatchCompute((deltaCount + 63) / 64, 1, 1);
+
+        // Culling reads the table next
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glUseProgram(0);
+
+        m_stats.instanceBytes += deltaCount * (sizeof(u32) + sizeof(GPU_InstanceData));
+        m_stats.instanceUpdates = deltaCount;
+    }
+
+    void Renderer::QueueDrawable3DQuantized(const Transform* transform, WorldTransform* world, Component::Drawable3D* drawable) {
+        if (!transform || !world || !drawable || !drawable->model) return;
+        if (m_capture) m_capture->RecordQuantized(*transform, *world, *drawable);
+
+        for (const auto& entry : drawable->GetCollection()) {
+            if (!entry.mesh || !entry.material || !entry.material->shader) continue;
+            m_gpuInstances.push_back(DrawInstance{ world, entry.mesh, entry.material, true, (u32)m_quantizedData.size(), false, (u32)m_gpuInstanceData.size() });
+            m_gpuInstanceData.emplace_back(GPU_Affine(world->modelMatrix), entry.mesh->bsphere);
+            m_quantizedData.emplace_back(*transform);
+        }
+    }
+
+    static u32 PackSnorm2x16(float a, float b) {
+        auto pack = [](float v) { return (u32)(u16)(i16)std::round(std::clamp(v, -1.0f, 1.0f) * 32767.0f); };
+        return pack(a) | (pack(b) << 16);
+    }
+
+    Renderer::GPU_QuantizedInstance::GPU_QuantizedInstance(const Transform& transform)
+        : position{ transform.position }, scale{ transform.scale.x } {
+        glm::quat q = glm::normalize(transform.rotation);
+        rotation[0] = PackSnorm2x16(q.x, q.y);
+        rotation[1] = PackSnorm2x16(q.z, q.w);
+    }
+
+    void Renderer::QueueLight(WorldTransform* transform, Light* light, entity_id entity) {
         if (!transform || !light) return;
-        m_queuedLights.emplace_back(transform, light);
+        if (m_capture) m_capture->RecordLight(*transform, *light, entity);
+        // User space addresses never have the top bit set, so entity keys can't collide with them
+        u64 key = entity != null ? ((u64)entity | (1ull << 63)) : (u64)(uintptr_t)light;
+        m_queuedLights.emplace_back(key, transform, light);
     }
 
     void Renderer::ProcessQueue() {
         // No camera? No drawing
-        if (!m_camera) return;
+        if (m_views.empty()) return;
+        const u32 viewCount = (u32)m_views.size();
+
+        // Everything the batching needs from each view, computed once
+        Frustum frustums[MAX_VIEWS];
+        vec3 viewPositions[MAX_VIEWS];
+        float pixelScales[MAX_VIEWS]; // bounding sphere diameter -> pixels on screen at distance 1, for texture streaming
+        float nearPlanes[MAX_VIEWS];
+        u32 renderWidth, renderHeight;
+        GetRenderSize(renderWidth, renderHeight);
+        for (u32 v = 0; v < viewCount; ++v) {
+            ActivateView(m_views[v]);
+            frustums[v] = m_frustum;
+            viewPositions[v] = m_cameraPosition;
+            pixelScales[v] = m_camera->projectionMatrix[1][1] * 0.5f * (float)renderHeight * m_views[v].viewport.w;
+            nearPlanes[v] = m_camera->nearPlane;
+        }
 
         PERF_BEGIN("Renderer_Culling");
-        // Upload our queued stuff
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instancesSSBO);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, m_gpuInstanceData.size() * sizeof(GPU_InstanceData), m_gpuInstanceData.data(), GL_DYNAMIC_DRAW);
-        
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibilitySSBO);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, m_gpuInstanceData.size() * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
-        
+        // Bring the instance table up to date, it stays bound for drawing too
+        UploadInstances();
+        const u32 tableCount = m_residentCapacity + (u32)m_gpuInstanceData.size();
+
         glBindBuffer(GL_UNIFORM_BUFFER, m_frustumUBO);
-        glBufferData(GL_UNIFORM_BUFFER, sizeof(Frustum), &m_frustum, GL_DYNAMIC_DRAW);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(frustums), frustums, GL_DYNAMIC_DRAW);
 
-        // Bind and dispatch computer shader
+        // Bind and dispatch computer shader, one pass tests every view and writes a view mask per instance
         glUseProgram(m_cullShader->program);
+        glUniform1ui(glGetUniformLocation(m_cullShader->program, "uViewCount"), viewCount);
+        glUniform1ui(glGetUniformLocation(m_cullShader->program, "uInstanceCount"), tableCount);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_instancesSSBO);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_visibilitySSBO);
         glBindBufferBase(GL_UNIFORM_BUFFER, 3, m_frustumUBO);
-        glDispatchCompute((m_gpuInstanceData.size() + 255) / 256, 1, 1);
+        glDispatchCompute((tableCount + 255) / 256, 1, 1);
         
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
         glUseProgram(0);
+
+        // World space spheres for the projected sizes, done in one batch while the GPU culls
+        const size_t instanceCount = m_gpuInstances.size();
+        m_worldModels.Resize(instanceCount);
+        m_worldSpheres.Resize(instanceCount);
+        for (size_t i = 0; i < instanceCount; i++) {
+            const GPU_InstanceData& data = TableData(TableIndex(m_gpuInstances[i]));
+            m_worldModels.SetRows(i, data.model.rows);
+            m_worldSpheres.Set(i, data.bSphere.center, data.bSphere.radius);
+        }
+        SIMD::TransformSpheres(m_worldModels.Arrays(), m_worldSpheres.Arrays(), m_worldSpheres.Arrays(), instanceCount);
         PERF_END("Renderer_Culling");
 
         PERF_BEGIN("Renderer_Cmd");
         // Now we build the draw batches
         // Fetch data from gpu
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibilitySSBO);
-        uint32_t* visibleFlags = (uint32_t*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_gpuInstanceData.size() * sizeof(uint32_t), GL_MAP_READ_BIT);
+        uint32_t* visibleMasks = (uint32_t*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, tableCount * sizeof(uint32_t), GL_MAP_READ_BIT);
 
-        // Construct batches themselves
+        // Construct batches themselves, every view an instance is visible in gets it
         for (size_t i = 0; i < m_gpuInstances.size(); i++) {
-            if (!visibleFlags[i]) {
+            const DrawInstance& instance = m_gpuInstances[i];
+            const u32 tableIndex = TableIndex(instance);
+            u32 mask = visibleMasks[tableIndex];
+            if (!mask) {
                 m_stats.culledObjects++;
                 continue;
             }
 
-            // Determine if transparent
-            const DrawInstance& instance = m_gpuInstances[i];
-            if (instance.material->isTransparent) {
-                // Calculate distance to camera for sorting
-                float distance = 0.0f;
-                if (m_hasCameraSet) {
-                    vec3 objPos = instance.transform->position;
-                    distance = glm::length(m_cameraPosition - objPos);
+            const vec3 center = m_worldSpheres.Center(i);
+            const float radius = m_worldSpheres.Radius(i);
+            bool sorted = instance.material->isTransparent && !UsesOIT(*instance.material);
+
+            for (; mask; mask &= mask - 1) {
+                u32 v = (u32)std::countr_zero(mask);
+                ViewState& view = m_views[v];
+
+                // Largest projected size per material over all views, the textures of it get streamed to match
+                float distance = std::max(glm::length(center - viewPositions[v]), nearPlanes[v]);
+                float& pixels = m_materialPixels[instance.material];
+                pixels = std::max(pixels, 2.0f * radius * pixelScales[v] / distance);
+
+                if (sorted) {
+                    // Calculate distance to camera for sorting
+                    DrawCommand cmd;
+                    cmd.transform = instance.transform;
+                    cmd.mesh = instance.mesh;
+                    cmd.material = instance.material;
+                    cmd.distanceToCamera = glm::length(viewPositions[v] - instance.transform->Position());
+                    view.transparentQueue.push_back(cmd);
+                }
+                else {
+                    // Batch opaque objects, OIT transparent ones batch the same way since their order doesn't matter
+                    BatchKey key{ instance.mesh, instance.material, instance.material->shader.get(), instance.quantized };
+
+                    auto& batch = instance.material->isTransparent ? view.oitBatches[key] : view.opaqueBatches[key];
+                    batch.mesh = instance.mesh;
+                    batch.material = instance.material;
+                    batch.indices.push_back(instance.quantized ? instance.quantizedSlot : tableIndex);
                 }
-
-                DrawCommand cmd;
-                cmd.transform = instance.transform;
-                cmd.mesh = instance.mesh;
-                cmd.material = instance.material;
-                cmd.distanceToCamera = distance;
-                m_transparentQueue.push_back(cmd);
             }
-            else {
-                // Batch opaque objects
-                BatchKey key{ instance.mesh, instance.material, instance.material->shader.get() };
-
-                auto& batch = m_opaqueBatches[key];
-                batch.mesh = instance.mesh;
-                batch.material = instance.material;
-                batch.modelMatrices.push_back(instance.transform->modelMatrix);
+        }
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+
+        // Every view's batches go into one index buffer, the instance tables are shared and uploaded once
+        m_instanceIndices.clear();
+        for (ViewState& view : m_views) {
+            for (BatchMap* batches : { &view.opaqueBatches, &view.oitBatches }) {
+                for (auto& [key, batch] : *batches) {
+                    batch.offset = (u32)m_instanceIndices.size();
+                    m_instanceIndices.insert(m_instanceIndices.end(), batch.indices.begin(), batch.indices.end());
+                }
             }
         }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceIndexSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_instanceIndices.size() * sizeof(u32), m_instanceIndices.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_quantizedSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_quantizedData.size() * sizeof(GPU_QuantizedInstance), m_quantizedData.data(), GL_DYNAMIC_DRAW);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_instancesSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_quantizedSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_instanceIndexSSBO);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        m_stats.instanceBytes += m_quantizedData.size() * sizeof(GPU_QuantizedInstance)
+            + m_instanceIndices.size() * sizeof(u32);
         PERF_END("Renderer_Cmd");
+
+        PERF_BEGIN("Renderer_TextureStreaming");
+        for (auto& [material, pixels] : m_materialPixels) {
+            for (const Texture* tex : { material->diffuse.get(), material->specular.get(), material->normal.get(), material->emmisive.get() })
+                if (tex) m_textureStreamer->Request(tex, pixels);
+        }
+        m_materialPixels.clear();
+        m_textureStreamer->Update();
+        PERF_END("Renderer_TextureStreaming");
+
+        ActivateView(m_views.front());
     }
 
     void Renderer::Draw() {
@@ -435,22 +767,86 @@ namespace Engine {
         // Reset stats
         m_stats = Stats{};
         m_stats.totalObjects = m_gpuInstances.size();
+        m_stats.views = m_views.size();
+
+        // Pick this frame's resolution from timings that finished by now, then time this frame too
+        UpdateRenderScale();
+        m_stats.renderScale = m_renderScale;
+        m_stats.gpuFrameMs = m_gpuFrameMs;
+
+        if (m_capture) {
+            for (const ViewState& view : m_views)
+                m_capture->RecordView(*view.transform, *view.camera, view.viewport);
+        }
 
+        u32 timer = m_gpuTimerFrame++ % GPU_TIMER_QUERIES;
+        bool timed = !m_gpuTimerPending[timer];
+        if (timed) {
+            glBeginQuery(GL_TIME_ELAPSED, m_gpuTimerQueries[timer]);
+            m_gpuTimerScale[timer] = m_renderScale;
+        }
+
+        BeginPassTimings();
+        BeginPass(RenderPass::Culling);
         ProcessQueue(); // Run global culling and fill command buffer
+        EndPass(RenderPass::Culling);
+        BeginPass(RenderPass::Lights);
         ProcessLights(); // Process lights into GPU format
+        EndPass(RenderPass::Lights);
         
         BeginFramebufferPass();
+        m_Framebuffer->SetDrawBuffers(1u << 0);
+
+        u32 renderWidth, renderHeight;
+        GetRenderSize(renderWidth, renderHeight);
+        glViewport(0, 0, renderWidth, renderHeight);
 
         glClearColor(m_glState.clearColor.r, m_glState.clearColor.g, m_glState.clearColor.b, m_glState.clearColor.a);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
+
+        for (ViewState& view : m_views) {
+            DrawView(view);
+        }
+        ActivateView(m_views.front());
+
+        BeginPass(RenderPass::PostProcess);
+        EndFramebufferPass();
+        EndPass(RenderPass::PostProcess);
+        if (m_passFrame) m_passFrame->pending = true;
+
+        // The light region this frame read can be rewritten once the GPU is past this point
+        m_lightFences[m_lightRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        if (timed) {
+            glEndQuery(GL_TIME_ELAPSED);
+            m_gpuTimerPending[timer] = true;
+        }
+    }
+
+    void Renderer::DrawView(ViewState& view) {
+        ActivateView(view);
+
+        GLint x, y;
+        GLsizei width, height;
+        GetViewRect(view, x, y, width, height);
+        glViewport(x, y, width, height);
+
+        // Later views can overlap earlier ones (minimap, picture in picture), they start from a clean rect
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x, y, width, height);
+        if (&view != &m_views.front()) {
+            glDepthMask(GL_TRUE);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
 
         // Depth Prepass
         glEnable(GL_DEPTH_TEST);
         glDepthMask(GL_TRUE);
         glDepthFunc(GL_LESS);
         glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-        DrawDepthPrepass();
+        BeginPass(RenderPass::DepthPrepass);
+        DrawDepthPrepass(view);
+        EndPass(RenderPass::DepthPrepass);
         glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
         // glDepthMask(GL_FALSE); // this comment made it work? but isn't that like the point of a depth prepass?
         
@@ -472,28 +868,45 @@ namespace Engine {
         // glDepthMask(GL_TRUE);
         // glDepthFunc(GL_EQUAL);
         // Render opaque geometry
-        DrawOpaque();
+        BeginPass(RenderPass::Opaque);
+        DrawOpaque(view);
+        EndPass(RenderPass::Opaque);
+
+        // Render transparent geometry, OIT is resolved first so sorted objects end up on top of it
+        BeginPass(RenderPass::Transparent);
+        if (!view.oitBatches.empty()) {
+            DrawTransparentOIT(view);
+        }
 
-        // Render transparent geometry
-        if (!m_transparentQueue.empty()) {
+        if (!view.transparentQueue.empty()) {
             glDepthMask(GL_TRUE);
             glDepthFunc(GL_LESS);
             glEnable(GL_BLEND);
             glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            DrawTransparent();
+            DrawTransparent(view);
             glDisable(GL_BLEND);
         }
+        EndPass(RenderPass::Transparent);
 
-        EndFramebufferPass();
+        glDisable(GL_SCISSOR_TEST);
     }
 
     void Renderer::Clear() {
-        m_opaqueBatches.clear();
-        m_transparentQueue.clear();
+        for (ViewState& view : m_views) {
+            view.opaqueBatches.clear();
+            view.oitBatches.clear();
+            view.transparentQueue.clear();
+        }
+        m_instanceIndices.clear();
         m_queuedLights.clear();
-        m_processedLights.clear();
         m_gpuInstanceData.clear();
+        m_quantizedData.clear();
         m_gpuInstances.clear();
+        m_deltaSlots.clear();
+        m_deltaData.clear();
+        m_instanceSlots.EndFrame();
+        if (m_capture && m_capture->EndFrame())
+            m_capture.reset();
         if (m_Stats.size() > 10) m_Stats.pop_back();
         m_Stats.insert(m_Stats.begin(), m_stats);
         m_stats = Stats{};
@@ -501,71 +914,145 @@ namespace Engine {
 
     // ========== Light Processing ==========
 
+    static bool SameLight(const Component::Light& a, const Component::Light& b) {
+        return a.type == b.type && a.color == b.color && a.intensity == b.intensity && a.range == b.range && a.direction == b.direction
+            && a.innerCutoffRadians == b.innerCutoffRadians && a.outerCutoffRadians == b.outerCutoffRadians;
+    }
+
     void Renderer::ProcessLights() {
-        // Expected bottleneck due to CPU sided matrix processing, we don't care
-        m_processedLights.clear();
-        m_processedLights.reserve(m_queuedLights.size());
+        const u64 frame = ++m_lightFrame;
+
+        // Give every queued light its slot, new and changed ones get repacked
+        size_t dropped = 0;
+        for (const QueuedLight& queued : m_queuedLights) {
+            auto it = m_lightSlotIndex.find(queued.key);
+            bool isNew = it == m_lightSlotIndex.end();
+            if (isNew && m_lightSlots.size() >= LightConfig.MAX_LIGHTS_GLOBAL) {
+                dropped++;
+                continue;
+            }
 
-        // Process ECS lights into GPU format
-        constexpr float PAD = 0.0f;
-        for (const auto& [transform, light] : m_queuedLights) {
-            GPU_LightData data;
-            vec3 worldPos = vec3(transform->modelMatrix[3]); // Get world position from recursively calculated hierarchical matrix
-            vec3 worldDir = (light->type == Light::Type::POINT) ? vec3(0.0f) : (light->type == Light::Type::SPOT) ? glm::normalize(transform->Forward()) : light->direction; // World direction, since light->direction is local
-
-            data.positionAndType = vec4{
-                worldPos,
-                static_cast<float>(light->type)
-            };
-
-            data.directionAndRange = vec4{
-                worldDir,
-                light->range
-            };
-
-            data.colorAndIntensity = vec4{
-                light->color,
-                light->intensity
-            };
-
-            data.spotAnglesRadians = vec4{
-                light->innerCutoffRadians,
-                light->outerCutoffRadians,
-                PAD, PAD
-            };
-
-            m_processedLights.emplace_back(data);
+            u32 slot;
+            if (isNew) {
+                slot = (u32)m_lightSlots.size();
+                m_lightSlots.emplace_back().key = queued.key;
+                m_lightData.emplace_back();
+                m_lightSlotIndex.emplace(queued.key, slot);
+            }
+            else slot = it->second;
+
+            LightSlot& entry = m_lightSlots[slot];
+            if (isNew || entry.modelMatrix != queued.transform->modelMatrix || !SameLight(entry.source, *queued.light)) {
+                entry.modelMatrix = queued.transform->modelMatrix;
+                entry.source = *queued.light;
+                entry.dirty = true;
+            }
+            entry.transform = queued.transform;
+            entry.light = queued.light;
+            entry.lastSeen = frame;
+        }
+        if (dropped) {
+            Log::warn("Light count {} exceeds MAX_LIGHTS_GLOBAL {}, dropping {} lights",
+                m_queuedLights.size(), LightConfig.MAX_LIGHTS_GLOBAL, dropped);
         }
 
-        // Upload to GPU - Reuse SSBO buffer with global light cap in mind
-        if (!m_processedLights.empty()) {
-            const size_t upload_Count = std::min(LightConfig.MAX_LIGHTS_GLOBAL, m_processedLights.size());
-            if (m_processedLights.size() > LightConfig.MAX_LIGHTS_GLOBAL) {
-                Log::warn("Light count {} exceeds MAX_LIGHTS_GLOBAL {}, dropping {} lights",
-                    m_processedLights.size(), LightConfig.MAX_LIGHTS_GLOBAL,
-                    m_processedLights.size() - LightConfig.MAX_LIGHTS_GLOBAL);
+        // Lights that weren't queued give their slot up, the last one moves into the hole so the slots stay dense
+        for (u32 slot = 0; slot < m_lightSlots.size();) {
+            if (m_lightSlots[slot].lastSeen == frame) {
+                slot++;
+                continue;
             }
-            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightsSSBO);
-            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, upload_Count * sizeof(GPU_LightData), m_processedLights.data());
+            m_lightSlotIndex.erase(m_lightSlots[slot].key);
+            u32 last = (u32)m_lightSlots.size() - 1;
+            if (slot != last) {
+                m_lightSlots[slot] = m_lightSlots[last];
+                m_lightData[slot] = m_lightData[last];
+                m_lightSlots[slot].dirty = true;
+                m_lightSlotIndex[m_lightSlots[slot].key] = slot;
+            }
+            m_lightSlots.pop_back();
+            m_lightData.pop_back();
         }
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // Repack only what changed. Serial: at MAX_LIGHTS_GLOBAL lights the whole pack is cheaper than forking threads
+        m_dirtyLights.clear();
+        for (u32 slot = 0; slot < m_lightSlots.size(); ++slot) {
+            if (!m_lightSlots[slot].dirty) continue;
+            m_lightSlots[slot].dirty = false;
+            m_dirtyLights.push_back(slot);
+            for (std::vector<u8>& stale : m_lightRegionStale)
+                stale[slot] = 1;
+        }
+
+        const int dirtyCount = (int)m_dirtyLights.size();
+        for (int i = 0; i < dirtyCount; ++i) {
+            u32 slot = m_dirtyLights[i];
+            m_lightData[slot] = PackLight(*m_lightSlots[slot].transform, *m_lightSlots[slot].light);
+        }
+        m_stats.lightUpdates = dirtyCount;
+
+        // Next region, it's up to LIGHT_BUFFER_REGIONS - 1 frames behind so only the slots changed since get copied
+        m_lightRegion = (m_lightRegion + 1) % LIGHT_BUFFER_REGIONS;
+        GLsync& fence = m_lightFences[m_lightRegion];
+        if (fence) {
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        GPU_LightData* region = (GPU_LightData*)(m_lightsMapped + m_lightRegion * m_lightRegionBytes);
+        std::vector<u8>& stale = m_lightRegionStale[m_lightRegion];
+        for (u32 slot = 0; slot < m_lightData.size(); ++slot) {
+            if (!stale[slot]) continue;
+            region[slot] = m_lightData[slot];
+            stale[slot] = 0;
+        }
+    }
+
+    Renderer::GPU_LightData Renderer::PackLight(const WorldTransform& transform, const Light& light) {
+        constexpr float PAD = 0.0f;
+        GPU_LightData data;
+        vec3 worldPos = transform.Position(); // Get world position from recursively calculated hierarchical matrix
+        vec3 worldDir = (light.type == Light::Type::POINT) ? vec3(0.0f) : (light.type == Light::Type::SPOT) ? transform.Forward() : light.direction; // World direction, since light.direction is local
+
+        data.positionAndType = vec4{
+            worldPos,
+            static_cast<float>(light.type)
+        };
+
+        data.directionAndRange = vec4{
+            worldDir,
+            light.range
+        };
+
+        data.colorAndIntensity = vec4{
+            light.color,
+            light.intensity
+        };
+
+        data.spotAnglesRadians = vec4{
+            light.innerCutoffRadians,
+            light.outerCutoffRadians,
+            PAD, PAD
+        };
+        return data;
     }
 
     // ======== Other ==========
 
     void Renderer::SetLightUniforms(Shader* shader) {
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_lightsSSBO);
+        m_commands.BindStorageRange(1, m_lightsSSBO, (u32)(m_lightRegion * m_lightRegionBytes), (u32)m_lightRegionBytes);
         if (shader->HasUniform("uNumLights"))
-            shader->SetUniform("uNumLights", static_cast<int>(m_processedLights.size()));
+            RecordUniform(shader, "uNumLights", static_cast<int>(m_lightData.size()));
         if (shader->HasUniform("uAmbientLight"))
-            shader->SetUniform("uAmbientLight", vec3(0.0, 0.0, 0.0));
+            RecordUniform(shader, "uAmbientLight", vec3(0.0, 0.0, 0.0));
     }
 
     void Renderer::SetCommonUniforms(Shader* shader) {
-        auto& window = Application::Get().GetWindow();
-        shader->SetUniform("uProjView", m_projViewMatrix);
+        RecordUniform(shader, "uProjView", m_projViewMatrix);
         
-        if (shader->HasUniform("uViewPos")) shader->SetUniform("uViewPos", m_cameraPosition);
+        if (shader->HasUniform("uViewPos")) RecordUniform(shader, "uViewPos", m_cameraPosition);
+        if (shader->HasUniform("uOITPass")) RecordUniform(shader, "uOITPass", m_oitPass);
         SetLightUniforms(shader);
     }
 
@@ -574,134 +1061,211 @@ namespace Engine {
 
         // Set material properties
         if (material->renderType == Material::RenderType::LIT) {
-            shader->SetUniform("uMaterial.diffuseColor", material->diffuseColor);
-            shader->SetUniform("uMaterial.specularColor", material->specularColor);
-            shader->SetUniform("uMaterial.shininess", material->shininess);
+            RecordUniform(shader, "uMaterial.diffuseColor", material->diffuseColor);
+            RecordUniform(shader, "uMaterial.specularColor", material->specularColor);
+            RecordUniform(shader, "uMaterial.shininess", material->shininess);
             if (material->isTransparent)
-                shader->SetUniform("uMaterial.opacity", material->opacity);
+                RecordUniform(shader, "uMaterial.opacity", material->opacity);
         }
         
         // Set textures (only for textured materials)
         if (material->renderType == Material::RenderType::TEXTURED) {
             if (material->diffuse && material->diffuse->id) {
-                shader->SetUniform("uMaterial.diffuseMap", *material->diffuse, Shader::TextureSlot::DIFFUSE);
+                RecordTexture(shader, "uMaterial.diffuseMap", *material->diffuse, Shader::TextureSlot::DIFFUSE);
             }
             if (material->specular && material->specular->id) {
-                shader->SetUniform("uMaterial.specularMap", *material->specular, Shader::TextureSlot::SPECULAR);
+                RecordTexture(shader, "uMaterial.specularMap", *material->specular, Shader::TextureSlot::SPECULAR);
             }
             if (material->normal && material->normal->id) {
-                shader->SetUniform("uMaterial.normalMap", *material->normal, Shader::TextureSlot::NORMAL);
+                RecordTexture(shader, "uMaterial.normalMap", *material->normal, Shader::TextureSlot::NORMAL);
             }
             /*if (material->emmisive && (material->emmisive->id)) {
                 shader->SetUniform("uMaterial.emmisiveMap", *material->emmisive, Shader::TextureSlot::EMMISIVE);
             }*/
-            shader->SetUniform("uMaterial.shininess", material->shininess);
+            RecordUniform(shader, "uMaterial.shininess", material->shininess);
             // shader->SetUniform("uMaterial.emmisiveIntensity", material->emmisiveIntensity);
             // shader->SetUniform("uMaterial.emmisiveColor", material->emmisiveColor);
         }
 
         if (material->renderType == Material::RenderType::EMMISIVE) {
             if (material->diffuse && material->diffuse->id) {
-                shader->SetUniform("uMaterial.diffuseMap", *material->diffuse, Shader::TextureSlot::DIFFUSE);
+                RecordTexture(shader, "uMaterial.diffuseMap", *material->diffuse, Shader::TextureSlot::DIFFUSE);
             }
             if (material->emmisive && (material->emmisive->id)) {
-                shader->SetUniform("uMaterial.emmisiveMap", *material->emmisive, Shader::TextureSlot::EMMISIVE);
+                RecordTexture(shader, "uMaterial.emmisiveMap", *material->emmisive, Shader::TextureSlot::EMMISIVE);
             }
             if (material->isTransparent)
-                shader->SetUniform("uMaterial.opacity", material->opacity);
-            shader->SetUniform("uMaterial.emmisiveIntensity", material->emmisiveIntensity);
-            shader->SetUniform("uMaterial.emmisiveColor", material->emmisiveColor);
+                RecordUniform(shader, "uMaterial.opacity", material->opacity);
+            RecordUniform(shader, "uMaterial.emmisiveIntensity", material->emmisiveIntensity);
+            RecordUniform(shader, "uMaterial.emmisiveColor", material->emmisiveColor);
         }
     }
 
     // ========== Drawing ==========
 
-    void Renderer::DrawDepthPrepass() {
-        m_depthPrepassShader->Enable();
-        m_depthPrepassShader->SetUniform("uProjView", m_projViewMatrix);
+    void Renderer::BindInstances(const BatchKey& key, const InstanceBatch& batch, Shader* shader) {
+        // Tables and the index buffer are bound for the whole frame, a batch only picks its range of indices
+        RecordUniform(shader, "uUseInstancing", true);
+        RecordUniform(shader, "uQuantizedInstances", key.quantized);
+        RecordUniform(shader, "uInstanceOffset", (int)batch.offset);
+    }
+
+    void Renderer::RecordShader(Shader* shader) {
+        if (!shader->program) ENGINE_THROW("Attempting to use uninitialized shader program");
+        m_commands.BindPipeline(shader->program);
+    }
+
+    void Renderer::RecordTexture(Shader* shader, const std::string& name, const Texture& texture, Shader::TextureSlot slot) {
+        m_commands.BindTexture((u32)slot, texture.id);
+        RecordUniform(shader, name, static_cast<int>(slot));
+    }
+
+    void Renderer::RecordDraw(const Mesh& mesh, u32 instanceCount) {
+        m_commands.BindVertexArray(mesh.vao);
+        m_commands.DrawIndexed(mesh.indicesCount, instanceCount);
+    }
 
-        for (const auto& [key, batch] : m_opaqueBatches) {
-            if (batch.modelMatrices.size() == 1) {
+    void Renderer::Submit() {
+        m_stats.rhiCommands += m_commands.Size();
+        m_backend->Execute(m_commands);
+        m_commands.Clear();
+    }
+
+    void Renderer::DrawDepthPrepass(const ViewState& view) {
+        Shader* shader = m_depthPrepassShader.get();
+        RecordShader(shader);
+        RecordUniform(shader, "uProjView", m_projViewMatrix);
+
+        for (const auto& [key, batch] : view.opaqueBatches) {
+            if (!key.quantized && batch.size() == 1) {
                 // Single object - standard draw
-                m_depthPrepassShader->SetUniform("uModel", batch.modelMatrices[0]);
-                m_depthPrepassShader->SetUniform("uUseInstancing", false);
-                glBindVertexArray(key.mesh->vao);
-                glDrawElements(GL_TRIANGLES, key.mesh->indicesCount, GL_UNSIGNED_INT, 0);
+                RecordUniform(shader, "uModel", TableData(batch.indices[0]).model.ToMat4());
+                RecordUniform(shader, "uUseInstancing", false);
+                RecordDraw(*key.mesh);
             }
             else {
-                /// Multiple objects - prepare an SSBO and do an instanced draw
-                // Fill SSBO with data
-                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceSSBO);
-                glBufferData(GL_SHADER_STORAGE_BUFFER, batch.modelMatrices.size() * sizeof(mat4), batch.modelMatrices.data(), GL_DYNAMIC_DRAW);
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_instanceSSBO);
-                SetLightUniforms(m_depthPrepassShader.get());
+                /// Multiple objects - an instanced draw over the batch's range of the index buffer
+                BindInstances(key, batch, shader);
+                SetLightUniforms(shader);
 
                 // Draw our stuff
-                m_depthPrepassShader->SetUniform("uUseInstancing", true);
-                glBindVertexArray(key.mesh->vao);
-                glDrawElementsInstanced(GL_TRIANGLES, key.mesh->indicesCount, GL_UNSIGNED_INT, 0, batch.modelMatrices.size());
+                RecordDraw(*key.mesh, (u32)batch.size());
             }
         }
+        Submit();
     }
 
-    void Renderer::DrawOpaque() {
-        m_stats.batchCount = m_opaqueBatches.size();
+    void Renderer::DrawOpaque(const ViewState& view) {
+        m_stats.batchCount += view.opaqueBatches.size();
+        DrawBatches(view.opaqueBatches);
+    }
 
-        for (const auto& [key, batch] : m_opaqueBatches) {
+    void Renderer::DrawBatches(const BatchMap& batches) {
+        for (const auto& [key, batch] : batches) {
             Shader* shader = key.shader;
-            shader->Enable();
+            RecordShader(shader);
 
             // Set common uniforms once per batch
             SetCommonUniforms(shader);
             SetMaterialUniforms(key.material);
 
-            if (batch.modelMatrices.size() == 1) {
+            if (!key.quantized && batch.size() == 1) {
                 // Single object - standard draw
-                shader->SetUniform("uModel", batch.modelMatrices[0]);
-                shader->SetUniform("uUseInstancing", false);
-                key.mesh->Draw();
+                RecordUniform(shader, "uModel", TableData(batch.indices[0]).model.ToMat4());
+                RecordUniform(shader, "uUseInstancing", false);
+                RecordDraw(*key.mesh);
                 m_stats.drawCalls++;
                 m_stats.drawnObjects++;
             }
             else {
-                /// Multiple objects - prepare an SSBO and do an instanced draw
-                // Fill SSBO with data
-                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceSSBO);
-                glBufferData(GL_SHADER_STORAGE_BUFFER, batch.modelMatrices.size() * sizeof(mat4), batch.modelMatrices.data(), GL_DYNAMIC_DRAW);
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_instanceSSBO);
+                /// Multiple objects - an instanced draw over the batch's range of the index buffer
+                BindInstances(key, batch, shader);
 
                 // Draw our stuff
-                shader->SetUniform("uUseInstancing", true);
-                key.mesh->Bind(); // set base mesh
-                glDrawElementsInstanced(GL_TRIANGLES, key.mesh->indicesCount, GL_UNSIGNED_INT, 0, batch.modelMatrices.size());
+                RecordDraw(*key.mesh, (u32)batch.size());
 
                 m_stats.instancedDrawCalls++;
-                m_stats.drawnObjects += batch.modelMatrices.size();
+                m_stats.drawnObjects += batch.size();
             }
         }
+        Submit();
     }
 
-    void Renderer::DrawTransparent() {
+    void Renderer::DrawTransparent(ViewState& view) {
         // Sort back-to-front (furthest first)
-        std::sort(m_transparentQueue.begin(), m_transparentQueue.end(),
+        std::sort(view.transparentQueue.begin(), view.transparentQueue.end(),
             [](const DrawCommand& a, const DrawCommand& b) {
                 return a.distanceToCamera > b.distanceToCamera;
         });
 
-        for (const DrawCommand& cmd : m_transparentQueue) {
+        for (const DrawCommand& cmd : view.transparentQueue) {
             Shader* shader = cmd.material->shader.get();
-            shader->Enable();
+            RecordShader(shader);
 
             // Set uniforms
             SetCommonUniforms(shader);
             SetMaterialUniforms(cmd.material);
-            shader->SetUniform("uModel", cmd.transform->modelMatrix);
-            shader->SetUniform("uUseInstancing", false);
+            RecordUniform(shader, "uModel", cmd.transform->modelMatrix);
+            RecordUniform(shader, "uUseInstancing", false);
 
             // Draw
-            cmd.mesh->Draw();
+            RecordDraw(*cmd.mesh);
             m_stats.drawCalls++;
         }
+        Submit();
+    }
+
+    void Renderer::DrawTransparentOIT(const ViewState& view) {
+        // Accumulate, every fragment adds its weighted premultiplied color and multiplies the revealage down,
+        // both commute so the batches go in whatever order the map has them
+        m_Framebuffer->SetDrawBuffers((1u << OITConfig.AccumAttachment) | (1u << OITConfig.RevealageAttachment));
+        const float accumClear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        const float revealageClear[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glClearBufferfv(GL_COLOR, OITConfig.AccumAttachment, accumClear);
+        glClearBufferfv(GL_COLOR, OITConfig.RevealageAttachment, revealageClear);
+
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_FALSE); // opaque depth still occludes, transparent surfaces don't hide each other
+        glEnable(GL_BLEND);
+        glBlendFunci(OITConfig.AccumAttachment, GL_ONE, GL_ONE);
+        glBlendFunci(OITConfig.RevealageAttachment, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+
+        m_oitPass = true;
+        DrawBatches(view.oitBatches);
+        m_oitPass = false;
+
+        for (const auto& [key, batch] : view.oitBatches)
+            m_stats.oitObjects += batch.size();
+
+        // Composite the weighted average over the opaque scene, revealage is how much of the scene shows through
+        m_Framebuffer->SetDrawBuffers(1u << 0);
+        glDisable(GL_DEPTH_TEST);
+        glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+
+        m_oitCompositeShader->Enable();
+        m_oitCompositeShader->SetUniform("uAccumTexture", 0);
+        m_oitCompositeShader->SetUniform("uRevealageTexture", 1);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_Framebuffer->GetColorAttachment(OITConfig.AccumAttachment)->id);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, m_Framebuffer->GetColorAttachment(OITConfig.RevealageAttachment)->id);
+
+        glBindVertexArray(m_screenQuadVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glBindVertexArray(0);
+
+        // Back to what the sorted pass expects
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+    }
+
+    bool Renderer::UsesOIT(const Material& material) const {
+        Material::TransparencyMode mode = material.transparencyMode;
+        if (mode == Material::TransparencyMode::Default)
+            mode = m_transparencyMode;
+        return mode == Material::TransparencyMode::OIT;
     }
 
     // ========== Framebuffer Management ==========
@@ -893,10 +1457,40 @@ namespace Engine {
         m_glState.clearColor = clearColor;
     }
 
+    void Renderer::SetDynamicResolution(const DynamicResolutionConfig& config) {
+        m_dynamicResolution = config;
+        m_dynamicResolution.maxScale = std::clamp(config.maxScale, 0.1f, 1.0f);
+        m_dynamicResolution.minScale = std::clamp(config.minScale, 0.1f, m_dynamicResolution.maxScale);
+        m_dynamicResolution.targetFrameMs = std::max(config.targetFrameMs, 0.1f);
+        m_renderScale = std::clamp(m_renderScale, m_dynamicResolution.minScale, m_dynamicResolution.maxScale);
+    }
+
+    void Renderer::SetBackend(RHI::BackendType type) {
+        if (m_backend && m_backend->GetType() == type) return;
+        m_backend = RHI::CreateBackend(type);
+        Log::info("Renderer backend: {}", RHI::GetBackendName(type));
+    }
+
+    void Renderer::CaptureFrames(const path& file, u32 frames, u32 delay) {
+        m_capture = std::make_unique<RenderCaptureRecorder>(file, frames, delay, m_transparencyMode);
+        Log::info("Capturing {} renderer frames to {}", std::max(frames, 1u), file.string());
+    }
+
+    void Renderer::SetTransparencyMode(Material::TransparencyMode mode) {
+        // Default on the renderer itself would mean nothing, keep sorting
+        m_transparencyMode = mode == Material::TransparencyMode::Default ? Material::TransparencyMode::Sorted : mode;
+    }
+
     void Renderer::RunPostProcessPipeline() {
         glDisable(GL_DEPTH_TEST);
         glDisable(GL_BLEND);
 
+        // The scene only covers the scaled viewport, bloom runs at that size too and the composite upscales
+        u32 renderWidth, renderHeight;
+        GetRenderSize(renderWidth, renderHeight);
+        vec2 uvScale = vec2((float)renderWidth / m_Framebuffer->GetWidth(), (float)renderHeight / m_Framebuffer->GetHeight());
+        glViewport(0, 0, renderWidth, renderHeight);
+
         // Scene output
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, m_Framebuffer->GetColorAttachment(0)->id);
@@ -908,6 +1502,7 @@ namespace Engine {
         m_brightPassShader->Enable(); // *global* Shader for extracting bright pixels
         m_brightPassShader->SetUniform("uSceneTexture", 0);
         m_brightPassShader->SetUniform("uThreshold", RendererConfig.BrightnessThreshold); // Brightness threshold
+        m_brightPassShader->SetUniform("uUVScale", uvScale);
 
         // glBindFramebuffer(GL_FRAMEBUFFER, m_brightPassFBO); // *global* FBO for bright-pass output
         m_postProcessBrightFBO->Bind();
@@ -921,6 +1516,7 @@ namespace Engine {
         int blurPasses = 10; // Number of blur iterations (5 horizontal + 5 vertical)
 
         m_blurShader->Enable(); // *global* Shader for Gaussian blur
+        m_blurShader->SetUniform("uUVScale", uvScale);
 
         for (int i = 0; i < blurPasses; i++) {
             // glBindFramebuffer(GL_FRAMEBUFFER, m_bloomPingPongFbos[horizontal ? 1 : 0]); // *global* Two FBOs for ping-pong blur
@@ -943,6 +1539,8 @@ namespace Engine {
         m_postProcessingShader->SetUniform("uSceneTexture", 0); // Original scene
         m_postProcessingShader->SetUniform("uBloomTexture", 1); // Blurred bright areas
         m_postProcessingShader->SetUniform("uBloomStrength", RendererConfig.BloomStrength); // Bloom intensity
+        m_postProcessingShader->SetUniform("uUVScale", uvScale);
+        m_postProcessingShader->SetUniform("uSharpness", uvScale.x < 1.0f ? m_dynamicResolution.sharpness : 0.0f);
 
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, m_Framebuffer->GetColorAttachment()->id);
@@ -950,12 +1548,138 @@ namespace Engine {
         glBindTexture(GL_TEXTURE_2D, m_postProcessPongFBO[!horizontal ? 1 : 0]->GetColorAttachment(0)->id); // Final blurred result
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, m_Framebuffer->GetWidth(), m_Framebuffer->GetHeight());
         glDisable(GL_DEPTH_TEST);
 
         glBindVertexArray(m_screenQuadVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
     }
 
+    // ========== Pass Timing ==========
+
+    const char* Renderer::GetPassName(RenderPass pass) {
+        switch (pass) {
+        case RenderPass::Culling: return "Culling";
+        case RenderPass::Lights: return "Lights";
+        case RenderPass::DepthPrepass: return "DepthPrepass";
+        case RenderPass::Opaque: return "Opaque";
+        case RenderPass::Transparent: return "Transparent";
+        case RenderPass::PostProcess: return "PostProcess";
+        default: return "Unknown";
+        }
+    }
+
+    void Renderer::SetPassTimingEnabled(bool enabled) {
+        m_passTiming = enabled;
+        if (enabled) return;
+        for (float& ms : m_passGpuMs) ms = 0.0f;
+    }
+
+    void Renderer::ReadPassTimings() {
+        // Same ring as the frame timer, newest finished frame wins
+        for (u32 i = 0; i < GPU_TIMER_QUERIES; ++i) {
+            PassQueries& frame = m_passQueries[(m_passFrameIndex + i) % GPU_TIMER_QUERIES];
+            if (!frame.pending) continue;
+
+            // Timestamps land in order, the last one being there means all of them are
+            GLint available = 0;
+            if (frame.used > 0) glGetQueryObjectiv(frame.queries[frame.used * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (frame.used > 0 && !available) continue;
+
+            float ms[(size_t)RenderPass::Count] = {};
+            for (u32 pair = 0; pair < frame.used; ++pair) {
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(frame.queries[pair * 2], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(frame.queries[pair * 2 + 1], GL_QUERY_RESULT, &end);
+                ms[(size_t)frame.passes[pair]] += (end - begin) / 1000000.0f;
+            }
+            std::copy(std::begin(ms), std::end(ms), m_passGpuMs);
+            frame.pending = false;
+        }
+    }
+
+    void Renderer::BeginPassTimings() {
+        m_passFrame = nullptr;
+        if (!m_passTiming) return;
+
+        ReadPassTimings();
+        std::copy(std::begin(m_passGpuMs), std::end(m_passGpuMs), m_stats.passGpuMs);
+
+        // A frame whose timestamps aren't back yet keeps its pool, this one goes untimed on the GPU side
+        PassQueries& frame = m_passQueries[m_passFrameIndex++ % GPU_TIMER_QUERIES];
+        if (frame.pending) return;
+        frame.used = 0;
+        frame.passes.clear();
+        m_passFrame = &frame;
+    }
+
+    void Renderer::BeginPass(RenderPass pass) {
+        if (!m_passTiming) return;
+        m_passStart[(size_t)pass] = std::chrono::steady_clock::now();
+        if (!m_passFrame) return;
+
+        PassQueries& frame = *m_passFrame;
+        if (frame.used * 2 == frame.queries.size()) {
+            frame.queries.resize(frame.queries.size() + 2);
+            glGenQueries(2, &frame.queries[frame.used * 2]);
+        }
+        m_passOpen[(size_t)pass] = frame.used++;
+        frame.passes.push_back(pass);
+        glQueryCounter(frame.queries[m_passOpen[(size_t)pass] * 2], GL_TIMESTAMP);
+    }
+
+    void Renderer::EndPass(RenderPass pass) {
+        if (!m_passTiming) return;
+        m_stats.passCpuMs[(size_t)pass] += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_passStart[(size_t)pass]).count();
+        if (m_passFrame) glQueryCounter(m_passFrame->queries[m_passOpen[(size_t)pass] * 2 + 1], GL_TIMESTAMP);
+    }
+
+    // ========== Dynamic Resolution ==========
+
+    void Renderer::UpdateRenderScale() {
+        // Collect every finished timing, keep the newest one
+        bool sampled = false;
+        f32 sampledScale = m_renderScale;
+        for (u32 i = 0; i < GPU_TIMER_QUERIES; ++i) {
+            u32 query = (m_gpuTimerFrame + i) % GPU_TIMER_QUERIES; // oldest first
+            if (!m_gpuTimerPending[query]) continue;
+
+            GLint available = 0;
+            glGetQueryObjectiv(m_gpuTimerQueries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) continue;
+
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(m_gpuTimerQueries[query], GL_QUERY_RESULT, &elapsed);
+            m_gpuTimerPending[query] = false;
+            m_gpuFrameMs = elapsed / 1000000.0f;
+            sampledScale = m_gpuTimerScale[query];
+            sampled = true;
+        }
+
+        const DynamicResolutionConfig& config = m_dynamicResolution;
+        if (!config.enabled) {
+            m_renderScale = 1.0f;
+            return;
+        }
+        if (!sampled || m_gpuFrameMs <= 0.0f) return;
+
+        // GPU time goes roughly with the pixel count, so the scale that hits the target is sqrt(target / time)
+        // relative to the scale the timing was taken at. Aim a bit under the target, drop fast and climb slowly
+        constexpr f32 headroom = 0.9f;
+        f32 ideal = sampledScale * std::sqrt(config.targetFrameMs * headroom / m_gpuFrameMs);
+        f32 rate = ideal < m_renderScale ? 0.5f : 0.1f;
+        f32 scale = std::clamp(m_renderScale + (ideal - m_renderScale) * rate, config.minScale, config.maxScale);
+
+        // Don't chase noise
+        if (std::abs(scale - m_renderScale) >= 0.01f || scale == config.minScale || scale == config.maxScale)
+            m_renderScale = scale;
+    }
+
+    void Renderer::GetRenderSize(u32& width, u32& height) const {
+        width = std::max(1u, (u32)std::lround(m_Framebuffer->GetWidth() * m_renderScale));
+        height = std::max(1u, (u32)std::lround(m_Framebuffer->GetHeight() * m_renderScale));
+    }
+
     // ========== Frustum Culling ==========
 
     void Renderer::ExtractFrustumPlanes() {
@@ -0,0 +1,267 @@
+#include <engine/replay.hpp>
+#include <engine/log.hpp>
+#include <engine/exception.hpp>
+#include <engine/perf_profiler.hpp>
+
+#include <fstream>
+#include <random>
+
+namespace Engine {
+	static constexpr u32 REPLAY_MAGIC = 0x4C505247; // "GRPL"
+	static constexpr u32 REPLAY_VERSION = 1;
+
+	// Whichever replay is configured hands out the seeds
+	static Replay* s_Replay = nullptr;
+
+	static u64 SplitMix64(u64 x) {
+		x += 0x9E3779B97F4A7C15ull;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	u32 RandomSeed() {
+		if (s_Replay) return s_Replay->NextSeed();
+		return std::random_device{}();
+	}
+
+	template<typename T>
+	static void Write(std::ofstream& file, const T& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	static bool Read(std::ifstream& file, T& value) {
+		file.read(reinterpret_cast<char*>(&value), sizeof(T));
+		return (bool)file;
+	}
+
+	Replay::~Replay() {
+		Finish();
+		if (s_Replay == this) s_Replay = nullptr;
+	}
+
+	void Replay::Configure(const ReplayConfig& config) {
+		m_Config = config;
+		m_Frames.clear();
+		m_Rows.clear();
+		m_Columns.clear();
+		m_Frame = 0;
+		m_Time = 0.0;
+		m_SeedCount = 0;
+		m_Finished = false;
+		m_Saved = false;
+
+		switch (m_Config.mode) {
+		case ReplayConfig::Mode::Off:
+			// A fixed seed alone makes the run reproducible as long as the timesteps are too (headless fixed step)
+			if (m_Config.seed != 0) {
+				m_BaseSeed = m_Config.seed;
+				s_Replay = this;
+				Log::info("Seeding with {}", m_BaseSeed);
+			}
+			else if (s_Replay == this) s_Replay = nullptr;
+			break;
+		case ReplayConfig::Mode::Record:
+			m_BaseSeed = m_Config.seed != 0 ? m_Config.seed : ((u64)std::random_device{}() << 32) | std::random_device{}();
+			s_Replay = this;
+			Log::info("Recording replay to {}", m_Config.file.string());
+			break;
+		case ReplayConfig::Mode::Playback:
+			if (!Load())
+				ENGINE_THROW("Failed to load replay " + m_Config.file.string());
+			s_Replay = this;
+			Log::info("Playing back {} ({} frames{})", m_Config.file.string(), m_Frames.size(),
+				m_Config.fixedStepMs > 0.0f ? ", fixed " + std::to_string(m_Config.fixedStepMs) + " ms step" : "");
+			break;
+		}
+	}
+
+	u32 Replay::NextSeed() {
+		return (u32)SplitMix64(m_BaseSeed + m_SeedCount++);
+	}
+
+	void Replay::BeginFrame(InputSystem& input) {
+		if (!IsPlaying()) return;
+
+		input.SetRealInput(false);
+		if (m_Frame >= m_Frames.size()) {
+			m_Finished = true;
+			return;
+		}
+
+		const Frame& frame = m_Frames[m_Frame];
+		m_Time += m_Config.fixedStepMs > 0.0f ? m_Config.fixedStepMs / 1000.0f : frame.deltaTime;
+		for (InputEvent event : frame.events) {
+			event.time += m_Time;
+			input.Inject(event);
+		}
+	}
+
+	f32 Replay::Step(f32 deltaTime, f64& inputTime, std::span<const InputEvent> events) {
+		if (IsRecording()) {
+			Frame& frame = m_Frames.emplace_back();
+			frame.deltaTime = deltaTime;
+			frame.events.assign(events.begin(), events.end());
+			for (InputEvent& event : frame.events)
+				event.time -= inputTime;
+		}
+		else if (IsPlaying() && !m_Finished) {
+			deltaTime = m_Config.fixedStepMs > 0.0f ? m_Config.fixedStepMs / 1000.0f : m_Frames[m_Frame].deltaTime;
+			inputTime = m_Time;
+		}
+		m_DeltaTime = deltaTime;
+		return deltaTime;
+	}
+
+	void Replay::EndFrame(const Renderer* renderer) {
+		if (m_Finished) return;
+
+		if (!m_Config.statsFile.empty()) {
+			StatsRow& row = m_Rows.emplace_back();
+			row.frame = m_Frame;
+			row.deltaMs = m_DeltaTime * 1000.0f;
+
+			auto add = [&](const string& name, f64 value) {
+				if (row.values.emplace(name, value).second && std::find(m_Columns.begin(), m_Columns.end(), name) == m_Columns.end())
+					m_Columns.push_back(name);
+			};
+
+#ifdef _DEBUG
+			for (auto& [name, section] : gProfiler.getSections())
+				add(name, section.last);
+#endif
+			if (renderer && !renderer->GetStats().empty()) {
+				const Renderer::Stats& stats = renderer->GetStats().front();
+				add("drawCalls", (f64)stats.drawCalls);
+				add("instancedDrawCalls", (f64)stats.instancedDrawCalls);
+				add("totalObjects", (f64)stats.totalObjects);
+				add("batchCount", (f64)stats.batchCount);
+				add("culledObjects", (f64)stats.culledObjects);
+				add("drawnObjects", (f64)stats.drawnObjects);
+				add("instanceBytes", (f64)stats.instanceBytes);
+				add("oitObjects", (f64)stats.oitObjects);
+				add("views", (f64)stats.views);
+				add("lightUpdates", (f64)stats.lightUpdates);
+				add("renderScale", stats.renderScale);
+				add("gpuFrameMs", stats.gpuFrameMs);
+				if (renderer->IsPassTimingEnabled()) {
+					for (size_t pass = 0; pass < (size_t)RenderPass::Count; pass++) {
+						const string name = Renderer::GetPassName((RenderPass)pass);
+						add("cpuMs_" + name, stats.passCpuMs[pass]);
+						add("gpuMs_" + name, stats.passGpuMs[pass]);
+					}
+				}
+			}
+		}
+
+		m_Frame++;
+		if (IsPlaying() && m_Frame >= m_Frames.size())
+			m_Finished = true;
+	}
+
+	void Replay::Finish() {
+		if (m_Saved || (m_Config.mode == ReplayConfig::Mode::Off && m_Config.statsFile.empty())) return;
+		m_Saved = true;
+
+		if (IsRecording()) Save();
+		if (!m_Config.statsFile.empty()) SaveStats();
+		if (IsPlaying() && m_RecordedSeeds != m_SeedCount)
+			Log::warn("Playback drew {} seeds, the recording drew {}, the runs diverged", m_SeedCount, m_RecordedSeeds);
+	}
+
+	bool Replay::Load() {
+		std::ifstream file(m_Config.file, std::ios::binary);
+		if (!file) return false;
+
+		u32 magic = 0, version = 0, frameCount = 0;
+		if (!Read(file, magic) || !Read(file, version) || magic != REPLAY_MAGIC || version != REPLAY_VERSION)
+			return false;
+		if (!Read(file, m_BaseSeed) || !Read(file, m_RecordedSeeds) || !Read(file, frameCount))
+			return false;
+
+		m_Frames.resize(frameCount);
+		for (Frame& frame : m_Frames) {
+			u32 eventCount = 0;
+			if (!Read(file, frame.deltaTime) || !Read(file, eventCount))
+				return false;
+
+			frame.events.resize(eventCount);
+			for (InputEvent& event : frame.events) {
+				// Field by field, the file shouldn't depend on struct padding of whichever build wrote it
+				u8 type = 0;
+				if (!Read(file, type) || !Read(file, event.code) || !Read(file, event.action) || !Read(file, event.mods)
+					|| !Read(file, event.x) || !Read(file, event.y) || !Read(file, event.time))
+					return false;
+				event.type = (InputEvent::Type)type;
+			}
+		}
+		return true;
+	}
+
+	void Replay::Save() const {
+		std::ofstream file(m_Config.file, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			Log::warn("Failed to write replay {}", m_Config.file.string());
+			return;
+		}
+
+		Write(file, REPLAY_MAGIC);
+		Write(file, REPLAY_VERSION);
+		Write(file, m_BaseSeed);
+		Write(file, m_SeedCount);
+		Write(file, (u32)m_Frames.size());
+		for (const Frame& frame : m_Frames) {
+			Write(file, frame.deltaTime);
+			Write(file, (u32)frame.events.size());
+			for (const InputEvent& event : frame.events) {
+				Write(file, (u8)event.type);
+				Write(file, event.code);
+				Write(file, event.action);
+				Write(file, event.mods);
+				Write(file, event.x);
+				Write(file, event.y);
+				Write(file, event.time);
+			}
+		}
+		Log::info("Saved replay {} ({} frames, {} seeds)", m_Config.file.string(), m_Frames.size(), m_SeedCount);
+	}
+
+	void Replay::SaveStats() const {
+		std::ofstream file(m_Config.statsFile, std::ios::trunc);
+		if (!file) {
+			Log::warn("Failed to write replay stats {}", m_Config.statsFile.string());
+			return;
+		}
+
+		bool json = m_Config.statsFile.extension() == ".json";
+		if (json) {
+			file << "[\n";
+			for (size_t i = 0; i < m_Rows.size(); i++) {
+				const StatsRow& row = m_Rows[i];
+				file << "  {\"frame\": " << row.frame << ", \"deltaMs\": " << row.deltaMs;
+				for (auto& [name, value] : row.values)
+					file << ", \"" << name << "\": " << value;
+				file << (i + 1 < m_Rows.size() ? "},\n" : "}\n");
+			}
+			file << "]\n";
+		}
+		else {
+			file << "frame,deltaMs";
+			for (const string& column : m_Columns)
+				file << ',' << column;
+			file << '\n';
+			for (const StatsRow& row : m_Rows) {
+				file << row.frame << ',' << row.deltaMs;
+				// Sections show up lazily, earlier frames just leave those cells empty
+				for (const string& column : m_Columns) {
+					file << ',';
+					auto it = row.values.find(column);
+					if (it != row.values.end()) file << it->second;
+				}
+				file << '\n';
+			}
+		}
+		Log::info("Saved replay stats {} ({} frames)", m_Config.statsFile.string(), m_Rows.size());
+	}
+}
@@ -0,0 +1,256 @@
+#include <engine/resource.hpp>
+#include <engine/exception.hpp>
+#include <engine/simd_math.hpp>
+
+#include <cmath>
+#include <array>
+#include <algorithm>
+
+namespace Engine::Resample {
+	// Mitchell-Netravali (B = C = 1/3), soft enough for minification and no visible ringing when magnifying
+	static constexpr f32 FILTER_RADIUS = 2.0f;
+
+	static f32 Mitchell(f32 x) {
+		constexpr f32 B = 1.0f / 3.0f;
+		constexpr f32 C = 1.0f / 3.0f;
+		x = std::fabs(x);
+		if (x < 1.0f)
+			return ((12.0f - 9.0f * B - 6.0f * C) * x * x * x + (-18.0f + 12.0f * B + 6.0f * C) * x * x + (6.0f - 2.0f * B)) / 6.0f;
+		if (x < 2.0f)
+			return ((-B - 6.0f * C) * x * x * x + (6.0f * B + 30.0f * C) * x * x + (-12.0f * B - 48.0f * C) * x + (8.0f * B + 24.0f * C)) / 6.0f;
+		return 0.0f;
+	}
+
+	// Weights for one axis, every output pixel gets the same number of taps (zero padded)
+	// so the inner loops have a fixed trip count
+	struct FilterBank {
+		int taps = 0;
+		vector<int> indices;   // [dst * taps + tap], already clamped to the source
+		vector<f32> weights;   // [dst * taps + tap], normalized per dst
+	};
+
+	static FilterBank BuildBank(int srcSize, int dstSize) {
+		FilterBank bank;
+		f32 scale = (f32)srcSize / dstSize;
+		f32 support = scale > 1.0f ? scale : 1.0f; // widen the kernel when minifying
+		f32 radius = FILTER_RADIUS * support;
+
+		bank.taps = (int)std::ceil(radius * 2.0f) + 1;
+		bank.indices.assign((size_t)dstSize * bank.taps, 0);
+		bank.weights.assign((size_t)dstSize * bank.taps, 0.0f);
+
+		for (int i = 0; i < dstSize; ++i) {
+			f32 center = (i + 0.5f) * scale;
+			int first = (int)std::floor(center - radius);
+			int* indices = &bank.indices[(size_t)i * bank.taps];
+			f32* weights = &bank.weights[(size_t)i * bank.taps];
+
+			f32 total = 0.0f;
+			for (int t = 0; t < bank.taps; ++t) {
+				int j = first + t;
+				f32 w = Mitchell((j + 0.5f - center) / support);
+				indices[t] = std::clamp(j, 0, srcSize - 1);
+				weights[t] = w;
+				total += w;
+			}
+
+			if (total != 0.0f) {
+				for (int t = 0; t < bank.taps; ++t)
+					weights[t] /= total;
+			}
+			else {
+				// Can't happen with this kernel, but don't output black if it does
+				weights[0] = 1.0f;
+				indices[0] = std::clamp((int)center, 0, srcSize - 1);
+			}
+		}
+		return bank;
+	}
+
+	// sRGB <-> linear, decode is exact per byte, encode goes through a table fine enough
+	// that every 8 bit value is reachable (the darkest step is ~1/3300 in linear)
+	static constexpr int ENCODE_LUT_SIZE = 16384;
+
+	static const std::array<f32, 256>& DecodeLUT() {
+		static const std::array<f32, 256> lut = []() {
+			std::array<f32, 256> table{};
+			for (int i = 0; i < 256; ++i) {
+				f32 c = i / 255.0f;
+				table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return table;
+		}();
+		return lut;
+	}
+
+	static const vector<u8>& EncodeLUT() {
+		static const vector<u8> lut = []() {
+			vector<u8> table(ENCODE_LUT_SIZE);
+			for (int i = 0; i < ENCODE_LUT_SIZE; ++i) {
+				f32 l = (f32)i / (ENCODE_LUT_SIZE - 1);
+				f32 c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				table[i] = (u8)std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f);
+			}
+			return table;
+		}();
+		return lut;
+	}
+
+	static int AlphaChannel(int channels) {
+		return channels == 4 ? 3 : channels == 2 ? 1 : -1;
+	}
+
+	// 8 bit -> linear float, color premultiplied by alpha so transparent texels don't bleed their color
+	static void ToLinear(const u8* src, int width, int height, int channels, bool srgb, f32* dst) {
+		const std::array<f32, 256>& decode = DecodeLUT();
+		int alpha = AlphaChannel(channels);
+
+		#pragma omp parallel for schedule(static)
+		for (int y = 0; y < height; ++y) {
+			const u8* in = src + (size_t)y * width * channels;
+			f32* out = dst + (size_t)y * width * channels;
+			for (int x = 0; x < width; ++x, in += channels, out += channels) {
+				f32 a = alpha >= 0 ? in[alpha] / 255.0f : 1.0f;
+				for (int c = 0; c < channels; ++c) {
+					if (c == alpha) out[c] = a;
+					else out[c] = (srgb ? decode[in[c]] : in[c] / 255.0f) * a;
+				}
+			}
+		}
+	}
+
+	static void FromLinear(const f32* src, int width, int height, int channels, bool srgb, u8* dst) {
+		const vector<u8>& encode = EncodeLUT();
+		int alpha = AlphaChannel(channels);
+
+		#pragma omp parallel for schedule(static)
+		for (int y = 0; y < height; ++y) {
+			const f32* in = src + (size_t)y * width * channels;
+			u8* out = dst + (size_t)y * width * channels;
+			for (int x = 0; x < width; ++x, in += channels, out += channels) {
+				f32 a = alpha >= 0 ? std::clamp(in[alpha], 0.0f, 1.0f) : 1.0f;
+				f32 inv = a > 0.0f ? 1.0f / a : 0.0f;
+				for (int c = 0; c < channels; ++c) {
+					if (c == alpha) {
+						out[c] = (u8)(a * 255.0f + 0.5f);
+						continue;
+					}
+					f32 v = std::clamp(in[c] * inv, 0.0f, 1.0f);
+					out[c] = srgb ? encode[(size_t)(v * (ENCODE_LUT_SIZE - 1) + 0.5f)] : (u8)(v * 255.0f + 0.5f);
+				}
+			}
+		}
+	}
+
+	// One axis of the filter: every output row is a weighted sum of whole source rows of rowSize floats,
+	// which is a plain multiply-add the SIMD kernels run at full width
+	static void FilterRows(const f32* src, size_t rowSize, const FilterBank& bank, int dstRows, f32* dst) {
+		#pragma omp parallel for schedule(static)
+		for (int y = 0; y < dstRows; ++y) {
+			const int* indices = &bank.indices[(size_t)y * bank.taps];
+			const f32* weights = &bank.weights[(size_t)y * bank.taps];
+			f32* out = dst + (size_t)y * rowSize;
+
+			std::fill(out, out + rowSize, 0.0f);
+			for (int t = 0; t < bank.taps; ++t) {
+				if (weights[t] == 0.0f) continue;
+				SIMD::ScaleAdd(src + (size_t)indices[t] * rowSize, weights[t], out, rowSize);
+			}
+		}
+	}
+
+	// width x height pixels of C floats to height x width, in tiles so both sides stay in cache
+	template<int C>
+	static void Transpose(const f32* src, int width, int height, f32* dst) {
+		constexpr int TILE = 32;
+		#pragma omp parallel for schedule(static)
+		for (int ty = 0; ty < height; ty += TILE) {
+			for (int tx = 0; tx < width; tx += TILE) {
+				const int yEnd = std::min(ty + TILE, height), xEnd = std::min(tx + TILE, width);
+				for (int y = ty; y < yEnd; ++y)
+					for (int x = tx; x < xEnd; ++x)
+						for (int c = 0; c < C; ++c)
+							dst[((size_t)x * height + y) * C + c] = src[((size_t)y * width + x) * C + c];
+			}
+		}
+	}
+
+	// Vertical pass, then the horizontal one as another vertical pass over the transposed image.
+	// Taps along a row would need gathers, whole rows don't
+	template<int C>
+	static void ResampleLinear(const f32* src, int srcWidth, int srcHeight, f32* dst, int dstWidth, int dstHeight) {
+		FilterBank vertical = BuildBank(srcHeight, dstHeight);
+		FilterBank horizontal = BuildBank(srcWidth, dstWidth);
+		vector<f32> rows((size_t)srcWidth * dstHeight * C);
+		vector<f32> columns(rows.size());
+		vector<f32> filtered((size_t)dstWidth * dstHeight * C);
+
+		FilterRows(src, (size_t)srcWidth * C, vertical, dstHeight, rows.data());             // srcWidth x dstHeight
+		Transpose<C>(rows.data(), srcWidth, dstHeight, columns.data());                      // dstHeight x srcWidth
+		FilterRows(columns.data(), (size_t)dstHeight * C, horizontal, dstWidth, filtered.data()); // dstHeight x dstWidth
+		Transpose<C>(filtered.data(), dstHeight, dstWidth, dst);
+	}
+
+	static void ResampleLinear(const f32* src, int srcWidth, int srcHeight, f32* dst, int dstWidth, int dstHeight, int channels) {
+		switch (channels) {
+			case 1: ResampleLinear<1>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight); break;
+			case 2: ResampleLinear<2>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight); break;
+			case 3: ResampleLinear<3>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight); break;
+			case 4: ResampleLinear<4>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight); break;
+			default: ENGINE_THROW("Cannot resample image with " + std::to_string(channels) + " channels");
+		}
+	}
+
+	void Resize(const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst, int dstWidth, int dstHeight, int channels, bool srgb) {
+		if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0)
+			ENGINE_THROW("Cannot resample image of size " + std::to_string(srcWidth) + "x" + std::to_string(srcHeight) + " to " + std::to_string(dstWidth) + "x" + std::to_string(dstHeight));
+
+		vector<f32> linear((size_t)srcWidth * srcHeight * channels);
+		vector<f32> resized((size_t)dstWidth * dstHeight * channels);
+		ToLinear(src, srcWidth, srcHeight, channels, srgb, linear.data());
+		ResampleLinear(linear.data(), srcWidth, srcHeight, resized.data(), dstWidth, dstHeight, channels);
+		FromLinear(resized.data(), dstWidth, dstHeight, channels, srgb, dst);
+	}
+
+	u32 MipCount(int width, int height) {
+		u32 levels = 1;
+		int size = std::max(width, height);
+		while (size > 1) {
+			size >>= 1;
+			levels++;
+		}
+		return levels;
+	}
+}
+
+namespace Engine {
+	void Image::GenerateMips(bool srgb) {
+		mips.clear();
+		if (!data || width <= 0 || height <= 0) return;
+
+		u32 levels = Resample::MipCount(width, height);
+		if (levels <= 1) return;
+		mips.resize(levels - 1);
+
+		// Every level is filtered from the previous one in linear float, the 8 bit copies are only for upload
+		// so quantization doesn't accumulate down the chain
+		int w = width, h = height;
+		vector<f32> current((size_t)w * h * channels);
+		vector<f32> next;
+		Resample::ToLinear(data, w, h, channels, srgb, current.data());
+
+		for (u32 level = 1; level < levels; ++level) {
+			int nw = std::max(1, w >> 1);
+			int nh = std::max(1, h >> 1);
+			next.resize((size_t)nw * nh * channels);
+			Resample::ResampleLinear(current.data(), w, h, next.data(), nw, nh, channels);
+
+			mips[level - 1].resize((size_t)nw * nh * channels);
+			Resample::FromLinear(next.data(), nw, nh, channels, srgb, mips[level - 1].data());
+
+			current.swap(next);
+			w = nw;
+			h = nh;
+		}
+	}
+}
@@ -4,9 +4,7 @@
 
 // Image handling
 #define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_RESIZE2_IMPLEMENTATION
 #include <stb_image.h>
-#include <stb_image_resize2.h>
 
 // 3D model handling
 #include <assimp/Importer.hpp>
@@ -18,6 +16,8 @@
 
 #include <fstream>
 #include <functional>
+#include <cstring>
+#include <cfloat>
 
 // Helper to compile a single shader stage
 static unsigned int compileShader(GLenum type, const std::string& source, const std::string& name) {
@@ -53,24 +53,6 @@ static std::string readFile(const std::filesystem::path& path) {
     return buffer.str();
 }
 
-// Helper to resize image data
-static unsigned char* resizeImage(unsigned char* original, int orig_w, int orig_h, int channels,
-    int new_w, int new_h) {
-    unsigned char* resized = (unsigned char*)malloc((size_t)new_w * new_h * channels);
-    if (!resized) return nullptr;
-
-    // v2: cast channels to stbir_pixel_layout and call the linear helper
-    if (!stbir_resize_uint8_linear(
-        original, orig_w, orig_h, 0,
-        resized, new_w, new_h, 0,
-        (stbir_pixel_layout)channels)) {
-        free(resized);
-        return nullptr;
-    }
-
-    return resized;
-}
-
 // Calculate dimensions maintaining aspect ratio
 static std::pair<int, int> calculateResizeDimensions(int orig_w, int orig_h,
     int target_w, int target_h,
@@ -132,6 +114,26 @@ GLenum getGLFormat(int channels) {
 }
 
 namespace Engine {
+    size_t ResourceSystem::evict_unused(const std::string& prefix) {
+        size_t evicted = 0;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto it = m_cache.begin(); it != m_cache.end();) {
+                // Key format is "typename|path:sub"
+                size_t sep = it->first.find('|');
+                bool matches = sep != std::string::npos && it->first.compare(sep + 1, prefix.size(), prefix) == 0;
+                if (matches && it->second.use_count() == 1) {
+                    it = m_cache.erase(it);
+                    ++evicted;
+                    changed = true;
+                }
+                else ++it;
+            }
+        }
+        return evicted;
+    }
+
     ENGINE_API std::string ReadFile(const std::filesystem::path& filepath) {
         std::ifstream file(filepath);
         if (!file.is_open()) {
@@ -143,6 +145,17 @@ namespace Engine {
         return buffer.str();
     }
 
+    // Read from the decode threads too, only ever changed before the first load
+    static bool s_GpuUpload = true;
+
+    void ResourceLoader::setGpuUpload(bool enabled) {
+        s_GpuUpload = enabled;
+    }
+
+    bool ResourceLoader::isGpuUploadEnabled() {
+        return s_GpuUpload;
+    }
+
     namespace DefaultAssets {
         std::shared_ptr<Texture> GetDefaultColorTexture() {
             return Application::Get().GetResourceSystem()->load<Texture>(Application::Get().GetVFS()->GetEngineResourcePath("assets/textures/white1x1.png"));
@@ -184,8 +197,8 @@ namespace Engine {
     std::shared_ptr<Image> ResourceLoader::load(const std::filesystem::path& path, const LoadCfg::Image& cfg) {
         auto img = std::make_shared<Image>();
 
-        // Set flip flag before loading
-        stbi_set_flip_vertically_on_load(cfg.flip_vertically);
+        // Set flip flag before loading, per thread since models decode off the main thread
+        stbi_set_flip_vertically_on_load_thread(cfg.flip_vertically);
 
         // Load image with desired format
         int desired_channels = static_cast<int>(cfg.format);
@@ -213,13 +226,13 @@ namespace Engine {
             );
 
             if (new_w != img->width || new_h != img->height) {
-                unsigned char* resized = resizeImage(img->data, img->width, img->height,
-                    img->channels, new_w, new_h);
+                unsigned char* resized = new_w > 0 && new_h > 0 ? (unsigned char*)malloc((size_t)new_w * new_h * img->channels) : nullptr;
                 if (!resized) {
-                    stbi_image_free(img->data);
                     ENGINE_THROW("Failed to resize image from " + path.string());
                 }
 
+                Resample::Resize(img->data, img->width, img->height, resized, new_w, new_h, img->channels, cfg.srgb);
+
                 stbi_image_free(img->data);
                 img->data = resized;
                 img->width = new_w;
@@ -227,6 +240,9 @@ namespace Engine {
             }
         }
 
+        if (cfg.generate_mipmaps)
+            img->GenerateMips(cfg.srgb);
+
         return img;
     }
 
@@ -234,6 +250,8 @@ namespace Engine {
         id = other.id;
         width = other.width;
         height = other.height;
+        levels = other.levels;
+        baseLevel = other.baseLevel;
         other.id = 0;
     }
 
@@ -243,6 +261,8 @@ namespace Engine {
             id = other.id;
             width = other.width;
             height = other.height;
+            levels = other.levels;
+            baseLevel = other.baseLevel;
             other.id = 0;
         }
         return *this;
@@ -252,10 +272,48 @@ namespace Engine {
         if (data) stbi_image_free(data);
     }
 
+    static GLenum toSizedFormat(GLenum format) {
+        switch (format) {
+            case GL_RGB: return GL_RGB8;
+            case GL_RGBA: return GL_RGBA8;
+            case GL_SRGB: return GL_SRGB8;
+            case GL_SRGB_ALPHA: return GL_SRGB8_ALPHA8;
+            default: return format;
+        }
+    }
+
+    // Immutable storage for the whole chain, levels the image already carries get uploaded as is,
+    // otherwise GL fills the chain from level 0
+    static u32 uploadImage(const Image& img, GLenum imgFormat, GLenum texFormat, bool mipmaps) {
+        GLsizei levels = mipmaps ? (GLsizei)Resample::MipCount(img.width, img.height) : 1;
+        glTexStorage2D(GL_TEXTURE_2D, levels, toSizedFormat(texFormat), img.width, img.height);
+
+        // Small mips of RGB images have rows that aren't 4 byte aligned
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, img.width, img.height, imgFormat, GL_UNSIGNED_BYTE, img.data);
+        if (levels > 1 && img.mips.size() == (size_t)levels - 1) {
+            for (GLsizei level = 1; level < levels; ++level) {
+                int w = std::max(1, img.width >> level);
+                int h = std::max(1, img.height >> level);
+                glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, imgFormat, GL_UNSIGNED_BYTE, img.mips[level - 1].data());
+            }
+        }
+        else if (levels > 1) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        return (u32)levels;
+    }
+
     Texture::Texture(const Image& img) {
         width = img.width;
         height = img.height;
         m_path = img.m_path;
+        if (!s_GpuUpload) return;
 
         glGenTextures(1, &id);
         glBindTexture(GL_TEXTURE_2D, id);
@@ -267,8 +325,7 @@ namespace Engine {
 
         GLenum imgFormat = img.channels == 3 ? GL_RGB : GL_RGBA;
         GLenum texFormat = imgFormat == GL_RGB ? GL_SRGB : GL_SRGB_ALPHA;
-        glTexImage2D(GL_TEXTURE_2D, 0, texFormat, img.width, img.height, 0, imgFormat, GL_UNSIGNED_BYTE, img.data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        levels = uploadImage(img, imgFormat, texFormat, true);
 
         glBindTexture(GL_TEXTURE_2D, 0);
     }
@@ -291,6 +348,7 @@ namespace Engine {
         // Read shader source files
         std::string vertCode = readFile(vertPath);
         std::string fragCode = readFile(fragPath);
+        if (!s_GpuUpload) return shader;
 
         // Compile shader stages
         unsigned int vertShader = compileShader(GL_VERTEX_SHADER, vertCode, path.filename().string());
@@ -339,6 +397,19 @@ namespace Engine {
         img_cfg.width = cfg.width;
         img_cfg.height = cfg.height;
         img_cfg.maintain_aspect = cfg.maintain_aspect;
+        img_cfg.srgb = cfg.texFormat != LoadCfg::TextureFormat::RGB && cfg.texFormat != LoadCfg::TextureFormat::RGBA;
+        img_cfg.generate_mipmaps = cfg.generate_mipmaps;
+
+        // Only the size is of any use without a GPU, the header has it
+        if (!s_GpuUpload) {
+            auto tex = std::make_shared<Texture>();
+            int channels = 0;
+            if (!stbi_info(path.string().c_str(), &tex->width, &tex->height, &channels))
+                ENGINE_THROW("Failed to load image for texture: " + path.string() + ": " + std::string(stbi_failure_reason()));
+            if (cfg.width > 0 || cfg.height > 0)
+                std::tie(tex->width, tex->height) = calculateResizeDimensions(tex->width, tex->height, cfg.width, cfg.height, cfg.maintain_aspect);
+            return tex;
+        }
 
         auto image = ResourceLoader::load(path, img_cfg);
         if (!image || !image->data) {
@@ -362,13 +433,8 @@ namespace Engine {
             else if (cfg.texFormat == LoadCfg::TextureFormat::SRGB_ALPHA) texFormat = GL_SRGB_ALPHA;
         }
 
-        // Upload texture data
-        GLenum format = getGLFormat(image->channels);
-        glTexImage2D(
-            GL_TEXTURE_2D, 0, texFormat,
-            tex->width, tex->height, 0,
-            imgFormat, GL_UNSIGNED_BYTE, image->data
-        );
+        // Upload texture data, the mip chain was built by the image loader
+        tex->levels = uploadImage(*image, imgFormat, texFormat, cfg.generate_mipmaps);
 
         // Set texture parameters
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, toGLFilter(cfg.min_filter));
@@ -376,11 +442,6 @@ namespace Engine {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, toGLWrap(cfg.wrap_s));
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, toGLWrap(cfg.wrap_t));
 
-        // Generate mipmaps if requested
-        if (cfg.generate_mipmaps) {
-            glGenerateMipmap(GL_TEXTURE_2D);
-        }
-
         glBindTexture(GL_TEXTURE_2D, 0);
 
         return tex;
@@ -399,15 +460,93 @@ namespace Engine {
         t.rotation = glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
         t.scale = { scaling.x, scaling.y, scaling.z };
 
-        // Compose model matrix (GLM column-major)
-        t.modelMatrix = glm::translate(glm::mat4(1.0f), t.position)
-            * glm::mat4_cast(t.rotation)
-            * glm::scale(glm::mat4(1.0f), t.scale);
-
         return t;
     }
 
-    std::shared_ptr<Model> ResourceLoader::load(const std::filesystem::path& path, const LoadCfg::Model& cfg) {
+    BBox ModelData::CombineBounds(const std::vector<MeshData>& meshes) {
+        glm::vec3 minBounds(FLT_MAX);
+        glm::vec3 maxBounds(-FLT_MAX);
+        for (const MeshData& m : meshes) {
+            if (m.vertices.empty()) continue;
+            minBounds = glm::min(minBounds, m.bounds.min);
+            maxBounds = glm::max(maxBounds, m.bounds.max);
+        }
+        return BBox{ minBounds, maxBounds };
+    }
+
+    size_t ModelData::GetByteSize() const {
+        size_t bytes = 0;
+        for (const MeshData& m : meshes)
+            bytes += m.vertices.size() * sizeof(Vertex) + m.indices.size() * sizeof(u32);
+
+        // Images can be shared between materials
+        unordered_set<const Image*> seen;
+        for (const MaterialData& mat : materials)
+            for (const TextureData& tex : mat.textures)
+                if (tex.image && seen.insert(tex.image.get()).second) {
+                    bytes += (size_t)tex.image->width * tex.image->height * tex.image->channels;
+                    for (const auto& mip : tex.image->mips)
+                        bytes += mip.size();
+                }
+        return bytes;
+    }
+
+    // Builds the mip chains while we're still off the main thread, upload then just copies levels
+    // Big enough textures also get cooked to disk so the streamer can bring their fine levels back later
+    static void generateMips(ModelData& model, const LoadCfg::TextureCooking& cooking) {
+        // Nothing samples them in headless runs
+        if (!s_GpuUpload) return;
+
+        unordered_map<Image*, std::string> keys;
+        std::vector<Image*> images;
+        for (size_t m = 0; m < model.materials.size(); ++m) {
+            for (size_t slot = 0; slot < model.materials[m].textures.size(); ++slot) {
+                ModelData::TextureData& tex = model.materials[m].textures[slot];
+                if (!tex.image || !tex.image->mips.empty() || keys.count(tex.image.get())) continue;
+                keys[tex.image.get()] = !tex.cacheKey.empty() ? tex.cacheKey : model.path.string() + ":mat:" + std::to_string(m) + ":" + std::to_string(slot);
+                images.push_back(tex.image.get());
+            }
+        }
+
+        std::vector<optional<path>> cooked(images.size());
+
+        // Textures are bound as sRGB, see Texture::Texture(const Image&)
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < (int)images.size(); ++i) {
+            images[i]->GenerateMips(true);
+            if (cooking.enabled && (u32)std::max(images[i]->width, images[i]->height) > cooking.tailSize)
+                cooked[i] = TextureStreamer::Cook(*images[i], keys.at(images[i]), cooking.cacheDir, model.path);
+        }
+
+        unordered_map<Image*, optional<path>> cookedByImage;
+        for (size_t i = 0; i < images.size(); ++i)
+            cookedByImage[images[i]] = cooked[i];
+        for (ModelData::MaterialData& mat : model.materials)
+            for (ModelData::TextureData& tex : mat.textures)
+                if (tex.image && cookedByImage.count(tex.image.get()))
+                    tex.cooked = cookedByImage[tex.image.get()];
+    }
+
+    LoadCfg::TextureCooking ResourceLoader::textureCooking() {
+        std::shared_ptr<Renderer> renderer = Application::Get().GetRenderer();
+        if (!renderer) return {};
+
+        const TextureStreamingConfig& streaming = renderer->GetTextureStreamer().GetConfig();
+        return LoadCfg::TextureCooking{ .enabled = streaming.enabled, .tailSize = streaming.tailSize, .cacheDir = streaming.cacheDir };
+    }
+
+    std::shared_ptr<ModelData> ResourceLoader::decode(const std::filesystem::path& path, const LoadCfg::Model& cfg, const LoadCfg::TextureCooking& cooking) {
+        // glTF goes through our own loader, it's way faster than the assimp post processing chain
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        if (ext == ".glb" || ext == ".gltf") {
+            if (std::shared_ptr<ModelData> model = decodeGLTF(path, cfg)) {
+                model->cfg = cfg;
+                generateMips(*model, cooking);
+                return model;
+            }
+        }
+
         Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(
             path.string(),
@@ -426,11 +565,9 @@ namespace Engine {
             return nullptr;
         }
 
-        std::shared_ptr<Model> model = std::make_shared<Model>();
-
-        Application& app = Application::Get();
-        Ref<VFS> vfs = app.GetVFS();
-        Ref<ResourceSystem> rs = app.GetResourceSystem();
+        std::shared_ptr<ModelData> model = std::make_shared<ModelData>();
+        model->path = path;
+        model->cfg = cfg;
 
         // ========== FIRST PASS: Find which materials are actually used ==========
         std::unordered_set<unsigned int> usedMaterialIndices;
@@ -448,57 +585,80 @@ namespace Engine {
 
         scanNode(scene->mRootNode);
 
-        // ========== Calculate bounds across all meshes ==========
-        glm::vec3 minBounds(FLT_MAX);
-        glm::vec3 maxBounds(-FLT_MAX);
-
-        for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
-            aiMesh* m = scene->mMeshes[i];
-            for (unsigned int v = 0; v < m->mNumVertices; ++v) {
-                glm::vec3 pos = { m->mVertices[v].x, m->mVertices[v].y, m->mVertices[v].z };
+        // ========== Convert all meshes (we need all since nodes reference them) ==========
+        // Meshes are independent, so one per thread; arrays are sized up front and bounds come out of the same pass
+        model->meshes.resize(scene->mNumMeshes);
+
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < (int)scene->mNumMeshes; ++i) {
+            const aiMesh* m = scene->mMeshes[i];
+            ModelData::MeshData& mesh = model->meshes[i];
+
+            const size_t vertexCount = m->mNumVertices;
+            mesh.vertices.resize(vertexCount);
+            Vertex* vertices = mesh.vertices.data();
+
+            const aiVector3D* positions = m->mVertices;
+            const aiVector3D* normals = m->mNormals;
+            const aiVector3D* uvs = m->mTextureCoords[0];
+            const aiVector3D* tangents = m->mTangents;
+
+            glm::vec3 minBounds(FLT_MAX);
+            glm::vec3 maxBounds(-FLT_MAX);
+            for (size_t v = 0; v < vertexCount; ++v) {
+                const glm::vec3 pos = { positions[v].x, positions[v].y, positions[v].z };
+                vertices[v].position = pos;
                 minBounds = glm::min(minBounds, pos);
                 maxBounds = glm::max(maxBounds, pos);
             }
-        }
-        model->bounds.min = minBounds;
-        model->bounds.max = maxBounds;
-
-        // ========== Load all meshes (we need all since nodes reference them) ==========
-        model->meshes.reserve(scene->mNumMeshes);
-        for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
-            aiMesh* m = scene->mMeshes[i];
-            std::vector<Vertex> vertices;
-            std::vector<u32> indices;
-
-            vertices.reserve(m->mNumVertices);
-            for (unsigned int v = 0; v < m->mNumVertices; ++v) {
-                Vertex vert{};
-                vert.position = { m->mVertices[v].x, m->mVertices[v].y, m->mVertices[v].z };
-                vert.normal = { m->mNormals[v].x, m->mNormals[v].y, m->mNormals[v].z };
-                vert.uv = m->mTextureCoords[0]
-                    ? glm::vec2(m->mTextureCoords[0][v].x, m->mTextureCoords[0][v].y)
-                    : glm::vec2(0.0f);
-                vert.tangent = m->mTangents
-                    ? glm::vec3(m->mTangents[v].x, m->mTangents[v].y, m->mTangents[v].z)
-                    : glm::vec3(0.0f);
-                vertices.push_back(vert);
+
+            // Separate loops per attribute, the branches stay out of the hot loops
+            if (normals) {
+                for (size_t v = 0; v < vertexCount; ++v)
+                    vertices[v].normal = { normals[v].x, normals[v].y, normals[v].z };
+            }
+            if (uvs) {
+                for (size_t v = 0; v < vertexCount; ++v)
+                    vertices[v].uv = { uvs[v].x, uvs[v].y };
+            }
+            if (tangents) {
+                for (size_t v = 0; v < vertexCount; ++v)
+                    vertices[v].tangent = { tangents[v].x, tangents[v].y, tangents[v].z };
             }
 
-            for (unsigned int f = 0; f < m->mNumFaces; ++f)
-                for (unsigned int j = 0; j < m->mFaces[f].mNumIndices; ++j)
-                    indices.push_back(m->mFaces[f].mIndices[j]);
+            mesh.bounds = vertexCount > 0 ? BBox{ minBounds, maxBounds } : BBox{};
 
-            vertices.shrink_to_fit();
-            indices.shrink_to_fit();
-            model->meshes.emplace_back(vertices, indices);
+            // Triangulated, but lines and points can still sneak through so count first
+            size_t indexCount = 0;
+            for (unsigned int f = 0; f < m->mNumFaces; ++f)
+                indexCount += m->mFaces[f].mNumIndices;
+
+            mesh.indices.resize(indexCount);
+            u32* indices = mesh.indices.data();
+            for (unsigned int f = 0; f < m->mNumFaces; ++f) {
+                const aiFace& face = m->mFaces[f];
+                if (face.mNumIndices == 3) {
+                    indices[0] = face.mIndices[0];
+                    indices[1] = face.mIndices[1];
+                    indices[2] = face.mIndices[2];
+                }
+                else {
+                    for (unsigned int j = 0; j < face.mNumIndices; ++j)
+                        indices[j] = face.mIndices[j];
+                }
+                indices += face.mNumIndices;
+            }
         }
 
-        // ========== SECOND PASS: Load only used materials ==========
+        // ========== Model bounds from the per mesh ones ==========
+        model->bounds = ModelData::CombineBounds(model->meshes);
+
+        // ========== SECOND PASS: Decode only used materials ==========
         // Create mapping: old material index -> new material index
         std::unordered_map<unsigned int, unsigned int> materialIndexRemap;
 
-        // Helper: load texture from material (handles embedded + external)
-        auto loadTexture = [path, scene, rs](aiMaterial* mat, aiTextureType type, unsigned int matIndex) -> optional<std::shared_ptr<Texture>> {
+        // Helper: decode texture from material (handles embedded + external)
+        auto decodeTexture = [path, scene](aiMaterial* mat, aiTextureType type, unsigned int matIndex) -> ModelData::TextureData {
             if (mat->GetTextureCount(type) > 0) {
                 aiString str;
                 mat->GetTexture(type, 0, &str);
@@ -509,58 +669,55 @@ namespace Engine {
                     aiTexture* tex = scene->mTextures[texIndex];
                     if (!tex) return {};
 
-                    Image img{};
-                    img.width = tex->mWidth;
-                    img.height = tex->mHeight;
-                    img.channels = 4;
-                    img.m_path = path;
+                    std::shared_ptr<Image> img = std::make_shared<Image>();
+                    img->width = tex->mWidth;
+                    img->height = tex->mHeight;
+                    img->channels = 4;
+                    img->m_path = path;
 
                     // If compressed (e.g. jpg/png in memory)
                     if (tex->mHeight == 0) {
                         auto bytes = reinterpret_cast<unsigned char*>(tex->pcData);
                         int w, h, c;
                         unsigned char* data = stbi_load_from_memory(bytes, tex->mWidth, &w, &h, &c, 4);
-                        img.width = w;
-                        img.height = h;
-                        img.channels = 4;
-                        img.data = data;
+                        img->width = w;
+                        img->height = h;
+                        img->channels = 4;
+                        img->data = data;
                     }
                     else {
-                        // Raw uncompressed BGRA8888
-                        img.data = reinterpret_cast<unsigned char*>(tex->pcData);
+                        // Raw uncompressed BGRA8888, the importer owns pcData so take a copy
+                        size_t size = (size_t)tex->mWidth * tex->mHeight * 4;
+                        img->data = (unsigned char*)malloc(size);
+                        if (img->data) memcpy(img->data, tex->pcData, size);
                     }
 
-                    std::shared_ptr<Texture> texture = std::make_shared<Texture>(img);
-                    rs->cache<Texture>(path.string() + ":tex:" + std::to_string(matIndex) + ":" + std::to_string(type), texture);
-                    return texture;
+                    if (!img->data) return {};
+                    return { img, path.string() + ":tex:" + std::to_string(matIndex) + ":" + std::to_string(type) };
                 }
 
                 // External texture path
                 auto texPath = path.parent_path() / str.C_Str();
-                Ref<Image> img = ResourceLoader::load(texPath, LoadCfg::Image());
-                return std::make_shared<Texture>(*img);
+                return { ResourceLoader::load(texPath, LoadCfg::Image()), "" };
             }
 
             return {};
         };
 
-        model->materials.reserve(usedMaterialIndices.size());
+        // Sorted so material order doesn't depend on hashing
+        std::vector<unsigned int> sortedMaterialIndices(usedMaterialIndices.begin(), usedMaterialIndices.end());
+        std::sort(sortedMaterialIndices.begin(), sortedMaterialIndices.end());
+        model->materials.reserve(sortedMaterialIndices.size());
 
-        for (unsigned int oldIdx : usedMaterialIndices) {
+        for (unsigned int oldIdx : sortedMaterialIndices) {
             aiMaterial* mat = scene->mMaterials[oldIdx];
-            Material material;
+            ModelData::MaterialData material;
 
-            // Load textures
-            auto diffuseTex = loadTexture(mat, aiTextureType_DIFFUSE, oldIdx);
-            auto specularTex = loadTexture(mat, aiTextureType_SPECULAR, oldIdx);
-            auto normalTex = loadTexture(mat, aiTextureType_NORMALS, oldIdx);
-            auto emmisiveTex = loadTexture(mat, aiTextureType_EMISSIVE, oldIdx);
-
-            // Set textures or defaults
-            material.diffuse = diffuseTex.value_or(DefaultAssets::GetDefaultColorTexture());
-            material.specular = specularTex.value_or(DefaultAssets::GetDefaultColorTexture());
-            material.normal = normalTex.value_or(DefaultAssets::GetDefaultNormalTexture());
-            material.emmisive = normalTex.value_or(DefaultAssets::GetDefaultEmmisiveTexture());
+            // Decode textures
+            material.textures[(int)Shader::TextureSlot::DIFFUSE] = decodeTexture(mat, aiTextureType_DIFFUSE, oldIdx);
+            material.textures[(int)Shader::TextureSlot::SPECULAR] = decodeTexture(mat, aiTextureType_SPECULAR, oldIdx);
+            material.textures[(int)Shader::TextureSlot::NORMAL] = decodeTexture(mat, aiTextureType_NORMALS, oldIdx);
+            material.textures[(int)Shader::TextureSlot::EMMISIVE] = decodeTexture(mat, aiTextureType_EMISSIVE, oldIdx);
 
             // Load material colors
             aiColor3D color;
@@ -576,25 +733,21 @@ namespace Engine {
                 shininess = SHININESS_DEFAULT;
             material.shininess = shininess;
 
-            bool isEmmisive = false;
             constexpr float EMMISIVE_INTENSITY_DEFAULT = 0.0f;
             float emmisiveIntensity = EMMISIVE_INTENSITY_DEFAULT;
             if (AI_SUCCESS == mat->Get(AI_MATKEY_EMISSIVE_INTENSITY, emmisiveIntensity)) {
-                isEmmisive = true;
+                material.isEmmisive = true;
             }
             material.emmisiveIntensity = emmisiveIntensity;
 
-
             aiColor3D emmisiveColor{ 0.0f, 0.0f, 0.0f };
             if (AI_SUCCESS == mat->Get(AI_MATKEY_COLOR_EMISSIVE, emmisiveColor)) {
                 if (emmisiveColor.r != 0 || emmisiveColor.g != 0 || emmisiveColor.g != 0)
-                    isEmmisive = true;
+                    material.isEmmisive = true;
             }
             material.emmisiveColor = vec3(emmisiveColor.r, emmisiveColor.g, emmisiveColor.b);
 
             // ========== Determine transparency ==========
-            material.isTransparent = false;
-
             // Check opacity from material
             float opacity = 1.0f;
             if (AI_SUCCESS == mat->Get(AI_MATKEY_OPACITY, opacity)) {
@@ -604,17 +757,103 @@ namespace Engine {
                 }
             }
 
-            // Check if diffuse texture has alpha channel
-            if (diffuseTex.has_value() && !material.isTransparent) {
-                // We can't easily check texture format after upload, but we can check the original image
-                // For now, we'll trust the opacity value or add a check during texture loading
-                // TODO: Could store channel count in Texture struct if needed
+            material.cacheKey = path.string() + ":mat:" + std::to_string(oldIdx);
+
+            // Store the new index for this material
+            unsigned int newIdx = static_cast<unsigned int>(model->materials.size());
+            materialIndexRemap[oldIdx] = newIdx;
+            model->materials.push_back(std::move(material));
+        }
+
+        // ========== Build hierarchy with remapped indices ==========
+        std::function<int(aiNode*, int)> processNode = [&](aiNode* node, entity_id parentBlueprintIdx) -> int {
+            ModelData::NodeData nodeData;
+            nodeData.name = std::string(node->mName.C_Str());
+            nodeData.parent = parentBlueprintIdx;
+            nodeData.transform = ConvertToTransform(node->mTransformation);
+
+            for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
+                unsigned int meshIdx = node->mMeshes[i];
+                unsigned int oldMatIdx = scene->mMeshes[meshIdx]->mMaterialIndex;
+
+                // Remap to new material index
+                nodeData.entries.push_back({ meshIdx, materialIndexRemap[oldMatIdx] });
             }
 
+            int thisIdx = (int)model->nodes.size();
+            model->nodes.push_back(std::move(nodeData));
+
+            for (unsigned int i = 0; i < node->mNumChildren; ++i)
+                processNode(node->mChildren[i], thisIdx);
+
+            return thisIdx;
+        };
+
+        processNode(scene->mRootNode, null);
+
+        generateMips(*model, cooking);
+        return model;
+    }
+
+    std::shared_ptr<Model> ResourceLoader::upload(ModelData& data) {
+        std::shared_ptr<Model> model = std::make_shared<Model>();
+        model->m_path = data.path;
+        model->loadCfg = data.cfg;
+        model->bounds = data.bounds;
+
+        Ref<ResourceSystem> rs = Application::Get().GetResourceSystem();
+
+        // ========== Meshes, reserved up front since collections point into it ==========
+        model->meshes.reserve(data.meshes.size());
+        for (ModelData::MeshData& m : data.meshes)
+            model->meshes.emplace_back(m.vertices, m.indices, m.bounds);
+
+        // ========== Materials ==========
+        auto uploadTexture = [&rs](const ModelData::TextureData& tex) -> optional<std::shared_ptr<Texture>> {
+            if (!tex.image) return {};
+
+            // Shared embedded images only get uploaded once
+            if (!tex.cacheKey.empty()) {
+                if (std::shared_ptr<Texture> cached = rs->find<Texture>(tex.cacheKey))
+                    return cached;
+            }
+
+            // Cooked ones start with their mip tail and stream the rest in once they're on screen
+            std::shared_ptr<Texture> texture = tex.cooked
+                ? Application::Get().GetRenderer()->GetTextureStreamer().Create(*tex.image, *tex.cooked)
+                : std::make_shared<Texture>(*tex.image);
+            if (!tex.cacheKey.empty())
+                rs->cache<Texture>(tex.cacheKey, texture);
+            return texture;
+        };
+
+        model->materials.reserve(data.materials.size());
+        for (const ModelData::MaterialData& mat : data.materials) {
+            Material material;
+
+            auto diffuseTex = uploadTexture(mat.textures[(int)Shader::TextureSlot::DIFFUSE]);
+            auto specularTex = uploadTexture(mat.textures[(int)Shader::TextureSlot::SPECULAR]);
+            auto normalTex = uploadTexture(mat.textures[(int)Shader::TextureSlot::NORMAL]);
+            auto emmisiveTex = uploadTexture(mat.textures[(int)Shader::TextureSlot::EMMISIVE]);
+
+            // Set textures or defaults
+            material.diffuse = diffuseTex.value_or(DefaultAssets::GetDefaultColorTexture());
+            material.specular = specularTex.value_or(DefaultAssets::GetDefaultColorTexture());
+            material.normal = normalTex.value_or(DefaultAssets::GetDefaultNormalTexture());
+            material.emmisive = normalTex.value_or(DefaultAssets::GetDefaultEmmisiveTexture());
+
+            material.diffuseColor = mat.diffuseColor;
+            material.specularColor = mat.specularColor;
+            material.shininess = mat.shininess;
+            material.emmisiveIntensity = mat.emmisiveIntensity;
+            material.emmisiveColor = mat.emmisiveColor;
+            material.isTransparent = mat.isTransparent;
+            material.opacity = mat.opacity;
+
             // ========== Classify material type (highest wins) ==========
             bool hasAnyTexture = diffuseTex.has_value() || specularTex.has_value() || normalTex.has_value();
 
-            if (isEmmisive) {
+            if (mat.isEmmisive) {
                 material.renderType = Material::RenderType::EMMISIVE;
                 material.shader = DefaultAssets::GetEmmisiveShader();
             }
@@ -627,56 +866,43 @@ namespace Engine {
                 material.shader = DefaultAssets::GetLitShader();
             }
 
-            // Store the new index for this material
-            unsigned int newIdx = static_cast<unsigned int>(model->materials.size());
-            materialIndexRemap[oldIdx] = newIdx;
-
             // Cache the material for debugging
-            material.m_path = path;
-            rs->cache<Material>(path.string() + ":mat:" + std::to_string(oldIdx),
-                std::make_shared<Material>(material));
+            material.m_path = data.path;
+            rs->cache<Material>(mat.cacheKey, std::make_shared<Material>(material));
 
             model->materials.push_back(std::move(material));
         }
 
-        // ========== Build hierarchy and collections with remapped indices ==========
-        std::function<int(aiNode*, int)> processNode = [&](aiNode* node, entity_id parentBlueprintIdx) -> int {
-            Model::BlueprintNode blueprintNode;
-            blueprintNode.name = std::string(node->mName.C_Str());
-            blueprintNode.parent = parentBlueprintIdx;
-            blueprintNode.transform = ConvertToTransform(node->mTransformation);
-
+        // ========== Blueprint and collections ==========
+        model->blueprint.reserve(data.nodes.size());
+        model->collections.reserve(data.nodes.size());
+        for (const ModelData::NodeData& node : data.nodes) {
             Model::MeshCollection collection;
-            for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
-                unsigned int meshIdx = node->mMeshes[i];
-                unsigned int oldMatIdx = scene->mMeshes[meshIdx]->mMaterialIndex;
-
-                // Remap to new material index
-                unsigned int newMatIdx = materialIndexRemap[oldMatIdx];
-
+            collection.reserve(node.entries.size());
+            for (auto [meshIdx, matIdx] : node.entries) {
                 collection.push_back({
                     &model->meshes[meshIdx],
-                    &model->materials[newMatIdx]
+                    &model->materials[matIdx]
                 });
             }
 
+            Model::BlueprintNode blueprintNode;
+            blueprintNode.name = Component::Name(node.name);
+            blueprintNode.parent = node.parent;
+            blueprintNode.transform = node.transform;
             blueprintNode.collectionIndex = model->collections.size();
             model->collections.push_back(std::move(collection));
-
-            int thisIdx = (int)model->blueprint.size();
-            model->blueprint.push_back(blueprintNode);
-
-            for (unsigned int i = 0; i < node->mNumChildren; ++i)
-                processNode(node->mChildren[i], thisIdx);
-
-            return thisIdx;
-        };
-
-        processNode(scene->mRootNode, null);
+            model->blueprint.push_back(std::move(blueprintNode));
+        }
 
         return model;
     }
 
+    std::shared_ptr<Model> ResourceLoader::load(const std::filesystem::path& path, const LoadCfg::Model& cfg) {
+        std::shared_ptr<ModelData> data = decode(path, cfg, textureCooking());
+        return upload(*data);
+    }
+
     //std::shared_ptr<Model> ResourceLoader::load(const std::filesystem::path& path, const LoadCfg::Model& cfg) {
     //    Assimp::Importer importer;
     //    const aiScene* scene = importer.ReadFile(
@@ -885,19 +1111,27 @@ namespace Engine {
         glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, 0);
     }
 
-    Mesh::Mesh(std::vector<Vertex>& vertices, std::vector<u32>& indices) : indicesCount{ static_cast<u32>(indices.size()) } {
-        // Find our bounding box
+    static BBox ComputeBounds(const std::vector<Vertex>& vertices) {
+        if (vertices.empty()) return BBox{};
         vec3 min = vertices[0].position;
         vec3 max = vertices[0].position;
         for (auto& v : vertices) {
             min = glm::min(min, v.position);
             max = glm::max(max, v.position);
         }
-        bbox = BBox{ min, max };
+        return BBox{ min, max };
+    }
+
+    Mesh::Mesh(std::vector<Vertex>& vertices, std::vector<u32>& indices) : Mesh(vertices, indices, ComputeBounds(vertices)) {}
+
+    Mesh::Mesh(std::vector<Vertex>& vertices, std::vector<u32>& indices, const BBox& bounds) : indicesCount{ static_cast<u32>(indices.size()) }, verticesCount{ static_cast<u32>(vertices.size()) } {
+        // Bounds come precomputed from the importer
+        bbox = bounds;
         // vec3 center = (min + max) * 0.5f;
         vec3 center = bbox.center();
-        float radius = glm::length(max - center);
+        float radius = glm::length(bbox.max - center);
         bsphere = {.center = center, .radius = radius };
+        if (!s_GpuUpload) return;
 
         glGenVertexArrays(1, &vao);
         glGenBuffers(1, &vbo);
@@ -928,11 +1162,14 @@ namespace Engine {
         if (!program) ENGINE_THROW("Attempting to use uninitialized shader program");
 
         glUseProgram(program);
+        BuildUniformCache();
+    }
 
+    void Shader::BuildUniformCache() const {
         if (!m_CacheLoc.empty())
             return;
 
-        // Build the uniform cache
+        // Program doesn't need to be in use for any of this, command lists look locations up while recording
         GLint count = 0;
         glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
 
@@ -965,6 +1202,7 @@ namespace Engine {
 
     u32 Shader::GetUniformLoc(const std::string& name) const {
         // return glGetUniformLocation(program, name.c_str());
+        BuildUniformCache();
         return m_CacheLoc.at(name);
     }
 
@@ -1014,6 +1252,7 @@ namespace Engine {
     }
 
     bool Shader::HasUniform(const std::string& name) const {
+        BuildUniformCache();
         return m_CacheLoc.contains(name);
     }
 }
\ No newline at end of file
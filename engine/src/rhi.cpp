@@ -0,0 +1,82 @@
+#include <engine/rhi.hpp>
+#include <engine/exception.hpp>
+
+#include <glad/glad.h>
+
+namespace Engine::RHI {
+    void GLBackend::Execute(const CommandList& commands) {
+        // Whatever ran outside the list may have changed the bindings, so only repeats within it are skipped
+        u32 program = ~0u;
+        u32 vertexArray = ~0u;
+
+        for (const Command& cmd : commands.Commands()) {
+            switch (cmd.type) {
+            case CommandType::BindPipeline:
+                if (cmd.a == program) break;
+                program = cmd.a;
+                glUseProgram(cmd.a);
+                break;
+            case CommandType::BindVertexArray:
+                if (cmd.a == vertexArray) break;
+                vertexArray = cmd.a;
+                glBindVertexArray(cmd.a);
+                break;
+            case CommandType::BindTexture:
+                glActiveTexture(GL_TEXTURE0 + cmd.a);
+                glBindTexture(GL_TEXTURE_2D, cmd.b);
+                break;
+            case CommandType::BindStorageRange:
+                glBindBufferRange(GL_SHADER_STORAGE_BUFFER, cmd.a, cmd.b, cmd.c, cmd.d);
+                break;
+            case CommandType::SetInt:
+                glUniform1i(cmd.a, (GLint)cmd.b);
+                break;
+            case CommandType::SetFloat:
+                glUniform1fv(cmd.a, 1, commands.Payload(cmd.b));
+                break;
+            case CommandType::SetVec3:
+                glUniform3fv(cmd.a, 1, commands.Payload(cmd.b));
+                break;
+            case CommandType::SetVec4:
+                glUniform4fv(cmd.a, 1, commands.Payload(cmd.b));
+                break;
+            case CommandType::SetMat4:
+                glUniformMatrix4fv(cmd.a, 1, GL_FALSE, commands.Payload(cmd.b));
+                break;
+            case CommandType::DrawIndexed:
+                if (cmd.b == 1) glDrawElements(GL_TRIANGLES, cmd.a, GL_UNSIGNED_INT, 0);
+                else glDrawElementsInstanced(GL_TRIANGLES, cmd.a, GL_UNSIGNED_INT, 0, cmd.b);
+                break;
+            default:
+                ENGINE_THROW("Unknown RHI command");
+            }
+        }
+    }
+
+    void NullBackend::Execute(const CommandList& commands) {
+        m_Counters.commands += commands.Size();
+        for (const Command& cmd : commands.Commands()) {
+            m_Counters.byType[(size_t)cmd.type]++;
+            if (cmd.type != CommandType::DrawIndexed) continue;
+            m_Counters.draws++;
+            m_Counters.instances += cmd.b;
+            m_Counters.indices += (u64)cmd.a * cmd.b;
+        }
+    }
+
+    std::unique_ptr<IBackend> CreateBackend(BackendType type) {
+        switch (type) {
+        case BackendType::GL: return std::make_unique<GLBackend>();
+        case BackendType::Null: return std::make_unique<NullBackend>();
+        }
+        ENGINE_THROW("Unknown RHI backend");
+    }
+
+    const char* GetBackendName(BackendType type) {
+        switch (type) {
+        case BackendType::GL: return "GL";
+        case BackendType::Null: return "Null";
+        }
+        return "Unknown";
+    }
+}
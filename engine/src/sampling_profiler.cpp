@@ -0,0 +1,388 @@
+#include <engine/sampling_profiler.hpp>
+#include <engine/log.hpp>
+
+#include <backward.hpp>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#undef min
+#undef max
+#else
+#include <cerrno>
+#include <csignal>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <thread>
+
+namespace Engine::SamplingProfiler {
+	static constexpr u32 MAX_DEPTH = 64;
+	static constexpr u32 MAX_SAMPLES = 1 << 14; // ~16 seconds at 1 kHz, ~8 MB
+
+	// Filled from the signal handler or the sampler thread, so the storage is allocated before sampling starts
+	struct Sample {
+		u32 thread = 0;
+		u32 depth = 0;
+		void* frames[MAX_DEPTH]; // leaf first
+	};
+
+	static vector<Sample> s_Samples;
+	static std::atomic<u32> s_Next{ 0 };
+	static std::atomic<u64> s_Dropped{ 0 };
+	static std::atomic<bool> s_Running{ false };
+	static Config s_Config;
+	static u32 s_Frame = 0;
+	static u64 s_MainThread = 0;
+	static path s_LastOutput;
+
+	static Sample* AcquireSample() {
+		const u32 index = s_Next.fetch_add(1, std::memory_order_relaxed);
+		if (index < s_Samples.size()) return &s_Samples[index];
+		s_Dropped.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+#ifdef _WIN32
+#if defined(_M_X64)
+	static constexpr bool SUPPORTED = true;
+#else
+	static constexpr bool SUPPORTED = false;
+#endif
+
+	static HANDLE s_Target = nullptr;
+	static std::thread s_Sampler;
+
+	// Nothing here may allocate, the suspended thread could be holding the heap lock
+	static void SampleTarget() {
+#if defined(_M_X64)
+		if (SuspendThread(s_Target) == (DWORD)-1) {
+			s_Dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		CONTEXT context{};
+		context.ContextFlags = CONTEXT_FULL;
+		if (Sample* sample = AcquireSample()) {
+			sample->thread = (u32)s_MainThread;
+			sample->depth = 0;
+			if (GetThreadContext(s_Target, &context)) {
+				while (context.Rip && sample->depth < MAX_DEPTH) {
+					sample->frames[sample->depth++] = (void*)context.Rip;
+					DWORD64 imageBase = 0;
+					PRUNTIME_FUNCTION function = RtlLookupFunctionEntry(context.Rip, &imageBase, nullptr);
+					if (!function) {
+						// Leaf function without unwind info, the return address is on top of the stack
+						context.Rip = *(DWORD64*)context.Rsp;
+						context.Rsp += 8;
+						continue;
+					}
+					PVOID handlerData = nullptr;
+					DWORD64 establisherFrame = 0;
+					RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, context.Rip, function, &context, &handlerData, &establisherFrame, nullptr);
+				}
+			}
+			if (sample->depth == 0) s_Dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+		ResumeThread(s_Target);
+#endif
+	}
+
+	// Sleep granularity keeps the real rate near or below 1 kHz, every sample still weighs the same
+	static void SamplerLoop(u32 frequencyHz) {
+		const auto interval = std::chrono::nanoseconds(1000000000ull / frequencyHz);
+		auto next = std::chrono::steady_clock::now();
+		while (s_Running.load(std::memory_order_relaxed)) {
+			SampleTarget();
+			next += interval;
+			std::this_thread::sleep_until(next);
+		}
+	}
+
+	static bool Arm() {
+		if (!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &s_Target,
+			THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, 0))
+			return false;
+		s_MainThread = GetCurrentThreadId();
+		s_Running.store(true);
+		s_Sampler = std::thread(SamplerLoop, s_Config.frequencyHz);
+		return true;
+	}
+
+	static void Disarm() {
+		s_Running.store(false);
+		if (s_Sampler.joinable()) s_Sampler.join();
+		CloseHandle(s_Target);
+		s_Target = nullptr;
+	}
+
+	// Only the thread that started the capture gets sampled
+	static string ThreadName(u32) {
+		return "main";
+	}
+#else
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+	static constexpr bool SUPPORTED = true;
+#else
+	static constexpr bool SUPPORTED = false;
+#endif
+
+	static std::atomic<u32> s_InHandler{ 0 };
+	static bool s_HandlerInstalled = false;
+
+	// Writable mappings when the capture started, sorted. Thread stacks are among them, each one bounded by its
+	// guard page, so the mapping holding a thread's stack pointer is as far as its frame chain may go
+	struct Region {
+		uintptr_t begin, end;
+	};
+	static vector<Region> s_Regions;
+
+	static void SnapshotRegions() {
+		s_Regions.clear();
+		std::ifstream maps("/proc/self/maps");
+		string line;
+		while (std::getline(maps, line)) {
+			size_t begin = 0, end = 0;
+			char perms[5] = {};
+			if (std::sscanf(line.c_str(), "%zx-%zx %4s", &begin, &end, perms) != 3) continue;
+			if (perms[0] == 'r' && perms[1] == 'w') s_Regions.push_back({ (uintptr_t)begin, (uintptr_t)end });
+		}
+		// The kernel lists them in address order already, cheap to make sure
+		std::sort(s_Regions.begin(), s_Regions.end(), [](const Region& a, const Region& b) { return a.begin < b.begin; });
+	}
+
+	static const Region* FindRegion(uintptr_t address) {
+		auto it = std::upper_bound(s_Regions.begin(), s_Regions.end(), address, [](uintptr_t a, const Region& r) { return a < r.begin; });
+		if (it == s_Regions.begin()) return nullptr;
+		--it;
+		return address < it->end ? &*it : nullptr;
+	}
+
+	// Async-signal-safe by construction: no locks, no allocation, and only reads memory between the interrupted
+	// stack pointer and the end of its mapping. Needs frame pointers (-fno-omit-frame-pointer, see CMakeLists.txt),
+	// code built without them ends the chain early instead of reading garbage. Threads started after the capture
+	// began aren't in the snapshot and only get their leaf
+	static void WalkFramePointers(const ucontext_t& context, Sample& sample) {
+#if defined(__x86_64__)
+		const uintptr_t pc = (uintptr_t)context.uc_mcontext.gregs[REG_RIP];
+		uintptr_t fp = (uintptr_t)context.uc_mcontext.gregs[REG_RBP];
+		const uintptr_t sp = (uintptr_t)context.uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+		const uintptr_t pc = (uintptr_t)context.uc_mcontext.pc;
+		uintptr_t fp = (uintptr_t)context.uc_mcontext.regs[29];
+		const uintptr_t sp = (uintptr_t)context.uc_mcontext.sp;
+#else
+		const uintptr_t pc = 0, sp = 0;
+		uintptr_t fp = 0;
+#endif
+		sample.depth = 0;
+		if (!pc) return;
+		sample.frames[sample.depth++] = (void*)pc;
+
+		const Region* stack = FindRegion(sp);
+		if (!stack) return;
+
+		// Both ABIs keep { caller's frame pointer, return address } at the frame pointer
+		while (sample.depth < MAX_DEPTH) {
+			if (fp < sp || fp < stack->begin || fp > stack->end - 2 * sizeof(uintptr_t) || fp % sizeof(uintptr_t) != 0)
+				break;
+			const uintptr_t* record = reinterpret_cast<const uintptr_t*>(fp);
+			const uintptr_t next = record[0];
+			const uintptr_t ret = record[1];
+			if (!ret) break;
+			sample.frames[sample.depth++] = (void*)ret;
+			// Callers live further up the stack, anything else is a broken chain
+			if (next <= fp) break;
+			fp = next;
+		}
+	}
+
+	static void OnSignal(int, siginfo_t*, void* context) {
+		// Counted before the check, so Disarm can't free the samples under a handler that got past it
+		s_InHandler.fetch_add(1, std::memory_order_acquire);
+		if (!s_Running.load(std::memory_order_acquire)) {
+			s_InHandler.fetch_sub(1, std::memory_order_release);
+			return;
+		}
+		const int savedErrno = errno;
+
+		if (Sample* sample = AcquireSample()) {
+			// Walked from the interrupted context, so neither this handler nor the signal trampoline show up
+			sample->thread = (u32)syscall(SYS_gettid);
+			WalkFramePointers(*static_cast<const ucontext_t*>(context), *sample);
+			if (sample->depth == 0) s_Dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		s_InHandler.fetch_sub(1, std::memory_order_release);
+		errno = savedErrno;
+	}
+
+	static bool Arm() {
+		// Read by the handler, only replaced while no capture runs
+		SnapshotRegions();
+
+		// Stays installed, a SIGPROF that arrives after the timer is stopped would otherwise kill the process
+		if (!s_HandlerInstalled) {
+			struct sigaction action {};
+			action.sa_sigaction = OnSignal;
+			action.sa_flags = SA_SIGINFO | SA_RESTART;
+			sigemptyset(&action.sa_mask);
+			if (sigaction(SIGPROF, &action, nullptr) != 0) return false;
+			s_HandlerInstalled = true;
+		}
+
+		s_MainThread = (u64)syscall(SYS_gettid);
+		s_Running.store(true);
+
+		// Process CPU time, so the samples land on whichever threads are busy
+		const long interval = std::max(1l, 1000000l / (long)s_Config.frequencyHz);
+		itimerval timer{};
+		timer.it_interval.tv_sec = interval / 1000000;
+		timer.it_interval.tv_usec = interval % 1000000;
+		timer.it_value = timer.it_interval;
+		if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+			s_Running.store(false);
+			return false;
+		}
+		return true;
+	}
+
+	static void Disarm() {
+		itimerval timer{};
+		setitimer(ITIMER_PROF, &timer, nullptr);
+		s_Running.store(false);
+		while (s_InHandler.load(std::memory_order_acquire) != 0)
+			std::this_thread::yield();
+	}
+
+	static string ThreadName(u32 thread) {
+		return thread == s_MainThread ? "main" : "thread " + std::to_string(thread);
+	}
+#endif
+
+	// Frames above the leaf are return addresses, one byte back is still inside the call
+	static void* LookupAddress(const Sample& sample, u32 frame) {
+		return frame == 0 ? sample.frames[0] : (void*)((uintptr_t)sample.frames[frame] - 1);
+	}
+
+	static string Symbolize(backward::TraceResolver& resolver, void* address, size_t index) {
+		// The backtrace_symbols resolver goes by index into what load_addresses got, the others by address
+		backward::ResolvedTrace trace = resolver.resolve(backward::ResolvedTrace(backward::Trace(address, index)));
+
+		string name = trace.object_function;
+		if (name.empty()) {
+			const string object = path(trace.object_filename).filename().string();
+			name = fmt::format("[{}+{:#x}]", object.empty() ? "unknown" : object, (uintptr_t)address);
+		}
+		// Frames are separated by ';' and the count by the last space, keep those out of the names
+		std::replace(name.begin(), name.end(), ';', ':');
+		std::replace(name.begin(), name.end(), '\n', ' ');
+		return name;
+	}
+
+	static void Write() {
+		const u32 count = std::min(s_Next.load(), (u32)s_Samples.size());
+
+		// Every distinct address resolved once
+		vector<void*> addresses;
+		for (u32 i = 0; i < count; i++)
+			for (u32 f = 0; f < s_Samples[i].depth; f++)
+				addresses.push_back(LookupAddress(s_Samples[i], f));
+		std::sort(addresses.begin(), addresses.end());
+		addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+
+		backward::TraceResolver resolver;
+		resolver.load_addresses(addresses.data(), (int)addresses.size());
+		std::unordered_map<void*, string> names;
+		for (size_t i = 0; i < addresses.size(); i++)
+			names.emplace(addresses[i], Symbolize(resolver, addresses[i], i));
+
+		std::map<string, u64> folded;
+		string stack;
+		for (u32 i = 0; i < count; i++) {
+			const Sample& sample = s_Samples[i];
+			if (sample.depth == 0) continue;
+			stack = ThreadName(sample.thread);
+			for (u32 f = sample.depth; f-- > 0;) {
+				stack += ';';
+				stack += names[LookupAddress(sample, f)];
+			}
+			folded[stack]++;
+		}
+
+		std::ofstream file(s_Config.output, std::ios::trunc);
+		if (!file) {
+			Log::warn("Failed to write sampling profile {}", s_Config.output.string());
+			return;
+		}
+		for (auto& [line, samples] : folded)
+			file << line << ' ' << samples << '\n';
+		s_LastOutput = s_Config.output;
+		Log::info("Saved sampling profile {} ({} samples, {} stacks, {} dropped)", s_Config.output.string(), count, folded.size(), s_Dropped.load());
+	}
+
+	bool IsSupported() {
+		return SUPPORTED;
+	}
+
+	bool Start(const Config& config) {
+		if (!SUPPORTED) {
+			Log::warn("Sampling profiler isn't supported on this platform");
+			return false;
+		}
+		if (IsRunning()) Stop();
+
+		s_Config = config;
+		s_Config.frequencyHz = std::clamp(s_Config.frequencyHz, 1u, 100000u);
+		s_Samples.assign(MAX_SAMPLES, Sample{});
+		s_Next.store(0);
+		s_Dropped.store(0);
+		s_Frame = 0;
+
+		if (!Arm()) {
+			Log::warn("Failed to start the sampling profiler");
+			return false;
+		}
+		Log::info("Sampling at {} Hz {}", s_Config.frequencyHz, s_Config.frames > 0 ? "for " + std::to_string(s_Config.frames) + " frames" : string("until stopped"));
+		return true;
+	}
+
+	void Stop() {
+		if (!IsRunning()) return;
+		Disarm();
+		Write();
+		// Keep the count for GetSampleCount, drop the storage
+		const u32 count = std::min(s_Next.load(), (u32)s_Samples.size());
+		s_Samples = vector<Sample>();
+		s_Next.store(count);
+	}
+
+	bool IsRunning() {
+		return s_Running.load(std::memory_order_relaxed);
+	}
+
+	void OnFrame() {
+		if (!IsRunning()) return;
+		if (s_Config.frames > 0 && ++s_Frame >= s_Config.frames) Stop();
+	}
+
+	u64 GetSampleCount() {
+		return std::min<u64>(s_Next.load(std::memory_order_relaxed), MAX_SAMPLES);
+	}
+
+	u64 GetDroppedCount() {
+		return s_Dropped.load(std::memory_order_relaxed);
+	}
+
+	const path& GetLastOutput() {
+		return s_LastOutput;
+	}
+}
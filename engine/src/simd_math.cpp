@@ -0,0 +1,154 @@
+#include "simd_math_kernels.inl"
+
+#include <engine/log.hpp>
+
+#include <cmath>
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+namespace Engine::SIMD::detail {
+namespace {
+	// One lane, the fallback everywhere the CPU can't do better (and the tails of the SIMD loops here)
+	struct F1 {
+		static constexpr size_t Width = 1;
+		using Mask = bool;
+		f32 v;
+
+		static F1 Load(const f32* p) { return { *p }; }
+		static void Store(f32* p, F1 a) { *p = a.v; }
+		static F1 Set(f32 s) { return { s }; }
+	};
+
+	inline F1 operator+(F1 a, F1 b) { return { a.v + b.v }; }
+	inline F1 operator-(F1 a, F1 b) { return { a.v - b.v }; }
+	inline F1 operator*(F1 a, F1 b) { return { a.v * b.v }; }
+	inline F1 operator/(F1 a, F1 b) { return { a.v / b.v }; }
+	inline F1 MulAdd(F1 a, F1 b, F1 c) { return { a.v * b.v + c.v }; }
+	inline F1 Sqrt(F1 a) { return { std::sqrt(a.v) }; }
+	inline F1 Min(F1 a, F1 b) { return { a.v < b.v ? a.v : b.v }; }
+	inline F1 Max(F1 a, F1 b) { return { a.v > b.v ? a.v : b.v }; }
+	inline bool Less(F1 a, F1 b) { return a.v < b.v; }
+	inline F1 Select(bool mask, F1 a, F1 b) { return mask ? a : b; }
+}
+
+	const KernelTable& ScalarKernels() {
+		static const KernelTable table = MakeKernelTable<F1, F1>();
+		return table;
+	}
+}
+
+namespace Engine::SIMD {
+	static Level DetectLevel() {
+#ifdef SIMD_X86
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		const bool sse41 = (info[2] & (1 << 19)) != 0;
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+
+		bool avx2 = false;
+		if (maxLeaf >= 7 && avx && fma && osxsave) {
+			// The OS has to save the YMM registers on context switches too
+			const bool ymmState = (_xgetbv(0) & 0x6) == 0x6;
+			__cpuidex(info, 7, 0);
+			avx2 = ymmState && (info[1] & (1 << 5)) != 0;
+		}
+#else
+		__builtin_cpu_init();
+		const bool sse41 = __builtin_cpu_supports("sse4.1");
+		const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+		if (avx2 && detail::AVX2Kernels()) return Level::AVX2;
+		if (sse41 && detail::SSE4Kernels()) return Level::SSE4;
+#endif
+		return Level::Scalar;
+	}
+
+	static const Level s_Supported = DetectLevel();
+	static std::atomic<const detail::KernelTable*> s_Kernels{ nullptr };
+	static std::atomic<Level> s_Level{ Level::Scalar };
+
+	static const detail::KernelTable& TableFor(Level level) {
+		switch (level) {
+		case Level::AVX2: return *detail::AVX2Kernels();
+		case Level::SSE4: return *detail::SSE4Kernels();
+		default: return detail::ScalarKernels();
+		}
+	}
+
+	static const detail::KernelTable& Kernels() {
+		const detail::KernelTable* table = s_Kernels.load(std::memory_order_acquire);
+		if (!table) {
+			s_Level.store(s_Supported, std::memory_order_relaxed);
+			table = &TableFor(s_Supported);
+			s_Kernels.store(table, std::memory_order_release);
+		}
+		return *table;
+	}
+
+	Level GetLevel() {
+		Kernels();
+		return s_Level.load(std::memory_order_relaxed);
+	}
+
+	Level GetSupportedLevel() {
+		return s_Supported;
+	}
+
+	void SetLevel(Level level) {
+		if (level > s_Supported) {
+			Log::warn("{} math kernels aren't supported here, using {}", GetLevelName(level), GetLevelName(s_Supported));
+			level = s_Supported;
+		}
+		s_Level.store(level, std::memory_order_relaxed);
+		s_Kernels.store(&TableFor(level), std::memory_order_release);
+	}
+
+	const char* GetLevelName(Level level) {
+		switch (level) {
+		case Level::AVX2: return "AVX2";
+		case Level::SSE4: return "SSE4";
+		default: return "Scalar";
+		}
+	}
+
+	void ComposeTRS(const TRSArrays& in, const AffineArrays& out, size_t count) {
+		Kernels().composeTRS(in, out, count);
+	}
+
+	void MultiplyAffine(const AffineArrays& parents, const AffineArrays& locals, const AffineArrays& out, size_t count) {
+		Kernels().multiplyAffine(parents, locals, out, count);
+	}
+
+	void TransformSpheres(const AffineArrays& models, const SphereArrays& in, const SphereArrays& out, size_t count) {
+		Kernels().transformSpheres(models, in, out, count);
+	}
+
+	void SlerpQuats(const QuatArrays& a, const QuatArrays& b, const f32* t, const QuatArrays& out, size_t count) {
+		Kernels().slerpQuats(a, b, t, out, count);
+	}
+
+	void ScaleAdd(const f32* in, f32 weight, f32* out, size_t count) {
+		Kernels().scaleAdd(in, weight, out, count);
+	}
+}
+
+#ifndef SIMD_X86
+// Nothing but the scalar kernels off x86
+namespace Engine::SIMD::detail {
+	const KernelTable* SSE4Kernels() { return nullptr; }
+	const KernelTable* AVX2Kernels() { return nullptr; }
+}
+#endif
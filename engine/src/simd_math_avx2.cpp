@@ -0,0 +1,58 @@
+// Compiled with AVX2 + FMA enabled (see CMakeLists.txt), only called once simd_math.cpp saw the CPU supports both
+#include "simd_math_kernels.inl"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+namespace Engine::SIMD::detail {
+namespace {
+	struct F8 {
+		static constexpr size_t Width = 8;
+		using Mask = __m256;
+		__m256 v;
+
+		static F8 Load(const f32* p) { return { _mm256_loadu_ps(p) }; }
+		static void Store(f32* p, F8 a) { _mm256_storeu_ps(p, a.v); }
+		static F8 Set(f32 s) { return { _mm256_set1_ps(s) }; }
+	};
+
+	inline F8 operator+(F8 a, F8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+	inline F8 operator-(F8 a, F8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	inline F8 operator*(F8 a, F8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	inline F8 operator/(F8 a, F8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+	inline F8 MulAdd(F8 a, F8 b, F8 c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+	inline F8 Sqrt(F8 a) { return { _mm256_sqrt_ps(a.v) }; }
+	inline F8 Min(F8 a, F8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+	inline F8 Max(F8 a, F8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+	inline __m256 Less(F8 a, F8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+	inline F8 Select(__m256 mask, F8 a, F8 b) { return { _mm256_blendv_ps(b.v, a.v, mask) }; }
+
+	// Single lane for the tails, fused multiply-add like the wide lanes so results don't depend on the index
+	struct S1 {
+		static constexpr size_t Width = 1;
+		using Mask = __m128;
+		__m128 v;
+
+		static S1 Load(const f32* p) { return { _mm_load_ss(p) }; }
+		static void Store(f32* p, S1 a) { _mm_store_ss(p, a.v); }
+		static S1 Set(f32 s) { return { _mm_set_ss(s) }; }
+	};
+
+	inline S1 operator+(S1 a, S1 b) { return { _mm_add_ss(a.v, b.v) }; }
+	inline S1 operator-(S1 a, S1 b) { return { _mm_sub_ss(a.v, b.v) }; }
+	inline S1 operator*(S1 a, S1 b) { return { _mm_mul_ss(a.v, b.v) }; }
+	inline S1 operator/(S1 a, S1 b) { return { _mm_div_ss(a.v, b.v) }; }
+	inline S1 MulAdd(S1 a, S1 b, S1 c) { return { _mm_fmadd_ss(a.v, b.v, c.v) }; }
+	inline S1 Sqrt(S1 a) { return { _mm_sqrt_ss(a.v) }; }
+	inline S1 Min(S1 a, S1 b) { return { _mm_min_ss(a.v, b.v) }; }
+	inline S1 Max(S1 a, S1 b) { return { _mm_max_ss(a.v, b.v) }; }
+	inline __m128 Less(S1 a, S1 b) { return _mm_cmplt_ss(a.v, b.v); }
+	inline S1 Select(__m128 mask, S1 a, S1 b) { return { _mm_blendv_ps(b.v, a.v, mask) }; }
+}
+
+	const KernelTable* AVX2Kernels() {
+		static const KernelTable table = MakeKernelTable<F8, S1>();
+		return &table;
+	}
+}
+#endif
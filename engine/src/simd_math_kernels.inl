@@ -0,0 +1,200 @@
+// Kernel bodies shared by the scalar, SSE4 and AVX2 translation units of simd_math
+// Each includer defines its lane types (Width, Load, Store, Set, + - * /, MulAdd, Sqrt, Min, Max, Less, Select)
+// and instantiates MakeKernelTable with them. Everything in here has internal linkage on purpose: the AVX2 unit
+// is compiled with AVX2 enabled and must not hand the linker inline code that other units could end up calling
+#pragma once
+
+#include <engine/simd_math.hpp>
+
+namespace Engine::SIMD::detail {
+	struct KernelTable {
+		void (*composeTRS)(const TRSArrays&, const AffineArrays&, size_t);
+		void (*multiplyAffine)(const AffineArrays&, const AffineArrays&, const AffineArrays&, size_t);
+		void (*transformSpheres)(const AffineArrays&, const SphereArrays&, const SphereArrays&, size_t);
+		void (*slerpQuats)(const QuatArrays&, const QuatArrays&, const f32*, const QuatArrays&, size_t);
+		void (*scaleAdd)(const f32*, f32, f32*, size_t);
+	};
+
+	// Defined by the unit of each level, the SIMD ones only when the compiler targets x86
+	const KernelTable& ScalarKernels();
+	const KernelTable* SSE4Kernels();
+	const KernelTable* AVX2Kernels();
+}
+
+namespace Engine::SIMD::detail {
+namespace {
+	template<typename V>
+	inline void ComposeTRSAt(const TRSArrays& in, const AffineArrays& out, size_t i) {
+		const V x = V::Load(in.qx + i), y = V::Load(in.qy + i), z = V::Load(in.qz + i), w = V::Load(in.qw + i);
+		const V sx = V::Load(in.sx + i), sy = V::Load(in.sy + i), sz = V::Load(in.sz + i);
+		const V px = V::Load(in.px + i), py = V::Load(in.py + i), pz = V::Load(in.pz + i);
+
+		const V one = V::Set(1.0f), two = V::Set(2.0f);
+		const V xx = x * x, yy = y * y, zz = z * z;
+		const V xy = x * y, xz = x * z, yz = y * z;
+		const V wx = w * x, wy = w * y, wz = w * z;
+
+		// Same matrix as glm::mat4_cast, columns scaled by the scale, translation in the last column
+		V::Store(out.m[0] + i, (one - two * (yy + zz)) * sx);
+		V::Store(out.m[1] + i, two * (xy - wz) * sy);
+		V::Store(out.m[2] + i, two * (xz + wy) * sz);
+		V::Store(out.m[3] + i, px);
+
+		V::Store(out.m[4] + i, two * (xy + wz) * sx);
+		V::Store(out.m[5] + i, (one - two * (xx + zz)) * sy);
+		V::Store(out.m[6] + i, two * (yz - wx) * sz);
+		V::Store(out.m[7] + i, py);
+
+		V::Store(out.m[8] + i, two * (xz - wy) * sx);
+		V::Store(out.m[9] + i, two * (yz + wx) * sy);
+		V::Store(out.m[10] + i, (one - two * (xx + yy)) * sz);
+		V::Store(out.m[11] + i, pz);
+	}
+
+	template<typename V>
+	inline void MultiplyAffineAt(const AffineArrays& parents, const AffineArrays& locals, const AffineArrays& out, size_t i) {
+		// Everything gets loaded before anything is stored, that's what makes out == locals (or parents) fine
+		V p[12], l[12];
+		for (int j = 0; j < 12; j++) {
+			p[j] = V::Load(parents.m[j] + i);
+			l[j] = V::Load(locals.m[j] + i);
+		}
+
+		for (int row = 0; row < 3; row++) {
+			const V p0 = p[row * 4 + 0], p1 = p[row * 4 + 1], p2 = p[row * 4 + 2], p3 = p[row * 4 + 3];
+			V::Store(out.m[row * 4 + 0] + i, MulAdd(p2, l[8], MulAdd(p1, l[4], p0 * l[0])));
+			V::Store(out.m[row * 4 + 1] + i, MulAdd(p2, l[9], MulAdd(p1, l[5], p0 * l[1])));
+			V::Store(out.m[row * 4 + 2] + i, MulAdd(p2, l[10], MulAdd(p1, l[6], p0 * l[2])));
+			V::Store(out.m[row * 4 + 3] + i, MulAdd(p2, l[11], MulAdd(p1, l[7], MulAdd(p0, l[3], p3))));
+		}
+	}
+
+	template<typename V>
+	inline void TransformSpheresAt(const AffineArrays& models, const SphereArrays& in, const SphereArrays& out, size_t i) {
+		V m[12];
+		for (int j = 0; j < 12; j++) m[j] = V::Load(models.m[j] + i);
+		const V cx = V::Load(in.cx + i), cy = V::Load(in.cy + i), cz = V::Load(in.cz + i), r = V::Load(in.r + i);
+
+		// Largest column length, the same conservative radius the CPU side of the renderer always used
+		const V c0 = MulAdd(m[8], m[8], MulAdd(m[4], m[4], m[0] * m[0]));
+		const V c1 = MulAdd(m[9], m[9], MulAdd(m[5], m[5], m[1] * m[1]));
+		const V c2 = MulAdd(m[10], m[10], MulAdd(m[6], m[6], m[2] * m[2]));
+
+		V::Store(out.cx + i, MulAdd(m[2], cz, MulAdd(m[1], cy, MulAdd(m[0], cx, m[3]))));
+		V::Store(out.cy + i, MulAdd(m[6], cz, MulAdd(m[5], cy, MulAdd(m[4], cx, m[7]))));
+		V::Store(out.cz + i, MulAdd(m[10], cz, MulAdd(m[9], cy, MulAdd(m[8], cx, m[11]))));
+		V::Store(out.r + i, r * Sqrt(Max(c0, Max(c1, c2))));
+	}
+
+	// acos on [0, 1], Abramowitz & Stegun 4.4.46, |error| <= 2e-8
+	template<typename V>
+	inline V AcosUnit(V x) {
+		V poly = V::Set(-0.0012624911f);
+		poly = MulAdd(poly, x, V::Set(0.0066700901f));
+		poly = MulAdd(poly, x, V::Set(-0.0170881256f));
+		poly = MulAdd(poly, x, V::Set(0.0308918810f));
+		poly = MulAdd(poly, x, V::Set(-0.0501743046f));
+		poly = MulAdd(poly, x, V::Set(0.0889789874f));
+		poly = MulAdd(poly, x, V::Set(-0.2145988016f));
+		poly = MulAdd(poly, x, V::Set(1.5707963050f));
+		return Sqrt(Max(V::Set(1.0f) - x, V::Set(0.0f))) * poly;
+	}
+
+	// sin on [0, pi/2], Taylor to x^11, error below 1e-7 over the range
+	template<typename V>
+	inline V SinHalfPi(V x) {
+		const V x2 = x * x;
+		V poly = V::Set(-1.0f / 39916800.0f);
+		poly = MulAdd(poly, x2, V::Set(1.0f / 362880.0f));
+		poly = MulAdd(poly, x2, V::Set(-1.0f / 5040.0f));
+		poly = MulAdd(poly, x2, V::Set(1.0f / 120.0f));
+		poly = MulAdd(poly, x2, V::Set(-1.0f / 6.0f));
+		poly = MulAdd(poly, x2, V::Set(1.0f));
+		return x * poly;
+	}
+
+	template<typename V>
+	inline void SlerpQuatsAt(const QuatArrays& a, const QuatArrays& b, const f32* t, const QuatArrays& out, size_t i) {
+		const V ax = V::Load(a.x + i), ay = V::Load(a.y + i), az = V::Load(a.z + i), aw = V::Load(a.w + i);
+		V bx = V::Load(b.x + i), by = V::Load(b.y + i), bz = V::Load(b.z + i), bw = V::Load(b.w + i);
+		const V tt = V::Load(t + i);
+		const V zero = V::Set(0.0f), one = V::Set(1.0f);
+
+		// Shortest path, flip b when the quaternions are more than 90 degrees apart
+		V cosTheta = MulAdd(aw, bw, MulAdd(az, bz, MulAdd(ay, by, ax * bx)));
+		const auto flip = Less(cosTheta, zero);
+		bx = Select(flip, zero - bx, bx);
+		by = Select(flip, zero - by, by);
+		bz = Select(flip, zero - bz, bz);
+		bw = Select(flip, zero - bw, bw);
+		cosTheta = Min(Select(flip, zero - cosTheta, cosTheta), one);
+
+		const V angle = AcosUnit(cosTheta);
+		const V sinAngle = Max(SinHalfPi(angle), V::Set(1e-30f));
+		const V wa = SinHalfPi((one - tt) * angle) / sinAngle;
+		const V wb = SinHalfPi(tt * angle) / sinAngle;
+
+		// Nearly the same rotation: glm falls back to a plain lerp, so do we
+		const auto linear = Less(V::Set(1.0f - 1.1920929e-07f), cosTheta);
+		const V la = Select(linear, one - tt, wa);
+		const V lb = Select(linear, tt, wb);
+
+		V::Store(out.x + i, MulAdd(bx, lb, ax * la));
+		V::Store(out.y + i, MulAdd(by, lb, ay * la));
+		V::Store(out.z + i, MulAdd(bz, lb, az * la));
+		V::Store(out.w + i, MulAdd(bw, lb, aw * la));
+	}
+
+	template<typename V>
+	inline void ScaleAddAt(const f32* in, f32 weight, f32* out, size_t i) {
+		V::Store(out + i, MulAdd(V::Load(in + i), V::Set(weight), V::Load(out + i)));
+	}
+
+	// Full width groups with V, the remainder one element at a time with S
+	template<typename V, typename S>
+	void ComposeTRSKernel(const TRSArrays& in, const AffineArrays& out, size_t count) {
+		size_t i = 0;
+		for (; i + V::Width <= count; i += V::Width) ComposeTRSAt<V>(in, out, i);
+		for (; i < count; i++) ComposeTRSAt<S>(in, out, i);
+	}
+
+	template<typename V, typename S>
+	void MultiplyAffineKernel(const AffineArrays& parents, const AffineArrays& locals, const AffineArrays& out, size_t count) {
+		size_t i = 0;
+		for (; i + V::Width <= count; i += V::Width) MultiplyAffineAt<V>(parents, locals, out, i);
+		for (; i < count; i++) MultiplyAffineAt<S>(parents, locals, out, i);
+	}
+
+	template<typename V, typename S>
+	void TransformSpheresKernel(const AffineArrays& models, const SphereArrays& in, const SphereArrays& out, size_t count) {
+		size_t i = 0;
+		for (; i + V::Width <= count; i += V::Width) TransformSpheresAt<V>(models, in, out, i);
+		for (; i < count; i++) TransformSpheresAt<S>(models, in, out, i);
+	}
+
+	template<typename V, typename S>
+	void SlerpQuatsKernel(const QuatArrays& a, const QuatArrays& b, const f32* t, const QuatArrays& out, size_t count) {
+		size_t i = 0;
+		for (; i + V::Width <= count; i += V::Width) SlerpQuatsAt<V>(a, b, t, out, i);
+		for (; i < count; i++) SlerpQuatsAt<S>(a, b, t, out, i);
+	}
+
+	template<typename V, typename S>
+	void ScaleAddKernel(const f32* in, f32 weight, f32* out, size_t count) {
+		size_t i = 0;
+		for (; i + V::Width <= count; i += V::Width) ScaleAddAt<V>(in, weight, out, i);
+		for (; i < count; i++) ScaleAddAt<S>(in, weight, out, i);
+	}
+
+	template<typename V, typename S>
+	KernelTable MakeKernelTable() {
+		return KernelTable{
+			&ComposeTRSKernel<V, S>,
+			&MultiplyAffineKernel<V, S>,
+			&TransformSpheresKernel<V, S>,
+			&SlerpQuatsKernel<V, S>,
+			&ScaleAddKernel<V, S>
+		};
+	}
+}
+}
@@ -0,0 +1,58 @@
+// Compiled with SSE4.1 enabled (see CMakeLists.txt), only called once simd_math.cpp saw the CPU supports it
+#include "simd_math_kernels.inl"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <smmintrin.h>
+
+namespace Engine::SIMD::detail {
+namespace {
+	struct F4 {
+		static constexpr size_t Width = 4;
+		using Mask = __m128;
+		__m128 v;
+
+		static F4 Load(const f32* p) { return { _mm_loadu_ps(p) }; }
+		static void Store(f32* p, F4 a) { _mm_storeu_ps(p, a.v); }
+		static F4 Set(f32 s) { return { _mm_set1_ps(s) }; }
+	};
+
+	inline F4 operator+(F4 a, F4 b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline F4 operator-(F4 a, F4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline F4 operator*(F4 a, F4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline F4 operator/(F4 a, F4 b) { return { _mm_div_ps(a.v, b.v) }; }
+	inline F4 MulAdd(F4 a, F4 b, F4 c) { return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) }; }
+	inline F4 Sqrt(F4 a) { return { _mm_sqrt_ps(a.v) }; }
+	inline F4 Min(F4 a, F4 b) { return { _mm_min_ps(a.v, b.v) }; }
+	inline F4 Max(F4 a, F4 b) { return { _mm_max_ps(a.v, b.v) }; }
+	inline __m128 Less(F4 a, F4 b) { return _mm_cmplt_ps(a.v, b.v); }
+	inline F4 Select(__m128 mask, F4 a, F4 b) { return { _mm_blendv_ps(b.v, a.v, mask) }; }
+
+	// Single lane for the tails, same instructions so the tail matches the wide lanes bit for bit
+	struct S1 {
+		static constexpr size_t Width = 1;
+		using Mask = __m128;
+		__m128 v;
+
+		static S1 Load(const f32* p) { return { _mm_load_ss(p) }; }
+		static void Store(f32* p, S1 a) { _mm_store_ss(p, a.v); }
+		static S1 Set(f32 s) { return { _mm_set_ss(s) }; }
+	};
+
+	inline S1 operator+(S1 a, S1 b) { return { _mm_add_ss(a.v, b.v) }; }
+	inline S1 operator-(S1 a, S1 b) { return { _mm_sub_ss(a.v, b.v) }; }
+	inline S1 operator*(S1 a, S1 b) { return { _mm_mul_ss(a.v, b.v) }; }
+	inline S1 operator/(S1 a, S1 b) { return { _mm_div_ss(a.v, b.v) }; }
+	inline S1 MulAdd(S1 a, S1 b, S1 c) { return { _mm_add_ss(_mm_mul_ss(a.v, b.v), c.v) }; }
+	inline S1 Sqrt(S1 a) { return { _mm_sqrt_ss(a.v) }; }
+	inline S1 Min(S1 a, S1 b) { return { _mm_min_ss(a.v, b.v) }; }
+	inline S1 Max(S1 a, S1 b) { return { _mm_max_ss(a.v, b.v) }; }
+	inline __m128 Less(S1 a, S1 b) { return _mm_cmplt_ss(a.v, b.v); }
+	inline S1 Select(__m128 mask, S1 a, S1 b) { return { _mm_blendv_ps(b.v, a.v, mask) }; }
+}
+
+	const KernelTable* SSE4Kernels() {
+		static const KernelTable table = MakeKernelTable<F4, S1>();
+		return &table;
+	}
+}
+#endif
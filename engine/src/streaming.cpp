@@ -0,0 +1,336 @@
+#include <engine/streaming.hpp>
+#include <engine/application.hpp>
+#include <engine/log.hpp>
+
+namespace Engine {
+	static f32 ElapsedMs(StreamingSystem::clock::time_point from, StreamingSystem::clock::time_point to) {
+		return std::chrono::duration<f32, std::milli>(to - from).count();
+	}
+
+	// Rough VRAM estimate, textures are RGBA8 with a full mip chain
+	static size_t EstimateGPUBytes(const Model& model) {
+		size_t bytes = 0;
+		for (const Mesh& mesh : model.meshes)
+			bytes += (size_t)mesh.verticesCount * sizeof(Vertex) + (size_t)mesh.indicesCount * sizeof(u32);
+
+		unordered_set<const Texture*> seen;
+		for (const Material& mat : model.materials) {
+			for (const Texture* tex : { mat.diffuse.get(), mat.specular.get(), mat.normal.get(), mat.emmisive.get() }) {
+				if (tex && seen.insert(tex).second)
+					bytes += (size_t)tex->width * tex->height * 4 * 4 / 3;
+			}
+		}
+		return bytes;
+	}
+
+	StreamingSystem::StreamingSystem(ECS& ecs) : ISystem(ecs) {}
+
+	StreamingSystem::~StreamingSystem() {
+		StopWorkers();
+	}
+
+	void StreamingSystem::Configure(const StreamingConfig& config) {
+		if (config.unloadRadius < config.loadRadius)
+			Log::warn("Streaming unload radius {} is smaller than load radius {}, cells will thrash", config.unloadRadius, config.loadRadius);
+
+		if (config.cellSize != m_Config.cellSize && !m_Cells.empty())
+			ENGINE_THROW("Cannot change streaming cell size after objects were added");
+
+		if (config.workerThreads != m_Config.workerThreads) {
+			StopWorkers();
+			// Queued jobs are gone, let Update request these again
+			for (auto& [coord, cell] : m_Cells) {
+				if (cell.state == CellState::Loading) {
+					cell.generation++;
+					cell.state = CellState::Unloaded;
+				}
+			}
+		}
+		m_Config = config;
+	}
+
+	void StreamingSystem::AddObject(const path& model, const Component::Transform& transform, const LoadCfg::Model& cfg) {
+		CellCoord coord = ToCell(transform.position);
+		Cell& cell = m_Cells[coord];
+		cell.coord = coord;
+		cell.objects.push_back(CellObject{ .model = model, .cfg = cfg, .transform = transform });
+	}
+
+	void StreamingSystem::Clear() {
+		for (auto& [coord, cell] : m_Cells)
+			UnloadCell(cell);
+		m_Cells.clear();
+	}
+
+	size_t StreamingSystem::GetPendingJobs() {
+		std::lock_guard lock(m_Mutex);
+		return m_Jobs.size();
+	}
+
+	optional<vector<entity_id>> StreamingSystem::Update(f32 deltaTime) {
+		(void)deltaTime;
+		if (m_Cells.empty()) return std::nullopt;
+
+		CollectResults();
+
+		optional<vec3> focus = m_Focus ? m_Focus : FindFocus();
+		if (!focus) return std::nullopt;
+
+		for (auto& [coord, cell] : m_Cells) {
+			f32 distance = DistanceToCell(coord, *focus);
+			if (cell.state == CellState::Unloaded && distance <= m_Config.loadRadius)
+				RequestCell(cell);
+			else if (cell.state != CellState::Unloaded && distance > m_Config.unloadRadius)
+				UnloadCell(cell);
+		}
+
+		InstantiateCells(*focus);
+		return std::nullopt;
+	}
+
+	void StreamingSystem::PostUpdate() {}
+
+	CellCoord StreamingSystem::ToCell(const vec3& position) const {
+		return CellCoord{
+			.x = (i32)std::floor(position.x / m_Config.cellSize),
+			.z = (i32)std::floor(position.z / m_Config.cellSize)
+		};
+	}
+
+	f32 StreamingSystem::DistanceToCell(const CellCoord& coord, const vec3& point) const {
+		// Distance on XZ to the closest point of the cell
+		f32 minX = coord.x * m_Config.cellSize, maxX = minX + m_Config.cellSize;
+		f32 minZ = coord.z * m_Config.cellSize, maxZ = minZ + m_Config.cellSize;
+		f32 dx = std::max({ minX - point.x, 0.0f, point.x - maxX });
+		f32 dz = std::max({ minZ - point.z, 0.0f, point.z - maxZ });
+		return std::sqrt(dx * dx + dz * dz);
+	}
+
+	optional<vec3> StreamingSystem::FindFocus() {
+		for (auto [entity, world, cam] : m_Ecs->Query<Component::WorldTransform, Component::Camera>()) {
+			if (cam.isMain)
+				return world.Position();
+		}
+		return std::nullopt;
+	}
+
+	void StreamingSystem::StartWorkers() {
+		if (!m_Workers.empty()) return;
+		u32 count = std::max(1u, m_Config.workerThreads);
+		for (u32 i = 0; i < count; ++i)
+			m_Workers.emplace_back(&StreamingSystem::WorkerLoop, this);
+	}
+
+	void StreamingSystem::StopWorkers() {
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Stop = true;
+			m_Jobs.clear();
+		}
+		m_Signal.notify_all();
+		for (std::thread& worker : m_Workers)
+			worker.join();
+		m_Workers.clear();
+
+		std::lock_guard lock(m_Mutex);
+		m_Results.clear();
+		m_Stop = false;
+	}
+
+	void StreamingSystem::WorkerLoop() {
+		while (true) {
+			Job job;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Signal.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+				if (m_Stop) return;
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+			}
+
+			// CPU only work, GL upload happens on the main thread
+			JobResult result{ .coord = job.coord, .generation = job.generation, .bytes = 0 };
+			for (auto& [modelPath, cfg] : job.models) {
+				try {
+					Ref<ModelData> data = ResourceLoader::decode(modelPath, cfg, job.cooking);
+					result.bytes += data->GetByteSize();
+					result.decoded[modelPath.string()] = data;
+				}
+				catch (const std::exception& e) {
+					Log::error("Streaming failed to decode '{}': {}", modelPath.string(), e.what());
+					result.decoded[modelPath.string()] = nullptr; // marks it as failed
+				}
+			}
+			result.finished = clock::now();
+
+			std::lock_guard lock(m_Mutex);
+			m_Results.push_back(std::move(result));
+		}
+	}
+
+	void StreamingSystem::RequestCell(Cell& cell) {
+		Ref<ResourceSystem> rs = Application::Get().GetResourceSystem();
+
+		cell.generation++;
+		cell.state = CellState::Loading;
+		cell.requested = clock::now();
+		cell.nextObject = 0;
+		cell.decoded.clear();
+		cell.stats.cpuBytes = 0;
+		cell.stats.gpuBytes = 0;
+		cell.stats.entities = 0;
+		cell.stats.frames = 0;
+
+		// Only decode what isn't resident already
+		Job job{ .coord = cell.coord, .generation = cell.generation };
+		unordered_set<string> seen;
+		for (const CellObject& obj : cell.objects) {
+			if (seen.insert(obj.model.string()).second && !rs->find<Model>(obj.model))
+				job.models.push_back({ obj.model, obj.cfg });
+		}
+
+		if (job.models.empty()) {
+			cell.decodedAt = cell.requested;
+			cell.stats.decodeMs = 0.0f;
+			cell.state = CellState::Instantiating;
+			return;
+		}
+
+		job.cooking = ResourceLoader::textureCooking();
+		StartWorkers();
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Jobs.push_back(std::move(job));
+		}
+		m_Signal.notify_one();
+	}
+
+	void StreamingSystem::UnloadCell(Cell& cell) {
+		if (cell.state == CellState::Unloaded) return;
+
+		if (cell.root != null) {
+			m_Ecs->DestroyEntity(cell.root, true);
+			cell.root = null;
+		}
+
+		// Drop the queued job, in-flight ones get ignored thanks to the generation bump
+		{
+			std::lock_guard lock(m_Mutex);
+			std::erase_if(m_Jobs, [&](const Job& job) { return job.coord == cell.coord; });
+		}
+		cell.generation++;
+		cell.state = CellState::Unloaded;
+		cell.nextObject = 0;
+		cell.decoded.clear();
+
+		vector<string> released;
+		for (auto& [modelPath, model] : cell.models)
+			released.push_back(modelPath);
+		cell.models.clear();
+
+		// Anything other cells or the scene still hold stays cached
+		Ref<ResourceSystem> rs = Application::Get().GetResourceSystem();
+		size_t evicted = 0;
+		for (const string& modelPath : released)
+			evicted += rs->evict_unused(modelPath);
+
+		Log::trace("Streaming unloaded cell ({}, {}), evicted {} resources", cell.coord.x, cell.coord.z, evicted);
+	}
+
+	void StreamingSystem::CollectResults() {
+		vector<JobResult> results;
+		{
+			std::lock_guard lock(m_Mutex);
+			results.swap(m_Results);
+		}
+
+		for (JobResult& result : results) {
+			auto it = m_Cells.find(result.coord);
+			if (it == m_Cells.end()) continue;
+
+			Cell& cell = it->second;
+			if (cell.generation != result.generation || cell.state != CellState::Loading) continue; // stale
+
+			cell.decoded = std::move(result.decoded);
+			cell.decodedAt = result.finished;
+			cell.stats.cpuBytes = result.bytes;
+			cell.stats.decodeMs = ElapsedMs(cell.requested, result.finished);
+			cell.state = CellState::Instantiating;
+		}
+	}
+
+	void StreamingSystem::InstantiateCells(const vec3& focus) {
+		// Closest cells first
+		vector<Cell*> pending;
+		for (auto& [coord, cell] : m_Cells) {
+			if (cell.state == CellState::Instantiating)
+				pending.push_back(&cell);
+		}
+		if (pending.empty()) return;
+
+		std::sort(pending.begin(), pending.end(), [&](const Cell* a, const Cell* b) {
+			return DistanceToCell(a->coord, focus) < DistanceToCell(b->coord, focus);
+		});
+
+		Ref<ResourceSystem> rs = Application::Get().GetResourceSystem();
+		auto start = clock::now();
+		bool didWork = false;
+
+		auto acquire = [&](Cell& cell, const CellObject& obj) -> Ref<Model> {
+			string key = obj.model.string();
+			if (auto it = cell.models.find(key); it != cell.models.end())
+				return it->second;
+
+			Ref<Model> model = rs->find<Model>(obj.model);
+			if (!model) {
+				if (auto it = cell.decoded.find(key); it != cell.decoded.end()) {
+					if (!it->second) return nullptr; // decode failed, already logged
+					model = ResourceLoader::upload(*it->second);
+					rs->cache<Model>(key, model);
+					cell.decoded.erase(it);
+				}
+				else {
+					// Evicted between request and now, rare enough to just load it here
+					model = rs->load<Model>(obj.model, obj.cfg);
+				}
+			}
+
+			cell.models[key] = model;
+			return model;
+		};
+
+		for (Cell* cell : pending) {
+			if (cell->root == null) {
+				Component::Transform origin;
+				cell->root = m_Ecs->CreateEntity3D(null, origin, "cell_" + std::to_string(cell->coord.x) + "_" + std::to_string(cell->coord.z));
+				cell->stats.entities = 1;
+			}
+			cell->stats.frames++;
+
+			while (cell->nextObject < cell->objects.size()) {
+				// Always make some progress, even if a single upload blows the budget
+				if (didWork && ElapsedMs(start, clock::now()) > m_Config.frameBudgetMs) return;
+
+				const CellObject& obj = cell->objects[cell->nextObject++];
+				Ref<Model> model = acquire(*cell, obj);
+				didWork = true;
+				if (!model) continue;
+
+				m_Ecs->Instantiate(cell->root, obj.transform, model);
+				cell->stats.entities += (u32)model->blueprint.size();
+			}
+
+			// Everything is in the world
+			cell->decoded.clear();
+			cell->state = CellState::Resident;
+			cell->stats.instantiateMs = ElapsedMs(cell->decodedAt, clock::now());
+			cell->stats.loads++;
+			cell->stats.gpuBytes = 0;
+			for (auto& [modelPath, model] : cell->models)
+				cell->stats.gpuBytes += EstimateGPUBytes(*model);
+
+			Log::trace("Streaming cell ({}, {}) resident: {} entities, decode {:.2f} ms, instantiate {:.2f} ms over {} frames",
+				cell->coord.x, cell->coord.z, cell->stats.entities, cell->stats.decodeMs, cell->stats.instantiateMs, cell->stats.frames);
+		}
+	}
+}
@@ -0,0 +1,439 @@
+#include <engine/texture_streaming.hpp>
+#include <engine/log.hpp>
+
+#include <fstream>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+namespace Engine {
+	static constexpr u32 COOKED_MAGIC = 0x50494D47; // "GMIP"
+	static constexpr u32 COOKED_VERSION = 1;
+
+	struct CookedHeader {
+		u32 magic = COOKED_MAGIC;
+		u32 version = COOKED_VERSION;
+		i32 width = 0;
+		i32 height = 0;
+		i32 channels = 0;
+		u32 levels = 0;
+	};
+
+	static size_t CookedLevelSize(const CookedHeader& header, u32 level) {
+		return (size_t)std::max(1, header.width >> level) * std::max(1, header.height >> level) * header.channels;
+	}
+
+	static bool ReadHeader(std::ifstream& file, CookedHeader& header) {
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		return file && header.magic == COOKED_MAGIC && header.version == COOKED_VERSION;
+	}
+
+	// Small mips of RGB textures have rows that aren't 4 byte aligned
+	struct UnpackAlignment {
+		GLint previous = 4;
+		UnpackAlignment() {
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		}
+		~UnpackAlignment() { glPixelStorei(GL_UNPACK_ALIGNMENT, previous); }
+	};
+
+	static void SetSamplerParameters() {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
+
+	TextureStreamer::TextureStreamer() {}
+
+	TextureStreamer::~TextureStreamer() {
+		StopWorkers();
+	}
+
+	void TextureStreamer::Configure(const TextureStreamingConfig& config) {
+		bool restart = false;
+		{
+			std::lock_guard lock(m_ConfigMutex);
+			restart = config.workerThreads != m_Config.workerThreads;
+			m_Config = config;
+		}
+
+		if (restart) {
+			StopWorkers();
+			// Queued reads are gone, Update requests them again
+			for (auto& [key, entry] : m_Entries)
+				entry.pending = false;
+		}
+	}
+
+	TextureStreamingConfig TextureStreamer::GetConfig() {
+		std::lock_guard lock(m_ConfigMutex);
+		return m_Config;
+	}
+
+	optional<path> TextureStreamer::Cook(const Image& image, const string& key, const path& cacheDir, const path& source) {
+		if (!image.data || image.channels <= 0) return std::nullopt;
+
+		u32 levels = Resample::MipCount(image.width, image.height);
+		if (image.mips.size() != (size_t)levels - 1) return std::nullopt;
+
+		std::error_code ec;
+		std::filesystem::create_directories(cacheDir, ec);
+		if (ec) {
+			Log::warn("Cannot create texture cache '{}': {}", cacheDir.string(), ec.message());
+			return std::nullopt;
+		}
+
+		CookedHeader header;
+		header.width = image.width;
+		header.height = image.height;
+		header.channels = image.channels;
+		header.levels = levels;
+
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.gmip", (unsigned long long)std::hash<string>{}(key));
+		path cooked = cacheDir / name;
+
+		// Reuse when it's newer than the source and describes the same image
+		if (std::filesystem::exists(cooked, ec)) {
+			auto cookedTime = std::filesystem::last_write_time(cooked, ec);
+			auto sourceTime = std::filesystem::last_write_time(source, ec);
+			if (!ec && cookedTime >= sourceTime) {
+				std::ifstream file(cooked, std::ios::binary);
+				CookedHeader existing;
+				if (ReadHeader(file, existing) && existing.width == header.width && existing.height == header.height
+					&& existing.channels == header.channels && existing.levels == header.levels)
+					return cooked;
+			}
+		}
+
+		// Written next to the target and renamed, several loaders can cook the same texture at once
+		path temp = cooked;
+		temp += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+			if (!file) {
+				Log::warn("Cannot write cooked texture '{}'", temp.string());
+				return std::nullopt;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(image.data), CookedLevelSize(header, 0));
+			for (u32 level = 1; level < levels; ++level)
+				file.write(reinterpret_cast<const char*>(image.mips[level - 1].data()), CookedLevelSize(header, level));
+
+			if (!file) {
+				Log::warn("Failed writing cooked texture '{}'", temp.string());
+				file.close();
+				std::filesystem::remove(temp, ec);
+				return std::nullopt;
+			}
+		}
+
+		std::filesystem::rename(temp, cooked, ec);
+		if (ec) {
+			std::filesystem::remove(temp, ec);
+			// Somebody else won the race, theirs is just as good
+			if (std::filesystem::exists(cooked, ec)) return cooked;
+			return std::nullopt;
+		}
+		return cooked;
+	}
+
+	Ref<Texture> TextureStreamer::Create(const Image& image, const path& cooked) {
+		TextureStreamingConfig config = GetConfig();
+
+		u32 levels = Resample::MipCount(image.width, image.height);
+		if (image.mips.size() != (size_t)levels - 1 || (image.channels != 3 && image.channels != 4))
+			return MakeRef<Texture>(image);
+
+		// Coarsest level that is still above the tail size is where we start
+		u32 tailLevel = 0;
+		while (tailLevel + 1 < levels && (u32)std::max(image.width >> tailLevel, image.height >> tailLevel) > config.tailSize)
+			tailLevel++;
+		if (tailLevel == 0)
+			return MakeRef<Texture>(image);
+
+		Entry entry;
+		entry.cooked = cooked;
+		entry.width = image.width;
+		entry.height = image.height;
+		entry.levels = levels;
+		entry.tailLevel = tailLevel;
+		entry.wantedLevel = tailLevel;
+		entry.imgFormat = image.channels == 3 ? GL_RGB : GL_RGBA;
+		entry.texFormat = image.channels == 3 ? GL_SRGB8 : GL_SRGB8_ALPHA8;
+		entry.lastRequested = m_Frame;
+
+		Ref<Texture> texture = MakeRef<Texture>();
+		texture->m_path = image.m_path;
+		texture->width = image.width;
+		texture->height = image.height;
+		texture->levels = levels;
+		texture->baseLevel = tailLevel;
+
+		glGenTextures(1, &texture->id);
+		glBindTexture(GL_TEXTURE_2D, texture->id);
+		SetSamplerParameters();
+		glTexStorage2D(GL_TEXTURE_2D, levels - tailLevel, entry.texFormat, std::max(1, image.width >> tailLevel), std::max(1, image.height >> tailLevel));
+		{
+			UnpackAlignment alignment;
+			for (u32 level = tailLevel; level < levels; ++level) {
+				int w = std::max(1, image.width >> level);
+				int h = std::max(1, image.height >> level);
+				glTexSubImage2D(GL_TEXTURE_2D, level - tailLevel, 0, 0, w, h, entry.imgFormat, GL_UNSIGNED_BYTE, image.mips[level - 1].data());
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		entry.texture = texture;
+		m_Entries[texture.get()] = std::move(entry);
+		return texture;
+	}
+
+	void TextureStreamer::Request(const Texture* texture, f32 screenPixels) {
+		auto it = m_Entries.find(texture);
+		if (it == m_Entries.end()) return;
+		it->second.requestedPixels = std::max(it->second.requestedPixels, screenPixels);
+	}
+
+	size_t TextureStreamer::LevelBytes(const Entry& entry, u32 level) const {
+		// GL pads RGB8 to 4 bytes per texel on pretty much every driver
+		return (size_t)std::max(1, entry.width >> level) * std::max(1, entry.height >> level) * 4;
+	}
+
+	size_t TextureStreamer::ResidentBytes(const Entry& entry, u32 base) const {
+		size_t bytes = 0;
+		for (u32 level = base; level < entry.levels; ++level)
+			bytes += LevelBytes(entry, level);
+		return bytes;
+	}
+
+	void TextureStreamer::Reallocate(Entry& entry, Texture& texture, u32 newBase, const vector<vector<u8>>* newLevels) {
+		GLuint id;
+		glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D, id);
+		SetSamplerParameters();
+		glTexStorage2D(GL_TEXTURE_2D, entry.levels - newBase, entry.texFormat, std::max(1, entry.width >> newBase), std::max(1, entry.height >> newBase));
+
+		// Levels both storages have stay on the GPU
+		for (u32 level = std::max(newBase, texture.baseLevel); level < entry.levels; ++level) {
+			int w = std::max(1, entry.width >> level);
+			int h = std::max(1, entry.height >> level);
+			glCopyImageSubData(texture.id, GL_TEXTURE_2D, level - texture.baseLevel, 0, 0, 0, id, GL_TEXTURE_2D, level - newBase, 0, 0, 0, w, h, 1);
+		}
+
+		if (newLevels) {
+			UnpackAlignment alignment;
+			for (u32 level = newBase; level < texture.baseLevel && level - newBase < newLevels->size(); ++level) {
+				int w = std::max(1, entry.width >> level);
+				int h = std::max(1, entry.height >> level);
+				glTexSubImage2D(GL_TEXTURE_2D, level - newBase, 0, 0, w, h, entry.imgFormat, GL_UNSIGNED_BYTE, (*newLevels)[level - newBase].data());
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glDeleteTextures(1, &texture.id);
+		texture.id = id;
+		texture.baseLevel = newBase;
+	}
+
+	void TextureStreamer::Update() {
+		m_Frame++;
+		TextureStreamingConfig config = GetConfig();
+		m_Stats.uploads = 0;
+
+		// Finished reads, capped so a burst doesn't turn into a hitch
+		{
+			std::lock_guard lock(m_Mutex);
+			for (JobResult& result : m_Results)
+				m_Ready.push_back(std::move(result));
+			m_Results.clear();
+		}
+
+		size_t consumed = 0;
+		for (; consumed < m_Ready.size() && m_Stats.uploads < config.maxUploadsPerFrame; ++consumed) {
+			JobResult& result = m_Ready[consumed];
+			auto it = m_Entries.find(result.key);
+			if (it == m_Entries.end()) continue;
+
+			Entry& entry = it->second;
+			Ref<Texture> texture = entry.texture.lock();
+			if (!texture || texture != result.texture.lock()) continue; // address got reused
+			entry.pending = false;
+
+			if (result.levels.empty()) {
+				// Cooked file is gone or broken, stay on what we have
+				Log::warn("Texture streaming failed to read '{}', keeping mip {}", entry.cooked.string(), texture->baseLevel);
+				entry.tailLevel = texture->baseLevel;
+				entry.cooked.clear();
+				continue;
+			}
+
+			if (result.first < texture->baseLevel) {
+				Reallocate(entry, *texture, result.first, &result.levels);
+				m_Stats.uploads++;
+			}
+		}
+		m_Ready.erase(m_Ready.begin(), m_Ready.begin() + consumed);
+
+		// What every texture wants given this frame's requests
+		size_t residentBytes = 0;
+		size_t wantedBytes = 0;
+		for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+			Entry& entry = it->second;
+			Ref<Texture> texture = entry.texture.lock();
+			if (!texture) {
+				it = m_Entries.erase(it);
+				continue;
+			}
+
+			if (entry.requestedPixels > 0.0f) {
+				f32 size = (f32)std::max(entry.width, entry.height);
+				f32 lod = std::log2(size / std::max(entry.requestedPixels, 1.0f)) + config.lodBias;
+				entry.wantedLevel = (u32)std::clamp((i32)std::floor(lod), 0, (i32)entry.tailLevel);
+				entry.lastRequested = m_Frame;
+			}
+			else if (m_Frame - entry.lastRequested > config.idleFrames) {
+				entry.wantedLevel = entry.tailLevel;
+			}
+			entry.requestedPixels = 0.0f;
+
+			residentBytes += ResidentBytes(entry, texture->baseLevel);
+			wantedBytes += ResidentBytes(entry, entry.wantedLevel);
+			++it;
+		}
+
+		// Over budget: drop levels nobody wants first, then the least recently used ones a level at a time
+		while (residentBytes > config.budgetBytes) {
+			Entry* victim = nullptr;
+			Texture* victimTexture = nullptr;
+			bool victimSurplus = false;
+			for (auto& [key, entry] : m_Entries) {
+				Ref<Texture> texture = entry.texture.lock();
+				if (!texture || entry.pending || texture->baseLevel >= entry.tailLevel) continue; // pending reads expect the current base
+
+				bool surplus = texture->baseLevel < entry.wantedLevel;
+				if (!victim || (surplus && !victimSurplus) || (surplus == victimSurplus && entry.lastRequested < victim->lastRequested)) {
+					victim = &entry;
+					victimTexture = texture.get();
+					victimSurplus = surplus;
+				}
+			}
+			if (!victim) break;
+
+			u32 newBase = victimSurplus ? victim->wantedLevel : victimTexture->baseLevel + 1;
+			residentBytes -= ResidentBytes(*victim, victimTexture->baseLevel) - ResidentBytes(*victim, newBase);
+			Reallocate(*victim, *victimTexture, newBase, nullptr);
+			victim->wantedLevel = std::max(victim->wantedLevel, newBase); // don't stream it straight back in
+			m_Stats.evictions++;
+		}
+
+		// New reads, most recently requested first, only what fits the budget
+		vector<Entry*> candidates;
+		for (auto& [key, entry] : m_Entries) {
+			Ref<Texture> texture = entry.texture.lock();
+			if (texture && !entry.pending && !entry.cooked.empty() && entry.wantedLevel < texture->baseLevel)
+				candidates.push_back(&entry);
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) {
+			return a->lastRequested != b->lastRequested ? a->lastRequested > b->lastRequested : a->wantedLevel < b->wantedLevel;
+		});
+
+		size_t projectedBytes = residentBytes;
+		for (auto& [key, entry] : m_Entries) {
+			Ref<Texture> texture = entry.texture.lock();
+			if (texture && entry.pending)
+				projectedBytes += ResidentBytes(entry, entry.wantedLevel) - ResidentBytes(entry, texture->baseLevel);
+		}
+
+		vector<Job> jobs;
+		for (Entry* entry : candidates) {
+			Ref<Texture> texture = entry->texture.lock();
+			u32 first = entry->wantedLevel;
+			while (first < texture->baseLevel && projectedBytes + ResidentBytes(*entry, first) - ResidentBytes(*entry, texture->baseLevel) > config.budgetBytes)
+				first++;
+			if (first >= texture->baseLevel) continue;
+
+			projectedBytes += ResidentBytes(*entry, first) - ResidentBytes(*entry, texture->baseLevel);
+			entry->pending = true;
+			jobs.push_back(Job{ .key = texture.get(), .texture = texture, .cooked = entry->cooked, .first = first, .last = texture->baseLevel });
+		}
+
+		if (!jobs.empty()) {
+			StartWorkers();
+			{
+				std::lock_guard lock(m_Mutex);
+				for (Job& job : jobs)
+					m_Jobs.push_back(std::move(job));
+			}
+			m_Signal.notify_all();
+		}
+
+		m_Stats.textures = (u32)m_Entries.size();
+		m_Stats.pending = 0;
+		for (auto& [key, entry] : m_Entries)
+			m_Stats.pending += entry.pending ? 1 : 0;
+		m_Stats.residentBytes = residentBytes;
+		m_Stats.wantedBytes = wantedBytes;
+	}
+
+	void TextureStreamer::StartWorkers() {
+		if (!m_Workers.empty()) return;
+		u32 count = std::max(1u, GetConfig().workerThreads);
+		for (u32 i = 0; i < count; ++i)
+			m_Workers.emplace_back(&TextureStreamer::WorkerLoop, this);
+	}
+
+	void TextureStreamer::StopWorkers() {
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Stop = true;
+			m_Jobs.clear();
+		}
+		m_Signal.notify_all();
+		for (std::thread& worker : m_Workers)
+			worker.join();
+		m_Workers.clear();
+
+		std::lock_guard lock(m_Mutex);
+		m_Results.clear();
+		m_Ready.clear();
+		m_Stop = false;
+	}
+
+	void TextureStreamer::WorkerLoop() {
+		while (true) {
+			Job job;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Signal.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+				if (m_Stop) return;
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+			}
+
+			JobResult result{ .key = job.key, .texture = job.texture, .first = job.first };
+			std::ifstream file(job.cooked, std::ios::binary);
+			CookedHeader header;
+			if (file && ReadHeader(file, header) && job.last <= header.levels) {
+				size_t offset = sizeof(CookedHeader);
+				for (u32 level = 0; level < job.first; ++level)
+					offset += CookedLevelSize(header, level);
+				file.seekg((std::streamoff)offset);
+
+				result.levels.resize(job.last - job.first);
+				for (u32 level = job.first; level < job.last; ++level) {
+					vector<u8>& data = result.levels[level - job.first];
+					data.resize(CookedLevelSize(header, level));
+					file.read(reinterpret_cast<char*>(data.data()), data.size());
+				}
+				if (!file) result.levels.clear();
+			}
+
+			std::lock_guard lock(m_Mutex);
+			m_Results.push_back(std::move(result));
+		}
+	}
+}
@@ -61,7 +61,15 @@ namespace Engine {
 	}
 
 	void Window::OnUpdate() {
+		PollEvents();
+		SwapBuffers();
+	}
+
+	void Window::PollEvents() {
 		glfwPollEvents();
+	}
+
+	void Window::SwapBuffers() {
 		glfwSwapBuffers(m_Window);
 	}
 
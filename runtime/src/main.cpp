@@ -6,6 +6,11 @@
 #include <engine/application.hpp>
 #include <engine/types.hpp>
 #include <engine/ecs.hpp>
+#include <engine/sampling_profiler.hpp>
+
+#include <charconv>
+#include <cstring>
+#include <optional>
 
 static void walk_cwd_to_project_root() {
     const std::string root_name = "grinder";
@@ -16,14 +21,126 @@ static void walk_cwd_to_project_root() {
     std::filesystem::current_path(cwd);
 }
 
-int main() {
+struct LaunchOptions {
+    Engine::ReplayConfig replay;
+    Engine::MetricsExportConfig metrics;
+    std::filesystem::path captureFile;
+    Engine::u32 captureFrames = 1;
+    Engine::u32 captureDelay = 0;
+    Engine::SamplingProfiler::Config sampling;
+    bool sample = false;
+    Engine::HeadlessConfig simulation;
+    bool headless = false;
+};
+
+// Needed before logging is up, the rest of the arguments are parsed after
+static bool has_flag(int argc, char** argv, const std::string& flag) {
+    for (int i = 1; i < argc; i++)
+        if (flag == argv[i]) return true;
+    return false;
+}
+
+// Numeric flag values, a malformed or out of range one is reported and leaves the default alone
+template<typename T>
+static void parse_number(const std::string& flag, const char* text, T& value) {
+    const char* end = text + std::strlen(text);
+    T parsed{};
+    const auto [last, error] = std::from_chars(text, end, parsed);
+    if (error != std::errc() || last != end) {
+        Engine::Log::warn("Ignoring {} {}, not a valid number", flag, text);
+        return;
+    }
+    value = parsed;
+}
+
+// --record <file> | --replay <file> [--fixed-step <ms>], --stats <file.csv|file.json>
+// --metrics-file <file>, --metrics-port <port>, --metrics-interval <seconds>
+// --capture <file> [--capture-frames <n>] [--capture-after <frames>], renderer input for grinder_replay
+// --sample-profile <file.folded> [--sample-frames <n>] [--sample-hz <hz>], folded stacks of the first frames
+// --headless [--frames <n>] [--fixed-step <ms>], simulation only without window or GL. --seed <n> fixes the RNG seeds
+static LaunchOptions parse_args(int argc, char** argv) {
+    LaunchOptions options;
+    Engine::ReplayConfig& config = options.replay;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--record" && hasValue) {
+            config.mode = Engine::ReplayConfig::Mode::Record;
+            config.file = argv[++i];
+        }
+        else if (arg == "--replay" && hasValue) {
+            config.mode = Engine::ReplayConfig::Mode::Playback;
+            config.file = argv[++i];
+        }
+        else if (arg == "--fixed-step" && hasValue) {
+            parse_number(arg, argv[++i], config.fixedStepMs);
+            options.simulation.fixedStepMs = config.fixedStepMs;
+        }
+        else if (arg == "--stats" && hasValue) {
+            config.statsFile = argv[++i];
+        }
+        else if (arg == "--metrics-file" && hasValue) {
+            options.metrics.file = argv[++i];
+        }
+        else if (arg == "--metrics-port" && hasValue) {
+            parse_number(arg, argv[++i], options.metrics.port);
+        }
+        else if (arg == "--metrics-interval" && hasValue) {
+            parse_number(arg, argv[++i], options.metrics.intervalSeconds);
+        }
+        else if (arg == "--capture" && hasValue) {
+            options.captureFile = argv[++i];
+        }
+        else if (arg == "--capture-frames" && hasValue) {
+            parse_number(arg, argv[++i], options.captureFrames);
+        }
+        else if (arg == "--capture-after" && hasValue) {
+            parse_number(arg, argv[++i], options.captureDelay);
+        }
+        else if (arg == "--sample-profile" && hasValue) {
+            options.sample = true;
+            options.sampling.output = argv[++i];
+        }
+        else if (arg == "--sample-frames" && hasValue) {
+            parse_number(arg, argv[++i], options.sampling.frames);
+        }
+        else if (arg == "--sample-hz" && hasValue) {
+            parse_number(arg, argv[++i], options.sampling.frequencyHz);
+        }
+        else if (arg == "--headless") {
+            options.headless = true;
+        }
+        else if (arg == "--frames" && hasValue) {
+            parse_number(arg, argv[++i], options.simulation.frames);
+        }
+        else if (arg == "--seed" && hasValue) {
+            parse_number(arg, argv[++i], config.seed);
+        }
+        else {
+            Engine::Log::warn("Unknown argument {}", arg);
+        }
+    }
+    return options;
+}
+
+int main(int argc, char** argv) {
     using namespace Engine;
 
+    // Paths on the command line are relative to where we got started from, not the project root
+    const std::filesystem::path launch_dir = std::filesystem::current_path();
+
     // Set cwd to project root - #hack
     walk_cwd_to_project_root();
 
     // Run engine initializations
-    engine_initialize();
+    engine_initialize(has_flag(argc, argv, "--headless"));
+
+    LaunchOptions options = parse_args(argc, argv);
+    if (!options.replay.file.empty()) options.replay.file = launch_dir / options.replay.file;
+    if (!options.replay.statsFile.empty()) options.replay.statsFile = launch_dir / options.replay.statsFile;
+    if (!options.metrics.file.empty()) options.metrics.file = launch_dir / options.metrics.file;
+    if (!options.captureFile.empty()) options.captureFile = launch_dir / options.captureFile;
+    if (options.sample) options.sampling.output = launch_dir / options.sampling.output;
 
     // Window properties
     const WindowProps props{
@@ -33,7 +150,7 @@ int main() {
 
     // ==== Start loading shit
     // Initialize subsystems, enforce ordering using scopes
-    Ref<Window> window = MakeRef<Window>(props); // window must get destroyed last as it holds the active gl context
+    Ref<Window> window = options.headless ? nullptr : MakeRef<Window>(props); // window must get destroyed last as it holds the active gl context
     {
         // Asset subsystems and data depend on gl context
         Ref<VFS> vfs = MakeRef<VFS>();
@@ -44,7 +161,17 @@ int main() {
             // Application depends on its subsystems
 
             // Create our application
-            Engine::Application app(window, vfs, rs, ecs);
+            std::optional<Engine::Application> application;
+            if (options.headless) application.emplace(vfs, rs, ecs, options.simulation);
+            else application.emplace(window, vfs, rs, ecs);
+            Engine::Application& app = *application;
+            // Before the scene loads, it draws its seeds during init
+            app.GetReplay().Configure(options.replay);
+            app.GetMetricsExporter().Start(options.metrics);
+            if (!options.captureFile.empty()) {
+                if (options.headless) Log::warn("Nothing to capture in a headless run, ignoring --capture");
+                else app.GetRenderer()->CaptureFrames(options.captureFile, options.captureFrames, options.captureDelay);
+            }
 
             // load our scene as a layer
             const std::string scene_name = "demo";
@@ -63,9 +190,13 @@ int main() {
 
 #ifdef _DEBUG
             // Push debug layer as an overlay
-            app.PushLayer(static_cast<ILayer*>(new DebugLayer()));
+            if (!options.headless)
+                app.PushLayer(static_cast<ILayer*>(new DebugLayer()));
 #endif
 
+            // Last, so the scene's init isn't in the window
+            if (options.sample) SamplingProfiler::Start(options.sampling);
+
             app.Run();
         }
     }
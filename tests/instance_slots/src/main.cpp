@@ -0,0 +1,99 @@
+#include <engine/renderer.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+// Frame sequences through the renderer's resident instance bookkeeping the way SceneLayer drives it: moves are
+// marked every frame, slots are only acquired and released on frames that draw. Exit code is the number of failed checks
+
+using namespace Engine;
+
+static u32 s_Failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (ok) return;
+    s_Failures++;
+    std::printf("  FAIL %s\n", what);
+}
+
+// The table only compares mesh pointers and never reads through them, meshes proper need a GL context
+static const Mesh* mesh_stand_in(u32 index) {
+    alignas(Mesh) static unsigned char storage[2][sizeof(Mesh)];
+    return reinterpret_cast<const Mesh*>(storage[index]);
+}
+
+// One SceneLayer::OnRender, without a camera it stops after marking the moves
+static bool frame(InstanceSlotTable& slots, const std::vector<entity_id>& moved, bool camera, entity_id entity, const Mesh* mesh) {
+    slots.MarkUpdated(moved);
+    if (!camera) return false;
+    const bool rewrite = slots.Acquire(entity, 0, mesh).rewrite;
+    slots.ReleaseUnseen(); // Draw
+    slots.EndFrame();      // Clear
+    return rewrite;
+}
+
+static void test_move_without_camera() {
+    InstanceSlotTable slots;
+    const Mesh* mesh = mesh_stand_in(0);
+    const entity_id entity = 5;
+
+    check(frame(slots, {}, true, entity, mesh), "new slot is written");
+    check(!frame(slots, {}, true, entity, mesh), "resting entity isn't rewritten");
+    frame(slots, { entity }, false, entity, mesh);
+    frame(slots, {}, false, entity, mesh);
+    check(frame(slots, {}, true, entity, mesh), "move during a frame without camera is uploaded on the next drawn frame");
+    check(!frame(slots, {}, true, entity, mesh), "and only once");
+}
+
+static void test_move_on_cleared_frame() {
+    // Frames that clear without queueing the entity (hidden for a frame, say) don't lose the move either
+    InstanceSlotTable slots;
+    const Mesh* mesh = mesh_stand_in(0);
+    const entity_id entity = 3;
+
+    frame(slots, {}, true, entity, mesh);
+    slots.MarkUpdated({ entity });
+    slots.EndFrame();
+    check(frame(slots, {}, true, entity, mesh), "move on a cleared frame that didn't queue it is uploaded later");
+}
+
+static void test_move_while_drawn() {
+    InstanceSlotTable slots;
+    const Mesh* mesh = mesh_stand_in(0);
+    const Mesh* other = mesh_stand_in(1);
+    const entity_id entity = 7;
+
+    frame(slots, {}, true, entity, mesh);
+    check(frame(slots, { entity }, true, entity, mesh), "move in a drawn frame is uploaded that frame");
+    check(!frame(slots, {}, true, entity, mesh), "and not the one after");
+    check(frame(slots, {}, true, entity, other), "mesh change is uploaded");
+    check(!frame(slots, { 8 }, true, entity, other), "other entities moving don't rewrite it");
+}
+
+static void test_slot_reuse() {
+    InstanceSlotTable slots;
+    const Mesh* mesh = mesh_stand_in(0);
+
+    const u32 first = slots.Acquire(1, 0, mesh).slot;
+    slots.ReleaseUnseen();
+    slots.EndFrame();
+
+    // Entity 1 isn't queued anymore, its slot frees up and the next new entry gets it, written from scratch
+    slots.ReleaseUnseen();
+    slots.EndFrame();
+    const InstanceSlotTable::Acquired reused = slots.Acquire(2, 0, mesh);
+    slots.ReleaseUnseen();
+    slots.EndFrame();
+    check(reused.slot == first && reused.rewrite, "released slot is reused and rewritten");
+    check(slots.Size() == 1, "no slot leaked");
+}
+
+int main() {
+    test_move_without_camera();
+    test_move_on_cleared_frame();
+    test_move_while_drawn();
+    test_slot_reuse();
+
+    std::printf("instance slots: %s\n", s_Failures == 0 ? "ok" : "FAILED");
+    return (int)std::min<u32>(s_Failures, 255);
+}
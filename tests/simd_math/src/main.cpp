@@ -0,0 +1,204 @@
+#include <engine/simd_math.hpp>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Runs every simd_math kernel at each dispatch level the CPU supports and compares the results
+// against the glm expressions they replace. Exit code is the number of failed checks
+
+using namespace Engine;
+
+// Counts not a multiple of either vector width (4, 8) so the scalar tails run too
+static constexpr size_t COUNTS[] = { 1, 3, 4, 7, 8, 13, 37 };
+
+static u32 s_Failures = 0;
+
+static void check(bool ok, const char* level, const char* what, size_t count, size_t i, f32 error) {
+    if (ok) return;
+    s_Failures++;
+    std::printf("  FAIL [%s] %s count %zu element %zu: error %g\n", level, what, count, i, error);
+}
+
+static f32 max_error(const mat4& a, const mat4& b) {
+    f32 error = 0.0f;
+    for (int column = 0; column < 4; column++)
+        for (int row = 0; row < 4; row++)
+            error = std::max(error, std::fabs(a[column][row] - b[column][row]));
+    return error;
+}
+
+// q and -q are the same rotation, compare up to sign
+static f32 max_error(const quat& a, const quat& b) {
+    f32 same = 0.0f, flipped = 0.0f;
+    for (int k = 0; k < 4; k++) {
+        same = std::max(same, std::fabs(a[k] - b[k]));
+        flipped = std::max(flipped, std::fabs(a[k] + b[k]));
+    }
+    return std::min(same, flipped);
+}
+
+struct Random {
+    std::mt19937 rng{ 1234 };
+
+    f32 range(f32 a, f32 b) { return std::uniform_real_distribution<f32>(a, b)(rng); }
+    vec3 vector(f32 a, f32 b) { return { range(a, b), range(a, b), range(a, b) }; }
+    quat rotation() { return glm::normalize(quat(range(-1, 1), range(-1, 1), range(-1, 1), range(-1, 1))); }
+
+    // Affine matrix with a non-uniform scale, the shape the transform system feeds in
+    mat4 affine() {
+        return glm::translate(mat4(1.0f), vector(-20, 20)) * glm::mat4_cast(rotation()) * glm::scale(mat4(1.0f), vector(0.25f, 3.0f));
+    }
+};
+
+static void test_compose_trs(const char* level, size_t count, Random& random) {
+    vector<vec3> positions(count), scales(count);
+    vector<quat> rotations(count);
+    SIMD::TRSBuffer trs;
+    SIMD::AffineBuffer models;
+    trs.Resize(count);
+    models.Resize(count);
+    for (size_t i = 0; i < count; i++) {
+        positions[i] = random.vector(-50, 50);
+        rotations[i] = random.rotation();
+        scales[i] = random.vector(0.1f, 4.0f);
+        trs.Set(i, positions[i], rotations[i], scales[i]);
+    }
+
+    SIMD::ComposeTRS(trs.Arrays(), models.Arrays(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        const mat4 expected = glm::translate(mat4(1.0f), positions[i]) * glm::mat4_cast(rotations[i]) * glm::scale(mat4(1.0f), scales[i]);
+        const f32 error = max_error(models.Get(i), expected);
+        check(error < 1e-4f, level, "ComposeTRS", count, i, error);
+    }
+}
+
+static void test_multiply_affine(const char* level, size_t count, Random& random) {
+    vector<mat4> parents(count), locals(count);
+    SIMD::AffineBuffer parentBuffer, localBuffer, out;
+    parentBuffer.Resize(count);
+    localBuffer.Resize(count);
+    out.Resize(count);
+    for (size_t i = 0; i < count; i++) {
+        parents[i] = random.affine();
+        locals[i] = random.affine();
+        parentBuffer.Set(i, parents[i]);
+        localBuffer.Set(i, locals[i]);
+    }
+
+    SIMD::MultiplyAffine(parentBuffer.Arrays(), localBuffer.Arrays(), out.Arrays(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        const mat4 expected = parents[i] * locals[i];
+        const f32 error = max_error(out.Get(i), expected);
+        check(error < 1e-3f, level, "MultiplyAffine", count, i, error);
+    }
+}
+
+static void test_transform_spheres(const char* level, size_t count, Random& random) {
+    vector<mat4> models(count);
+    SIMD::AffineBuffer modelBuffer;
+    SIMD::SphereBuffer spheres, out;
+    modelBuffer.Resize(count);
+    spheres.Resize(count);
+    out.Resize(count);
+    for (size_t i = 0; i < count; i++) {
+        models[i] = random.affine();
+        modelBuffer.Set(i, models[i]);
+        spheres.Set(i, random.vector(-5, 5), random.range(0.1f, 10.0f));
+    }
+
+    SIMD::TransformSpheres(modelBuffer.Arrays(), spheres.Arrays(), out.Arrays(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        const mat4& m = models[i];
+        const vec3 center = vec3(m * vec4(spheres.Center(i), 1.0f));
+        const f32 scale = std::max({ glm::length(vec3(m[0])), glm::length(vec3(m[1])), glm::length(vec3(m[2])) });
+        const f32 radius = spheres.Radius(i) * scale;
+
+        const vec3 c = out.Center(i);
+        const f32 centerError = std::max({ std::fabs(c.x - center.x), std::fabs(c.y - center.y), std::fabs(c.z - center.z) });
+        check(centerError < 1e-3f, level, "TransformSpheres center", count, i, centerError);
+        const f32 radiusError = std::fabs(out.Radius(i) - radius);
+        check(radiusError < 1e-3f, level, "TransformSpheres radius", count, i, radiusError);
+    }
+}
+
+enum class SlerpCase { Random, NearlyIdentical, OppositeHemisphere };
+
+static void test_slerp_quats(const char* level, const char* what, SlerpCase which, size_t count, Random& random) {
+    vector<quat> as(count), bs(count);
+    vector<f32> ts(count);
+    SIMD::QuatBuffer a, b, out;
+    a.Resize(count);
+    b.Resize(count);
+    out.Resize(count);
+    for (size_t i = 0; i < count; i++) {
+        as[i] = random.rotation();
+        switch (which) {
+        case SlerpCase::Random:
+            bs[i] = random.rotation();
+            break;
+        case SlerpCase::NearlyIdentical:
+            // Inside glm's lerp fallback, the angle is too small for sin() to divide by
+            bs[i] = glm::normalize(quat(as[i].w + 1e-6f, as[i].x, as[i].y - 1e-6f, as[i].z));
+            break;
+        case SlerpCase::OppositeHemisphere: {
+            // Negative dot, both sides have to flip b to stay on the short arc
+            const quat other = random.rotation();
+            bs[i] = glm::dot(as[i], other) > 0.0f ? -other : other;
+        } break;
+        }
+        // Ends of the range exactly, the rest anywhere in between
+        ts[i] = (i % 5 == 0) ? 0.0f : (i % 5 == 1) ? 1.0f : random.range(0.0f, 1.0f);
+        a.Set(i, as[i]);
+        b.Set(i, bs[i]);
+    }
+
+    SIMD::SlerpQuats(a.Arrays(), b.Arrays(), ts.data(), out.Arrays(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        const quat expected = glm::slerp(as[i], bs[i], ts[i]);
+        const f32 error = max_error(out.Get(i), expected);
+        check(error < 1e-4f, level, what, count, i, error);
+    }
+}
+
+int main() {
+    const SIMD::Level supported = SIMD::GetSupportedLevel();
+    for (SIMD::Level level : { SIMD::Level::Scalar, SIMD::Level::SSE4, SIMD::Level::AVX2 }) {
+        const char* name = SIMD::GetLevelName(level);
+        if (level > supported) {
+            std::printf("%s: not supported by this CPU, skipped\n", name);
+            continue;
+        }
+
+        SIMD::SetLevel(level);
+        if (SIMD::GetLevel() != level) {
+            std::printf("  FAIL [%s] SetLevel didn't stick, running %s\n", name, SIMD::GetLevelName(SIMD::GetLevel()));
+            s_Failures++;
+            continue;
+        }
+
+        const u32 failuresBefore = s_Failures;
+        Random random;
+        for (size_t count : COUNTS) {
+            test_compose_trs(name, count, random);
+            test_multiply_affine(name, count, random);
+            test_transform_spheres(name, count, random);
+            test_slerp_quats(name, "SlerpQuats", SlerpCase::Random, count, random);
+            test_slerp_quats(name, "SlerpQuats nearly identical", SlerpCase::NearlyIdentical, count, random);
+            test_slerp_quats(name, "SlerpQuats opposite hemisphere", SlerpCase::OppositeHemisphere, count, random);
+        }
+        std::printf("%s: %s\n", name, s_Failures == failuresBefore ? "ok" : "FAILED");
+    }
+
+    SIMD::SetLevel(supported);
+    return (int)std::min<u32>(s_Failures, 255);
+}
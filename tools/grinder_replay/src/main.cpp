@@ -0,0 +1,330 @@
+#include <engine/engine.hpp>
+#include <engine/log.hpp>
+#include <engine/exception.hpp>
+#include <engine/vfs.hpp>
+#include <engine/application.hpp>
+#include <engine/types.hpp>
+#include <engine/ecs.hpp>
+#include <engine/render_capture.hpp>
+
+#include <GLFW/glfw3.h>
+
+#include <charconv>
+#include <cstring>
+
+// Plays a renderer capture (runtime --capture) back through the renderer in a loop and reports
+// CPU and GPU time per pass, no scene module or ECS content involved
+
+static void walk_cwd_to_project_root() {
+    const std::string root_name = "grinder";
+    std::filesystem::path cwd = std::filesystem::current_path();
+    while (cwd.stem().filename() != root_name) {
+        cwd = cwd.parent_path();
+    }
+    std::filesystem::current_path(cwd);
+}
+
+struct ReplayOptions {
+    std::filesystem::path capture;
+    std::filesystem::path statsFile;
+    Engine::u32 loops = 100;
+    Engine::u32 warmup = 10; // frames, not timed
+    bool nullBackend = false;
+};
+
+// Numeric flag values, a malformed or out of range one is reported and leaves the default alone
+template<typename T>
+static void parse_number(const std::string& flag, const char* text, T& value) {
+    const char* end = text + std::strlen(text);
+    T parsed{};
+    const auto [last, error] = std::from_chars(text, end, parsed);
+    if (error != std::errc() || last != end) {
+        Engine::Log::warn("Ignoring {} {}, not a valid number", flag, text);
+        return;
+    }
+    value = parsed;
+}
+
+// <capture> [--loops <n>] [--warmup <frames>] [--null] [--stats <file.csv|file.json>]
+static ReplayOptions parse_args(int argc, char** argv) {
+    ReplayOptions options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--loops" && hasValue) {
+            parse_number(arg, argv[++i], options.loops);
+            options.loops = std::max<Engine::u32>(1, options.loops);
+        }
+        else if (arg == "--warmup" && hasValue) {
+            parse_number(arg, argv[++i], options.warmup);
+        }
+        else if (arg == "--null") {
+            options.nullBackend = true;
+        }
+        else if (arg == "--stats" && hasValue) {
+            options.statsFile = argv[++i];
+        }
+        else if (options.capture.empty() && arg.rfind("--", 0) != 0) {
+            options.capture = arg;
+        }
+        else {
+            Engine::Log::warn("Unknown argument {}", arg);
+        }
+    }
+    return options;
+}
+
+namespace Engine {
+    class CaptureReplayLayer : public ILayer {
+    public:
+        CaptureReplayLayer(RenderCapture&& capture, const ReplayOptions& options)
+            : ILayer("CaptureReplay"), m_Capture{ std::move(capture) }, m_Options{ options } {}
+
+        void OnAttach() override {
+            Ref<ResourceSystem> rs = Application::Get().GetResourceSystem();
+            Renderer& renderer = *Application::Get().GetRenderer();
+
+            // Everything the capture references up front, so loading never lands in a timed frame
+            m_Drawables.resize(m_Capture.models.size());
+            for (size_t i = 0; i < m_Capture.models.size(); i++) {
+                const RenderCapture::ModelSource& source = m_Capture.models[i];
+                if (source.file.empty() || !std::filesystem::exists(source.file)) {
+                    Log::warn("Capture references missing model '{}', its instances are skipped", source.file.string());
+                    m_Models.push_back(nullptr);
+                    continue;
+                }
+                // Same config as the capturing scene, static_mesh alone changes the mesh and collection layout
+                Ref<Model> model = rs->load<Model>(source.file, source.cfg);
+                for (u32 c = 0; c < (u32)model->collections.size(); c++)
+                    m_Drawables[i].push_back(Component::Drawable3D{ model, c });
+                m_Models.push_back(model);
+            }
+            ValidateInstances();
+
+            // Lights queued without an entity are keyed by address, give each one a fixed home
+            u32 sources = 0;
+            for (const RenderCapture::Frame& frame : m_Capture.frames) {
+                for (const RenderCapture::Light& light : frame.lights) {
+                    if (light.entity == null) sources = std::max(sources, light.source + 1);
+                }
+                for (const RenderCapture::Instance& instance : frame.instances) {
+                    if (instance.entity != null) m_Entities.push_back(instance.entity);
+                }
+            }
+            m_SourceLights.resize(sources);
+            std::sort(m_Entities.begin(), m_Entities.end());
+            m_Entities.erase(std::unique(m_Entities.begin(), m_Entities.end()), m_Entities.end());
+
+            renderer.SetTransparencyMode(m_Capture.transparencyMode);
+            renderer.SetPassTimingEnabled(true);
+            if (m_Options.nullBackend) renderer.SetBackend(RHI::BackendType::Null);
+
+            Log::info("Replaying {} frames x {} loops ({} warmup frames), {} models",
+                m_Capture.frames.size(), m_Options.loops, m_Options.warmup, m_Capture.models.size());
+        }
+
+        void OnRender(const std::vector<entity_id>& updatedEntities) override {
+            if (m_Done) return;
+            using clock = std::chrono::steady_clock;
+            Renderer& renderer = *Application::Get().GetRenderer();
+
+            const u32 frameIndex = m_Frame % (u32)m_Capture.frames.size();
+            const RenderCapture::Frame& frame = m_Capture.frames[frameIndex];
+
+            auto start = clock::now();
+            QueueFrame(renderer, frame, frameIndex == 0);
+            auto queued = clock::now();
+            renderer.Draw();
+            auto drawn = clock::now();
+            renderer.Clear();
+
+            if (m_Frame++ < m_Options.warmup) return;
+
+            const f32 queueMs = std::chrono::duration<f32, std::milli>(queued - start).count();
+            const f32 drawMs = std::chrono::duration<f32, std::milli>(drawn - queued).count();
+            const Renderer::Stats& stats = renderer.GetStats().front();
+            m_Totals.frames++;
+            m_Totals.queueMs += queueMs;
+            m_Totals.drawMs += drawMs;
+            m_Totals.drawMsMin = std::min(m_Totals.drawMsMin, drawMs);
+            m_Totals.drawMsMax = std::max(m_Totals.drawMsMax, drawMs);
+            m_Totals.gpuFrameMs += stats.gpuFrameMs;
+            m_Totals.drawCalls += stats.drawCalls + stats.instancedDrawCalls;
+            m_Totals.rhiCommands += stats.rhiCommands;
+            for (size_t pass = 0; pass < (size_t)RenderPass::Count; pass++) {
+                m_Totals.passCpuMs[pass] += stats.passCpuMs[pass];
+                m_Totals.passGpuMs[pass] += stats.passGpuMs[pass];
+            }
+
+            if (m_Totals.frames >= (u64)m_Options.loops * m_Capture.frames.size()) {
+                Report(renderer);
+                m_Done = true;
+                glfwSetWindowShouldClose(Application::Get().GetWindow().GetNativeWindow(), GLFW_TRUE);
+            }
+        }
+
+    private:
+        struct Totals {
+            u64 frames = 0;
+            f64 queueMs = 0.0;
+            f64 drawMs = 0.0;
+            f32 drawMsMin = std::numeric_limits<f32>::max();
+            f32 drawMsMax = 0.0f;
+            f64 gpuFrameMs = 0.0;
+            u64 drawCalls = 0;
+            u64 rhiCommands = 0;
+            f64 passCpuMs[(size_t)RenderPass::Count] = {};
+            f64 passGpuMs[(size_t)RenderPass::Count] = {};
+        };
+
+        void QueueFrame(Renderer& renderer, const RenderCapture::Frame& frame, bool firstFrame) {
+            // Views, the camera pointers have to outlive Draw
+            renderer.ClearViews();
+            m_ViewTransforms.resize(frame.views.size());
+            m_Cameras.resize(frame.views.size());
+            for (size_t i = 0; i < frame.views.size(); i++) {
+                m_ViewTransforms[i].modelMatrix = frame.views[i].world;
+                m_Cameras[i] = frame.views[i].camera;
+                renderer.AddView(&m_ViewTransforms[i], &m_Cameras[i], frame.views[i].viewport);
+            }
+
+            // Wrapping around jumps back in time, every resident instance moved as far as the renderer can tell
+            renderer.MarkTransformsUpdated(firstFrame ? m_Entities : frame.updated);
+
+            m_LightTransforms.resize(frame.lights.size());
+            m_EntityLights.resize(frame.lights.size());
+            for (size_t i = 0; i < frame.lights.size(); i++) {
+                const RenderCapture::Light& captured = frame.lights[i];
+                Component::Light& light = captured.entity == null ? m_SourceLights[captured.source] : m_EntityLights[i];
+                light = captured.light;
+                m_LightTransforms[i].modelMatrix = captured.world;
+                renderer.QueueLight(&m_LightTransforms[i], &light, captured.entity);
+            }
+
+            m_InstanceTransforms.resize(frame.instances.size());
+            for (size_t i = 0; i < frame.instances.size(); i++) {
+                const RenderCapture::Instance& instance = frame.instances[i];
+                Model* model = m_Models[instance.model].get();
+                if (!model) continue;
+
+                Component::WorldTransform& transform = m_InstanceTransforms[i];
+                transform.modelMatrix = instance.world;
+                switch (instance.kind) {
+                case RenderCapture::InstanceKind::Mesh:
+                    renderer.Queue(&transform, &model->meshes[instance.mesh], &model->materials[instance.material]);
+                    break;
+                case RenderCapture::InstanceKind::Drawable:
+                    renderer.QueueDrawable3D(&transform, &m_Drawables[instance.model][instance.mesh], instance.entity);
+                    break;
+                case RenderCapture::InstanceKind::Quantized:
+                    renderer.QueueDrawable3DQuantized(&instance.local, &transform, &m_Drawables[instance.model][instance.mesh]);
+                    break;
+                }
+            }
+        }
+
+        // An index outside of what the model loaded as means the file changed since the capture,
+        // replaying only part of the frame would report numbers for a different scene
+        void ValidateInstances() const {
+            for (size_t f = 0; f < m_Capture.frames.size(); f++) {
+                for (const RenderCapture::Instance& instance : m_Capture.frames[f].instances) {
+                    const Model* model = m_Models[instance.model].get();
+                    if (!model) continue;
+
+                    const bool valid = instance.kind == RenderCapture::InstanceKind::Mesh
+                        ? instance.mesh < model->meshes.size() && instance.material < model->materials.size()
+                        : instance.mesh < model->collections.size();
+                    if (!valid) {
+                        ENGINE_THROW(fmt::format("Capture frame {} references mesh {} / material {} of '{}', which loaded with {} meshes, "
+                            "{} materials and {} collections. The model changed since the capture was taken",
+                            f, instance.mesh, instance.material, m_Capture.models[instance.model].file.string(),
+                            model->meshes.size(), model->materials.size(), model->collections.size()));
+                    }
+                }
+            }
+        }
+
+        void Report(const Renderer& renderer) const {
+            const f64 frames = (f64)m_Totals.frames;
+            Log::info("Render replay: {} timed frames on the {} backend", m_Totals.frames, RHI::GetBackendName(renderer.GetBackendType()));
+            Log::info("  queue        {:8.3f} ms", m_Totals.queueMs / frames);
+            Log::info("  draw (cpu)   {:8.3f} ms  min {:.3f}  max {:.3f}", m_Totals.drawMs / frames, m_Totals.drawMsMin, m_Totals.drawMsMax);
+            Log::info("  frame (gpu)  {:8.3f} ms", m_Totals.gpuFrameMs / frames);
+            Log::info("  draw calls   {:8.1f}, rhi commands {:.1f}", m_Totals.drawCalls / frames, m_Totals.rhiCommands / frames);
+            Log::info("  {:<12} {:>8} {:>8}", "pass", "cpu ms", "gpu ms");
+            for (size_t pass = 0; pass < (size_t)RenderPass::Count; pass++) {
+                Log::info("  {:<12} {:8.3f} {:8.3f}", Renderer::GetPassName((RenderPass)pass),
+                    m_Totals.passCpuMs[pass] / frames, m_Totals.passGpuMs[pass] / frames);
+            }
+        }
+
+        RenderCapture m_Capture;
+        ReplayOptions m_Options;
+        vector<Ref<Model>> m_Models; // by capture model index, null when missing
+        vector<vector<Component::Drawable3D>> m_Drawables; // by model, by collection
+        vector<entity_id> m_Entities; // every entity with resident instances
+
+        vector<Component::WorldTransform> m_ViewTransforms;
+        vector<Component::Camera> m_Cameras;
+        vector<Component::WorldTransform> m_LightTransforms;
+        vector<Component::Light> m_EntityLights;
+        vector<Component::Light> m_SourceLights;
+        vector<Component::WorldTransform> m_InstanceTransforms;
+
+        u32 m_Frame = 0;
+        Totals m_Totals;
+        bool m_Done = false;
+    };
+}
+
+int main(int argc, char** argv) {
+    using namespace Engine;
+
+    // Paths on the command line are relative to where we got started from, not the project root
+    const std::filesystem::path launch_dir = std::filesystem::current_path();
+    walk_cwd_to_project_root();
+
+    engine_initialize();
+
+    ReplayOptions options = parse_args(argc, argv);
+    if (options.capture.empty()) {
+        Log::error("Usage: grinder_replay <capture> [--loops <n>] [--warmup <frames>] [--null] [--stats <file.csv|file.json>]");
+        return 1;
+    }
+    options.capture = launch_dir / options.capture;
+    if (!options.statsFile.empty()) options.statsFile = launch_dir / options.statsFile;
+
+    RenderCapture capture;
+    if (!capture.Load(options.capture) || capture.frames.empty()) {
+        Log::error("Failed to load render capture {}", options.capture.string());
+        return 1;
+    }
+
+    const WindowProps props{
+        "Grinder Replay",
+        1600, 900, false
+    };
+
+    // Same ordering as the runtime, the window holds the GL context and goes last
+    Ref<Window> window = MakeRef<Window>(props);
+    {
+        Ref<VFS> vfs = MakeRef<VFS>();
+        vfs->AddResourcePath(Engine::VFS::GetCurrentModuleName(), "engine");
+        Ref<ECS> ecs = MakeRef<ECS>();
+        Ref<ResourceSystem> rs = MakeRef<ResourceSystem>();
+        {
+            Engine::Application app(window, vfs, rs, ecs);
+            // Per frame table of the renderer stats and pass timings
+            if (!options.statsFile.empty()) {
+                ReplayConfig stats;
+                stats.statsFile = options.statsFile;
+                app.GetReplay().Configure(stats);
+            }
+
+            app.PushLayer(static_cast<ILayer*>(new CaptureReplayLayer(std::move(capture), options)));
+            app.Run();
+        }
+    }
+
+    return 0;
+}